@@ -80,6 +80,8 @@ Glib::PropertyProxy<bool> config_global::property_profile_remember()
 
 Glib::PropertyProxy<Glib::ustring> config_global::property_video_default_device()
 { return m_property_video_default_device.get_proxy(); }
+Glib::PropertyProxy<bool> config_global::property_audio_low_latency()
+{ return m_property_audio_low_latency.get_proxy(); }
 
 
 template<size_t I = 0, typename Func, typename ...Ts>
@@ -100,7 +102,10 @@ config_global::config_global():
 
     m_property_theme_color(*this, "config-theme-color", 0),
     m_property_profile_remember(*this, "config-profile-remember", false),
-    m_property_video_default_device(*this, "config-video-default-device")
+    m_property_video_default_device(*this, "config-video-default-device"),
+    m_property_audio_low_latency(*this, "config-audio-low-latency", false),
+
+    m_writer(m_config_file, [this]() { return save_flatbuffer(); })
 {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
     load_flatbuffer();
@@ -110,10 +115,11 @@ config_global::config_global():
                           property_theme_color(),
                           property_theme_color(),
                           property_profile_remember(),
-                          property_video_default_device()),
+                          property_video_default_device(),
+                          property_audio_low_latency()),
                       [this](auto property) {
         property.signal_changed().connect(sigc::track_obj([this]() {
-            this->save_flatbuffer();
+            m_writer.changed();
         }, *this));
     });
 }
@@ -137,7 +143,9 @@ config::config(Glib::ustring config_file):
     m_property_window_x(*this, "config-window-x", -1),
     m_property_window_y(*this, "config-window-y", -1),
     m_property_window_w(*this, "config-window-w", -1),
-    m_property_window_h(*this, "config-window-h", -1)
+    m_property_window_h(*this, "config-window-h", -1),
+
+    m_writer(m_config_file, [this]() { return save_flatbuffer(); })
 {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), { config_file.raw() });
     load_flatbuffer();
@@ -162,11 +170,21 @@ config::config(Glib::ustring config_file):
                           property_window_h()),
                       [this](auto property) {
         property.signal_changed().connect(sigc::track_obj([this]() {
-            this->save_flatbuffer();
+            m_writer.changed();
         }, *this));
     });
 }
 
+utils::config_writer::batch config::batch() {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    return utils::config_writer::batch(m_writer);
+}
+
+utils::config_writer::batch config_global::batch() {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    return utils::config_writer::batch(m_writer);
+}
+
 class config_global& config::global() {
     utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
     static class config_global global;
@@ -176,7 +194,9 @@ class config_global& config::global() {
 void config::load_flatbuffer() {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
     if (!Glib::file_test(m_config_file, Glib::FILE_TEST_IS_REGULAR)) {
-        save_flatbuffer();
+        //keep the defaults and write them
+        m_writer.changed();
+        return;
     }
     auto file = Gio::File::create_for_path(m_config_file);
     auto stream = file->read();
@@ -211,7 +231,7 @@ void config::load_flatbuffer() {
     property_window_h() = conf->window_h();
 }
 
-void config::save_flatbuffer() {
+std::vector<uint8_t> config::save_flatbuffer() {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
     flatbuffers::FlatBufferBuilder fbb;
 
@@ -240,24 +260,16 @@ void config::save_flatbuffer() {
 
     flatbuffers::Config::FinishConfigBuffer(fbb, builder.Finish());
 
-    //write to file
-    auto file = Gio::File::create_for_path(m_config_file);
-    auto parent = file->get_parent();
-    if (parent) {
-        if (!Glib::file_test(parent->get_path(), Glib::FILE_TEST_IS_DIR)) {
-            parent->make_directory_with_parents();
-        }
-    }
-    auto stream = file->replace();
-    stream->truncate(0);
-    stream->write_bytes(Glib::Bytes::create(fbb.GetBufferPointer(), fbb.GetSize()));
-    stream->close();
+    return std::vector<uint8_t>(fbb.GetBufferPointer(),
+                                fbb.GetBufferPointer() + fbb.GetSize());
 }
 
 void config_global::load_flatbuffer() {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
     if (!Glib::file_test(m_config_file, Glib::FILE_TEST_IS_REGULAR)) {
-        save_flatbuffer();
+        //keep the defaults and write them
+        m_writer.changed();
+        return;
     }
     auto file = Gio::File::create_for_path(m_config_file);
     auto stream = file->read();
@@ -277,9 +289,11 @@ void config_global::load_flatbuffer() {
     property_video_default_device() = std::string(
                                           conf->av_video_default()->begin(),
                                           conf->av_video_default()->end());
+
+    property_audio_low_latency() = conf->av_audio_low_latency();
 }
 
-void config_global::save_flatbuffer() {
+std::vector<uint8_t> config_global::save_flatbuffer() {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
     flatbuffers::FlatBufferBuilder fbb;
 
@@ -291,18 +305,10 @@ void config_global::save_flatbuffer() {
 
     builder.add_av_video_default(video_default);
 
+    builder.add_av_audio_low_latency(property_audio_low_latency());
+
     flatbuffers::Config::FinishGlobalBuffer(fbb, builder.Finish());
 
-    //write to file
-    auto file = Gio::File::create_for_path(m_config_file);
-    auto parent = file->get_parent();
-    if (parent) {
-        if (!Glib::file_test(parent->get_path(), Glib::FILE_TEST_IS_DIR)) {
-            parent->make_directory_with_parents();
-        }
-    }
-    auto stream = file->replace();
-    stream->truncate(0);
-    stream->write_bytes(Glib::Bytes::create(fbb.GetBufferPointer(), fbb.GetSize()));
-    stream->close();
+    return std::vector<uint8_t>(fbb.GetBufferPointer(),
+                                fbb.GetBufferPointer() + fbb.GetSize());
 }
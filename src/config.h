@@ -20,6 +20,7 @@
 #define GTOX_CONFIG_H
 #include <glibmm.h>
 #include "utils/debug.h"
+#include "utils/config_writer.h"
 
 class config_global: public Glib::Object, public utils::debug::track_obj<config_global> {
         friend class config;
@@ -30,11 +31,16 @@ class config_global: public Glib::Object, public utils::debug::track_obj<config_
 
         Glib::PropertyProxy<Glib::ustring> property_video_default_device();
 
+        Glib::PropertyProxy<bool> property_audio_low_latency();
+
+        //! changes made while the batch lives are saved together
+        utils::config_writer::batch batch();
+
     private:
         config_global();
 
         void load_flatbuffer();
-        void save_flatbuffer();
+        std::vector<uint8_t> save_flatbuffer();
 
         std::string m_config_file;
 
@@ -43,6 +49,11 @@ class config_global: public Glib::Object, public utils::debug::track_obj<config_
         Glib::Property<bool> m_property_profile_remember;
 
         Glib::Property<Glib::ustring> m_property_video_default_device;
+
+        Glib::Property<bool> m_property_audio_low_latency;
+
+        //last, it reads the properties when destroyed
+        utils::config_writer m_writer;
 };
 
 class config: public Glib::Object {
@@ -72,9 +83,12 @@ class config: public Glib::Object {
 
         static config_global& global();
 
+        //! changes made while the batch lives are saved together
+        utils::config_writer::batch batch();
+
     private:
         void load_flatbuffer();
-        void save_flatbuffer();
+        std::vector<uint8_t> save_flatbuffer();
 
         std::string m_config_file;
 
@@ -98,6 +112,9 @@ class config: public Glib::Object {
         Glib::Property<int> m_property_window_y;
         Glib::Property<int> m_property_window_w;
         Glib::Property<int> m_property_window_h;
+
+        //last, it reads the properties when destroyed
+        utils::config_writer m_writer;
 };
 
 #endif
@@ -29,11 +29,15 @@
 #include "tox/contact/file/file.h"
 #include "tox/contact/manager.h"
 #include "flatbuffers/flatbuffers.h"
-#include "flatbuffers/idl.h"
-#include "flatbuffers/util.h"
 #include "tox/contact/call.h"
 #include "widget/imagescaled.h"
 #include "tox/exception.h"
+#include "utils/scroll_benchmark.h"
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <limits>
 
 #ifndef SIGC_CPP11_HACK
 #define SIGC_CPP11_HACK
@@ -43,6 +47,31 @@ namespace sigc {
 #endif
 using namespace dialog;
 
+namespace {
+    //drops the 0xFDD0/0xFDD1 formatting tags widget::chat_input adds
+    std::string strip_format(const std::string& text) {
+        static const std::string marker_open = "\xEF\xB7\x90";
+        static const std::string marker_close = "\xEF\xB7\x91";
+        std::string res;
+        res.reserve(text.size());
+        size_t pos = 0;
+        while (pos < text.size()) {
+            auto open = text.find(marker_open, pos);
+            auto close = text.find(marker_close, pos);
+            auto marker = std::min(open, close);
+            if (marker == std::string::npos) {
+                res.append(text, pos, std::string::npos);
+                break;
+            }
+            res.append(text, pos, marker - pos);
+            //the tag ends with the other marker
+            auto end = text.find(marker == open ? marker_close : marker_open, marker + 3);
+            pos = end == std::string::npos ? text.size() : end + 3;
+        }
+        return res;
+    }
+}
+
 chat::chat(std::shared_ptr<toxmm::core> core,
            std::shared_ptr<toxmm::contact> contact,
            std::shared_ptr<class config> config,
@@ -74,6 +103,10 @@ chat::chat(std::shared_ptr<toxmm::core> core,
     builder.get_widget("headerbar_buttons", m_headerbar_buttons);
     builder.get_widget("av_area", m_av_area);
     builder.get_widget("incoming_call_revealer", m_incoming_call_revealer);
+    builder.get_widget("history_searchbar", m_history_searchbar);
+    builder.get_widget("history_search", m_history_search);
+    builder.get_widget("history_results", m_history_results);
+    builder.get_widget("btn_search", m_history_toggle);
 
     m_image_webcam_local  = builder.get_widget_derived<widget::imagescaled>("image_webcam_local");
     m_image_webcam_remote = builder.get_widget_derived<widget::imagescaled>("image_webcam_remote");
@@ -98,6 +131,39 @@ chat::chat(std::shared_ptr<toxmm::core> core,
         return true;
     }));
 
+    //history search
+    m_history_searchbar->connect_entry(*m_history_search);
+    m_bindings.push_back(Glib::Binding::bind_property(m_history_toggle->property_active(),
+                                                      m_history_searchbar->property_search_mode_enabled(),
+                                                      Glib::BINDING_BIDIRECTIONAL | Glib::BINDING_SYNC_CREATE));
+    m_history_searchbar->property_search_mode_enabled().signal_changed().connect(sigc::track_obj([this]() {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        if (m_history_searchbar->get_search_mode() || !m_history_shown) {
+            return;
+        }
+        //back to the latest lines
+        clear_log();
+        m_history_shown = false;
+        m_autoscroll = true;
+        load_log();
+    }, *this));
+    m_history_search->signal_search_changed().connect(sigc::track_obj([this]() {
+        update_history_search();
+    }, *this));
+    m_history_search->signal_activate().connect(sigc::track_obj([this]() {
+        auto row = m_history_results->get_row_at_index(0);
+        if (row) {
+            row->activate();
+        }
+    }, *this));
+    m_history_results->signal_row_activated().connect(sigc::track_obj([this](Gtk::ListBoxRow* row) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        auto index = row->get_index();
+        if (index >= 0 && size_t(index) < m_history_hits.size()) {
+            load_log_at(m_history_hits[index]);
+        }
+    }, *this));
+
     m_input->signal_key_press_event().connect(sigc::track_obj([this](GdkEventKey* event) {
         utils::debug::scope_log log(DBG_LVL_3("gtox"), {});
         auto text_buffer = m_input->get_buffer();
@@ -105,6 +171,8 @@ chat::chat(std::shared_ptr<toxmm::core> core,
             if (text_buffer->begin() != text_buffer->end()) {
                  bool allow_send = text_buffer->get_text().find_first_not_of(" \t\n\v\f\r") != std::string::npos;
                  if (allow_send) {
+                     //the answer belongs below the latest lines
+                     m_history_searchbar->set_search_mode(false);
                      if (Glib::str_has_prefix(text_buffer->get_text(), "/me ")) {
                          m_contact->send_action(m_input->get_serialized_text().substr(4));
                      } else {
@@ -217,11 +285,8 @@ chat::chat(std::shared_ptr<toxmm::core> core,
         from_x = event->x;
         from_y = event->y;
 
-        // update all children, reset selection
-        GdkEventMotion dummy_event;
-        dummy_event.x = from_x;
-        dummy_event.y = from_y;
-        update_children(&dummy_event, m_chat_box->get_children());
+        // reset selection
+        update_selection(from_x, from_y);
 
         m_eventbox->grab_focus();
 
@@ -241,8 +306,7 @@ chat::chat(std::shared_ptr<toxmm::core> core,
         if (from_x < 0 && from_y < 0) {
             return false;
         }
-        // update all children
-        update_children(event, m_chat_box->get_children());
+        update_selection(event->x, event->y);
         return true;
     }, *this));
     m_eventbox->signal_key_press_event().connect(sigc::track_obj([this](GdkEventKey* event) {
@@ -250,12 +314,21 @@ chat::chat(std::shared_ptr<toxmm::core> core,
         if (!(event->state & GDK_CONTROL_MASK)) {
             return false;
         }
+        if (event->keyval == 'f') {
+            m_history_searchbar->set_search_mode(true);
+            return true;
+        }
         if (event->keyval != 'c') {
             return false;
         }
 
         // copy to clipboard
-        auto data = get_children_selection(m_chat_box->get_children());
+        std::string data;
+        update_selection_rows();
+        auto rows = selection_rows(m_selection_top, m_selection_bottom);
+        for (auto row = rows.first; row != rows.second; ++row) {
+            get_children_selection(row->widget, data);
+        }
         Gtk::Clipboard::get()->set_text(data);
         return true;
     }, *this));
@@ -269,9 +342,32 @@ chat::chat(std::shared_ptr<toxmm::core> core,
         m_autoscroll = adj->get_upper() - adj->get_page_size()
                        == adj->get_value();
     }, *this));
+    //one listener for all bubbles, it only visits the rows in view
+    auto update_timestamps = sigc::track_obj([this]() {
+        update_timestamps();
+    }, *this);
+    m_scrolled->get_vadjustment()->signal_value_changed().connect(update_timestamps);
+    m_scrolled->get_vadjustment()->signal_changed().connect(update_timestamps);
+    m_chat_box->signal_add().connect(sigc::track_obj([this](Gtk::Widget*) {
+        m_selection_rows_dirty = true;
+    }, *this));
+    m_chat_box->signal_remove().connect(sigc::track_obj([this](Gtk::Widget*) {
+        m_selection_rows_dirty = true;
+    }, *this));
     m_chat_box->signal_size_allocate()
             .connect_notify(sigc::track_obj([this](Gtk::Allocation&) {
         utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        m_selection_rows_dirty = true;
+        // scroll to a search result
+        if (m_scroll_to) {
+            int x, y;
+            if (m_scroll_to->translate_coordinates(*m_chat_box, 0, 0, x, y)) {
+                auto adj = m_scrolled->get_vadjustment();
+                adj->set_value(y - (adj->get_page_size() - m_scroll_to->get_allocated_height()) / 2);
+            }
+            m_scroll_to = nullptr;
+            return;
+        }
         // auto scroll:
         if (m_autoscroll) {
             auto adj = m_scrolled->get_vadjustment();
@@ -407,26 +503,28 @@ chat::chat(std::shared_ptr<toxmm::core> core,
             .signal_changed().connect(update_incoming_revealer);
     update_incoming_revealer();
 
-    m_bindings.push_back(Glib::Binding::bind_property(m_webcam.property_pixbuf(),
-                                                         m_contact->call()->property_video_frame(),
-                                                         Glib::BINDING_DEFAULT,
-                                                         [this](const Glib::RefPtr<Gdk::Pixbuf>& in, toxmm::av::image& out) {
-        if (in) {
-            int n = in->property_n_channels();
-            uint8_t* pixels = in->get_pixels();
-
-            size_t size = in->get_width() * in->get_height();
-            out = toxmm::av::image(in->get_width(),
-                                   in->get_height());
-            for (size_t i = 0; i < size; ++i) {
-                out.data()[i] = toxmm::av::pixel(
-                                    pixels[i*n + 0],
-                                    pixels[i*n + 1],
-                                    pixels[i*n + 2]);
-            }
-        }
-        return true;
-    }));
+    auto update_call_capture = sigc::track_obj([this]() {
+        update_call_capture();
+    }, *this);
+    m_webcam.property_device().signal_changed().connect(update_call_capture);
+    m_contact->call()->property_state().signal_changed().connect(update_call_capture);
+    m_contact->call()->property_remote_state().signal_changed().connect(update_call_capture);
+    m_contact->call()->property_video_width().signal_changed().connect(update_call_capture);
+    m_contact->call()->property_video_height().signal_changed().connect(update_call_capture);
+    m_contact->call()->property_video_fps().signal_changed().connect(update_call_capture);
+
+    auto update_call_audio = sigc::track_obj([this]() {
+        update_call_audio();
+    }, *this);
+    m_contact->call()->property_state().signal_changed().connect(update_call_audio);
+    m_contact->call()->property_remote_state().signal_changed().connect(update_call_audio);
+    config::global().property_audio_low_latency().signal_changed().connect(update_call_audio);
+
+    auto update_call_stats = sigc::track_obj([this]() {
+        update_call_stats();
+    }, *this);
+    m_contact->call()->property_state().signal_changed().connect(update_call_stats);
+    m_contact->call()->property_remote_state().signal_changed().connect(update_call_stats);
 
     m_bindings.push_back(Glib::Binding::bind_property(m_webcam.property_pixbuf(),
                                                       m_image_webcam_local->property_pixbuf(),
@@ -467,6 +565,9 @@ chat::chat(std::shared_ptr<toxmm::core> core,
     }));
 
     load_log();
+    rebuild_log_index();
+
+    utils::scroll_benchmark::fill(*this);
 }
 
 chat::~chat() {
@@ -478,73 +579,277 @@ chat::~chat() {
     delete m_body;
 }
 
-void chat::update_children(GdkEventMotion* event,
-                           std::vector<Gtk::Widget*> children) {
+void chat::update_call_capture() {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+    auto call = m_contact->call();
+    auto device = m_webcam.property_device().get_value();
+    if (!device ||
+        call->property_state().get_value() == toxmm::call::CALL_CANCEL ||
+        call->property_remote_state().get_value() == toxmm::call::CALL_CANCEL) {
+        m_call_capture.reset();
+        m_call_handoff.reset();
+        m_call_caps.clear();
+        m_call_device.reset();
+        return;
+    }
+
+    auto caps = Glib::ustring::compose("video/x-raw,format=I420,width=%1,height=%2,"
+                                       "framerate=%3/1,pixel-aspect-ratio=1/1",
+                                       call->property_video_width().get_value(),
+                                       call->property_video_height().get_value(),
+                                       call->property_video_fps().get_value());
+    if (m_call_capture && caps == m_call_caps && device == m_call_device) {
+        return;
+    }
+
+    //holding the capture keeps the pipeline running while the old
+    //branch is dropped, before the new one gets added
+    auto capture = utils::webcam_capture::get(device);
+    m_call_capture.reset();
+    m_call_handoff.reset();
+    m_call_caps.clear();
+    m_call_device.reset();
+    if (!capture) {
+        return;
+    }
+
+    m_call_caps = caps;
+    m_call_device = device;
+    m_call_dropped = 0;
+    m_call_handoff = std::make_shared<utils::handoff<toxmm::av::i420>>(m_dispatcher, [this](toxmm::av::i420 frame) {
+        utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+        auto call = m_contact->call();
+        //frames replaced while the main loop was busy
+        auto dropped = m_call_handoff ? m_call_handoff->dropped() : m_call_dropped;
+        if (dropped != m_call_dropped) {
+            call->report_dropped_video_frames(dropped - m_call_dropped);
+            m_call_dropped = dropped;
+        }
+        call->property_video_frame_i420() = frame;
+    });
+    auto handoff = m_call_handoff;
+    m_call_capture = capture->subscribe(caps, [handoff](GstSample* sample, int, int, gint64 captured) {
+        auto frame = utils::video_frame::wrap_i420(sample, captured);
+        if (!frame.empty()) {
+            handoff->push(frame);
+        }
+    });
+}
+
+void chat::update_call_audio() {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+    auto call = m_contact->call();
+    if (call->property_state().get_value() == toxmm::call::CALL_CANCEL ||
+        call->property_remote_state().get_value() == toxmm::call::CALL_CANCEL) {
+        m_call_playout.reset();
+        m_call_audio.reset();
+        return;
+    }
+
+    //the call starts with a fresh jitter buffer
+    auto buffer = call->audio_playout();
+    if (!m_call_playout || m_call_playout->buffer() != buffer) {
+        m_call_playout.reset();
+        m_call_playout.reset(new utils::audio_playout(buffer));
+    }
+
+    bool low_latency = config::global().property_audio_low_latency();
+    if (!m_call_audio || m_call_audio->low_latency() != low_latency) {
+        m_call_audio.reset();
+        m_call_audio.reset(new utils::audio_capture(m_dispatcher, low_latency,
+                                                    [this](const toxmm::av::audio& frame, gint64) {
+            utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+            m_contact->call()->property_audio_frame() = frame;
+        }));
+    }
+}
+
+void chat::update_call_stats() {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+    //GTOX_DBG_CALL_STATS=<seconds> reports the send path of a running call
+    static const int interval = std::stoi("0" + Glib::getenv("GTOX_DBG_CALL_STATS"));
+    auto call = m_contact->call();
+    if (interval <= 0 ||
+        call->property_state().get_value() == toxmm::call::CALL_CANCEL ||
+        call->property_remote_state().get_value() == toxmm::call::CALL_CANCEL) {
+        m_call_stats.disconnect();
+        return;
+    }
+    if (m_call_stats.connected()) {
+        return;
+    }
+    m_call_stats = Glib::signal_timeout().connect_seconds(sigc::track_obj([this]() {
+        auto call = m_contact->call();
+        std::clog << std::fixed << std::setprecision(2)
+                  << "CALL-STATS: video " << call->property_video_width().get_value()
+                  << "x" << call->property_video_height().get_value()
+                  << "@" << call->property_video_fps().get_value()
+                  << " send latency " << call->property_video_send_latency().get_value() << " ms"
+                  << " send failures " << call->property_video_send_failures().get_value()
+                  << " dropped " << call->property_video_dropped_frames().get_value()
+                  << " audio latency " << call->property_audio_latency().get_value() << " ms"
+                  << " underruns " << call->property_audio_underruns().get_value()
+                  << " overruns " << call->property_audio_overruns().get_value()
+                  << std::endl;
+        return true;
+    }, *this), interval);
+}
+
+void chat::update_timestamps() {
     utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-    for (auto c : children) {
-        // check if it's a container
-        auto c_container = dynamic_cast<Gtk::Container*>(c);
-        if (c_container) {
-            update_children(event, c_container->get_children());
-            continue;
+    int x, top;
+    if (!m_chat_box->get_mapped() ||
+        !m_scrolled->translate_coordinates(*m_chat_box, 0, 0, x, top)) {
+        return;
+    }
+    update_selection_rows();
+    auto rows = selection_rows(top, top + m_scrolled->get_allocated_height());
+    for (auto row = rows.first; row != rows.second; ++row) {
+        auto bubble = dynamic_cast<widget::chat_bubble*>(row->widget);
+        if (bubble && bubble->timestamp_stale()) {
+            bubble->refresh_timestamp();
         }
-        // check if it's WidgetChatMessage
-        auto c_message = dynamic_cast<widget::label*>(c);
-        if (!c_message) {
-            //
-            continue;
+    }
+}
+
+void chat::update_selection_rows() {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+    if (!m_selection_rows_dirty) {
+        return;
+    }
+    m_selection_rows_dirty = false;
+    m_selection_rows.clear();
+    // the rows are stacked, so sorted by y, and share m_chat_box's window
+    auto origin = m_chat_box->get_allocation().get_y();
+    for (auto c : m_chat_box->get_children()) {
+        auto alloc = c->get_allocation();
+        m_selection_rows.push_back({ alloc.get_y() - origin, alloc.get_height(), c });
+    }
+    // rows moved, whatever holds a selection has to be revisited
+    if (m_selection_top <= m_selection_bottom) {
+        m_selection_top = std::numeric_limits<int>::min();
+        m_selection_bottom = std::numeric_limits<int>::max();
+    }
+}
+
+std::pair<std::vector<chat::selection_row>::iterator,
+          std::vector<chat::selection_row>::iterator>
+    chat::selection_rows(int top, int bottom) {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), { top, bottom });
+    if (top > bottom) {
+        return { m_selection_rows.end(), m_selection_rows.end() };
+    }
+    auto first = std::lower_bound(m_selection_rows.begin(), m_selection_rows.end(), top,
+                                  [](const selection_row& row, int y) {
+        return row.y + row.height < y;
+    });
+    auto last = std::upper_bound(first, m_selection_rows.end(), bottom,
+                                 [](int y, const selection_row& row) {
+        return y < row.y;
+    });
+    return { first, last };
+}
+
+void chat::update_selection(int to_x, int to_y) {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), { to_x, to_y });
+    update_selection_rows();
+
+    // rows between anchor and pointer, plus the ones selected before
+    int top = std::min(from_y, to_y);
+    int bottom = std::max(from_y, to_y);
+    if (m_selection_top <= m_selection_bottom) {
+        top = std::min(top, m_selection_top);
+        bottom = std::max(bottom, m_selection_bottom);
+    }
+    auto rows = selection_rows(top, bottom);
+    for (auto row = rows.first; row != rows.second; ++row) {
+        update_children(to_x, to_y, row->widget);
+    }
+
+    m_selection_top = std::min(from_y, to_y);
+    m_selection_bottom = std::max(from_y, to_y);
+    if (from_x == to_x && from_y == to_y) {
+        m_selection_top = 0;
+        m_selection_bottom = -1;
+    }
+}
+
+void chat::update_children(int to_x, int to_y, Gtk::Widget* widget) {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+    // check if it's a container
+    auto c_container = dynamic_cast<Gtk::Container*>(widget);
+    if (c_container) {
+        for (auto c : c_container->get_children()) {
+            update_children(to_x, to_y, c);
+        }
+        return;
+    }
+    // check if it's WidgetChatMessage
+    auto c_message = dynamic_cast<widget::label*>(widget);
+    if (!c_message) {
+        return;
+    }
+    // correct x,y to widget x,y
+    int w_from_x, w_from_y, w_to_x, w_to_y;
+    if (m_chat_box->translate_coordinates(*c_message, from_x, from_y, w_from_x, w_from_y) &&
+        m_chat_box->translate_coordinates(*c_message, to_x, to_y, w_to_x, w_to_y)) {
+
+        // fix order
+        if (w_to_y < w_from_y) {
+            std::swap(w_to_y, w_from_y);
+            std::swap(w_to_x, w_from_x);
         }
-        // correct x,y to widget x,y
-        int w_from_x, w_from_y, w_to_x, w_to_y;
-        int to_x = event->x;
-        int to_y = event->y;
-        if (m_chat_box->translate_coordinates(*c_message, from_x, from_y, w_from_x, w_from_y) &&
-            m_chat_box->translate_coordinates(*c_message, to_x, to_y, w_to_x, w_to_y)) {
-
-            // fix order
-            if (w_to_y < w_from_y) {
-                std::swap(w_to_y, w_from_y);
-                std::swap(w_to_x, w_from_x);
-            }
 
-            // check if within
-            if (w_from_y < c_message->get_allocated_height() && w_to_y > 0) {
-                c_message->on_selection(w_from_x, w_from_y, w_to_x, w_to_y);
-            } else {
-                c_message->on_selection(0, 0, 0, 0);
-            }
+        // check if within
+        if (w_from_y < c_message->get_allocated_height() && w_to_y > 0) {
+            c_message->on_selection(w_from_x, w_from_y, w_to_x, w_to_y);
+        } else {
+            c_message->on_selection(0, 0, 0, 0);
         }
     }
 }
 
-Glib::ustring chat::get_children_selection(
-    std::vector<Gtk::Widget*> children) {
+void chat::get_children_selection(Gtk::Widget* widget, std::string& res) {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
-    Glib::ustring res;
-    Glib::ustring tmp;
-    for (auto c : children) {
-        tmp.clear();
-
-        // check if it's a container
-        auto c_container = dynamic_cast<Gtk::Container*>(c);
-        if (c_container) {
-            tmp = get_children_selection(c_container->get_children());
-        }
-        // check if it's WidgetChatMessage
-        auto c_message = dynamic_cast<widget::label*>(c);
-        if (c_message) {
-            tmp = c_message->get_selection();
-        }
-
-        // add to result
-        if (!tmp.empty()) {
-            if (!res.empty()) {
-                res += '\n';
-            }
-            res += tmp;
+    // check if it's a container
+    auto c_container = dynamic_cast<Gtk::Container*>(widget);
+    if (c_container) {
+        for (auto c : c_container->get_children()) {
+            get_children_selection(c, res);
         }
+        return;
     }
-    return res;
+    // check if it's WidgetChatMessage
+    auto c_message = dynamic_cast<widget::label*>(widget);
+    if (!c_message) {
+        return;
+    }
+    auto tmp = c_message->get_selection();
+    // add to result
+    if (!tmp.empty()) {
+        if (!res.empty()) {
+            res += '\n';
+        }
+        res += tmp.raw();
+    }
+}
+
+bool chat::load_log_day(
+        std::shared_ptr<toxmm::storage> storage,
+        std::shared_ptr<toxmm::contact> contact,
+        const Glib::Date& date,
+        toxmm::log_segment& segment) {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), { date.format_string("%Y-%m-%d").raw() });
+    std::initializer_list<std::string> key = {
+        contact->property_addr_public().get_value(),
+        "log",
+        date.format_string("%Y-%m-%d")
+    };
+
+    std::vector<uint8_t> content;
+    storage->load(key, content);
+    segment.parse(std::move(content));
+    return segment.size() > 0;
 }
 
 void chat::load_log() {
@@ -553,44 +858,39 @@ void chat::load_log() {
     if (!c) {
         return;
     }
-    auto cm = c->contact_manager();
-    if (!cm) {
-        return;
-    }
-
-    std::vector<uint8_t> content;
 
-    //TODO: storage will need a way to list keys..
+    //days to look at, newest first
+    std::vector<Glib::Date> days;
+    auto index = m_contact->log_index();
+    if (index && index->complete()) {
+        auto& indexed = index->days();
+        for (auto day = indexed.rbegin(); day != indexed.rend(); ++day) {
+            days.push_back(Glib::Date(*day));
+        }
+    } else {
+        for (int d = 0; d <= 10; ++d) {
+            auto date = Glib::Date();
+            date.set_time_current();
+            date.subtract_days(d);
+            days.push_back(date);
+        }
+    }
 
     //search logs to load..
+    toxmm::log_segment segment;
     std::deque<std::pair<Glib::Date, int>> log;
     constexpr int max_lines = 100;
-    for (int d = 0; d <= 10 && log.size() < max_lines; ++d) {
-        auto date = Glib::Date();
-        date.set_time_current();
-        date.subtract_days(d);
-
-        std::initializer_list<std::string> key = {
-            m_contact->property_addr_public().get_value(),
-            "log",
-            date.format_string("%Y-%m-%d")
-        };
-
-        content.clear();
-        c->storage()->load(key, content);
-
-        if (content.empty()) {
-            continue;
+    for (auto& date : days) {
+        if (log.size() >= max_lines) {
+            break;
         }
 
-        auto verify = flatbuffers::Verifier(content.data(), content.size());
-        if (!flatbuffers::Log::VerifyCollectionBuffer(verify)) {
-            throw std::runtime_error("flatbuffers::Log::VerifyCollectionBuffer failed");
+        if (!load_log_day(c->storage(), m_contact, date, segment)) {
+            continue;
         }
-        auto data = flatbuffers::Log::GetCollection(content.data());
 
         //add all messages for this day to the chat
-        for (int i = data->items()->size(); i > 0 ; --i) {
+        for (int i = segment.size(); i > 0 ; --i) {
             auto index = i - 1;
             log.push_front({date, index});
             if (log.size() >= max_lines) {
@@ -599,141 +899,358 @@ void chat::load_log() {
         }
     }
 
-    //load the selected lines
+    load_log(log);
+}
+
+void chat::load_log_at(const toxmm::log_index::hit& hit) {
+    utils::debug::scope_log lo(DBG_LVL_1("gtox"), { int(hit.day), int(hit.item) });
+    auto c = m_core.lock();
+    auto index = m_contact->log_index();
+    if (!c || !index) {
+        return;
+    }
+    auto& days = index->days();
+    auto day = std::lower_bound(days.begin(), days.end(), hit.day);
+    if (day == days.end() || *day != hit.day) {
+        return;
+    }
+
+    //lines shown before and after the hit
+    constexpr size_t context = 50;
+    toxmm::log_segment segment;
+    std::deque<std::pair<Glib::Date, int>> log;
+    for (auto d = day; log.size() <= context; --d) {
+        Glib::Date date(*d);
+        if (load_log_day(c->storage(), m_contact, date, segment)) {
+            int last = segment.size() - 1;
+            if (d == day) {
+                last = std::min(last, int(hit.item));
+            }
+            for (int i = last; i >= 0 && log.size() <= context; --i) {
+                log.push_front({date, i});
+            }
+        }
+        if (d == days.begin()) {
+            break;
+        }
+    }
+    auto max_lines = log.size() + context;
+    for (auto d = day; d != days.end() && log.size() < max_lines; ++d) {
+        Glib::Date date(*d);
+        if (!load_log_day(c->storage(), m_contact, date, segment)) {
+            continue;
+        }
+        int first = d == day ? hit.item + 1 : 0;
+        for (int i = first; i < int(segment.size()) && log.size() < max_lines; ++i) {
+            log.push_back({date, i});
+        }
+    }
+
+    clear_log();
+    m_history_shown = true;
+    m_autoscroll = false;
+    load_log(log, { Glib::Date(hit.day), int(hit.item) });
+}
+
+void chat::load_log(const std::deque<std::pair<Glib::Date, int>>& log,
+                    const std::pair<Glib::Date, int>& scroll_to) {
+    utils::debug::scope_log lo(DBG_LVL_1("gtox"), {});
+    auto c = m_core.lock();
+    if (!c) {
+        return;
+    }
+
+    //load the selected lines, only their blocks get decompressed
+    toxmm::log_segment segment;
     Glib::Date last_date;
-    const flatbuffers::Log::Collection* last_data = nullptr;
+    bool loaded = false;
 
-    for (auto l : log) {
+    for (auto& l : log) {
         auto& date  = l.first;
         auto& index = l.second;
 
-        if (!last_data || date != last_date) {
+        if (!loaded || date != last_date) {
             last_date = date;
+            loaded = load_log_day(c->storage(), m_contact, date, segment);
+            if (!loaded) {
+                throw std::runtime_error("Log content is empty now..");
+            }
+        }
 
-            std::initializer_list<std::string> key = {
-                m_contact->property_addr_public().get_value(),
-                "log",
-                date.format_string("%Y-%m-%d")
-            };
+        auto widget = add_log_item(segment, segment.item(index));
+        if (widget && index == scroll_to.second && date == scroll_to.first) {
+            m_scroll_to = widget;
+        }
+    }
+}
 
-            content.clear();
-            c->storage()->load(key, content);
+Gtk::Widget* chat::add_log_item(const toxmm::log_segment& segment,
+                                const flatbuffers::Log::Item* item) {
+    utils::debug::scope_log lo(DBG_LVL_2("gtox"), {});
+    auto c = m_core.lock();
+    if (!c) {
+        return nullptr;
+    }
+    auto cm = c->contact_manager();
+    if (!cm) {
+        return nullptr;
+    }
 
-            if (content.empty()) {
-                throw std::runtime_error("Log content is empty now..");
+    Gtk::Widget* res = nullptr;
+
+    //add message to chat
+    auto time = Glib::DateTime::create_now_utc(item->timestamp());
+    auto sender = segment.address(item->sender());
+    switch (item->data_type()) {
+        case flatbuffers::Log::Data::Message: {
+            auto f = reinterpret_cast<const flatbuffers::Log::Message*>(
+                         item->data());
+            auto contact = cm->find(toxmm::contactAddrPublic(
+                                        sender));
+            auto message = std::string(f->message()->c_str());
+            if (contact) {
+                res = Gtk::manage(new widget::chat_message(
+                                      contact->property_name_or_addr(),
+                                      time,
+                                      message));
+                add_chat_line(LINE_APPEND_APPENDABLE,
+                              contact,
+                              time,
+                              res);
+            } else if (c->property_addr_public().get_value() == sender) {
+                res = Gtk::manage(new widget::chat_message(
+                                      c->property_name_or_addr(),
+                                      time,
+                                      message));
+                add_chat_line(LINE_APPEND_APPENDABLE,
+                              c,
+                              time,
+                              res);
+            } else {
+                //not found
+                //TODO: will probably need this for group chat
             }
-
-            auto verify = flatbuffers::Verifier(content.data(), content.size());
-            if (!flatbuffers::Log::VerifyCollectionBuffer(verify)) {
-                throw std::runtime_error("flatbuffers::Log::VerifyCollectionBuffer failed");
+        } break;
+        case flatbuffers::Log::Data::Action: {
+            auto f = reinterpret_cast<const flatbuffers::Log::Action*>(
+                         item->data());
+            auto contact = cm->find(toxmm::contactAddrPublic(sender));
+            auto action = std::string(f->action()->begin(),
+                                      f->action()->end());
+            if (contact) {
+                res = Gtk::manage(new widget::chat_action(
+                                      contact->property_name_or_addr(),
+                                      time,
+                                      action));
+                add_chat_line(LINE_NEW,
+                              contact,
+                              time,
+                              res);
+            } else if (c->property_addr_public().get_value() == sender) {
+                res = Gtk::manage(new widget::chat_action(
+                                      c->property_name_or_addr(),
+                                      time,
+                                      action));
+                add_chat_line(LINE_NEW,
+                              c,
+                              time,
+                              res);
+            } else {
+                //not found
+                //TODO: will probably need this for group chat
             }
+        } break;
+        case flatbuffers::Log::Data::File: {
+            auto f = reinterpret_cast<const flatbuffers::Log::File*>(
+                         item->data());
+            auto contact = cm->find(toxmm::contactAddrPublic(sender));
+            auto receiver = segment.address(f->receiver());
+            if (!contact) {
+                contact = cm->find(toxmm::contactAddrPublic(receiver));
+            }
+            if (contact) {
+                //search the file
+                auto fm = contact->file_manager();
+                if (!fm) {
+                    break;
+                }
 
-            last_data = flatbuffers::Log::GetCollection(content.data());
-        }
+                auto file = fm->find(toxmm::uniqueId(std::string(f->uuid()->c_str())));
+
+                auto b_ref = file
+                             ? widget::file::create(file, m_config)
+                             : widget::file::create(f->path()->c_str(), m_config);
 
-        auto item = last_data->items()->Get(index);
+                auto widget = Gtk::manage(b_ref.raw());
+                res = widget;
 
-        //add message to chat
-        auto time = Glib::DateTime::create_now_utc(item->timestamp());
-        auto sender = std::string(item->sender()->c_str());
-        switch (item->data_type()) {
-            case flatbuffers::Log::Data::Message: {
-                auto f = reinterpret_cast<const flatbuffers::Log::Message*>(
-                             item->data());
-                auto contact = cm->find(toxmm::contactAddrPublic(
-                                            sender));
-                auto message = std::string(f->message()->c_str());
-                if (contact) {
+                if (sender != c->property_addr_public().get_value().hex()) {
                     add_chat_line(LINE_APPEND_APPENDABLE,
                                   contact,
                                   time,
-                                  Gtk::manage(new widget::chat_message(
-                                                  contact->property_name_or_addr(),
-                                                  time,
-                                                  message)));
-                } else if (c->property_addr_public().get_value() == sender) {
-                    add_chat_line(LINE_APPEND_APPENDABLE,
-                                  c,
-                                  time,
-                                  Gtk::manage(new widget::chat_message(
-                                                  c->property_name_or_addr(),
-                                                  time,
-                                                  message)));
+                                  Gtk::manage(widget));
                 } else {
-                    //not found
-                    //TODO: will probably need this for group chat
-                }
-            } break;
-            case flatbuffers::Log::Data::Action: {
-                auto f = reinterpret_cast<const flatbuffers::Log::Action*>(
-                             item->data());
-                auto contact = cm->find(toxmm::contactAddrPublic(sender));
-                auto action = std::string(f->action()->begin(),
-                                          f->action()->end());
-                if (contact) {
-                    add_chat_line(LINE_NEW,
-                                  contact,
-                                  time,
-                                  Gtk::manage(new widget::chat_action(
-                                                  contact->property_name_or_addr(),
-                                                  time,
-                                                  action)));
-                } else if (c->property_addr_public().get_value() == sender) {
-                    add_chat_line(LINE_NEW,
+                    add_chat_line(LINE_APPEND_APPENDABLE,
                                   c,
                                   time,
-                                  Gtk::manage(new widget::chat_action(
-                                                  c->property_name_or_addr(),
-                                                  time,
-                                                  action)));
-                } else {
-                    //not found
-                    //TODO: will probably need this for group chat
-                }
-            } break;
-            case flatbuffers::Log::Data::File: {
-                auto f = reinterpret_cast<const flatbuffers::Log::File*>(
-                             item->data());
-                auto contact = cm->find(toxmm::contactAddrPublic(sender));
-                auto receiver = std::string(f->receiver()->c_str());
-                if (!contact) {
-                    contact = cm->find(toxmm::contactAddrPublic(receiver));
+                                  Gtk::manage(widget));
                 }
-                if (contact) {
-                    //search the file
-                    auto fm = contact->file_manager();
-                    if (!fm) {
-                        break;
-                    }
+            } else {
+                //not found
+            }
+        } break;
+        default:
+            //TODO: What should we do ?
+            break;
+    }
+    return res;
+}
 
-                    auto file = fm->find(toxmm::uniqueId(std::string(f->uuid()->c_str())));
+void chat::clear_log() {
+    utils::debug::scope_log lo(DBG_LVL_1("gtox"), {});
+    for (auto c : m_chat_box->get_children()) {
+        m_chat_box->remove(*c);
+    }
+    m_last_bubble.widget = nullptr;
+    m_last_bubble.side = SIDE::NONE;
+    m_scroll_to = nullptr;
+    m_selection_top = 0;
+    m_selection_bottom = -1;
+}
+
+std::vector<Glib::ustring> chat::log_texts(const flatbuffers::Log::Item* item) {
+    utils::debug::scope_log lo(DBG_LVL_5("gtox"), {});
+    switch (item->data_type()) {
+        case flatbuffers::Log::Data::Message: {
+            auto f = reinterpret_cast<const flatbuffers::Log::Message*>(
+                         item->data());
+            if (f->message()) {
+                return { strip_format(f->message()->c_str()) };
+            }
+        } break;
+        case flatbuffers::Log::Data::Action: {
+            auto f = reinterpret_cast<const flatbuffers::Log::Action*>(
+                         item->data());
+            if (f->action()) {
+                return { strip_format(f->action()->c_str()) };
+            }
+        } break;
+        case flatbuffers::Log::Data::File: {
+            auto f = reinterpret_cast<const flatbuffers::Log::File*>(
+                         item->data());
+            if (f->name()) {
+                return { std::string(f->name()->c_str()) };
+            }
+        } break;
+        default:
+            break;
+    }
+    return {};
+}
 
-                    auto b_ref = file
-                                 ? widget::file::create(file, m_config)
-                                 : widget::file::create(f->path()->c_str(), m_config);
+void chat::update_history_search() {
+    utils::debug::scope_log lo(DBG_LVL_2("gtox"), {});
+    for (auto row : m_history_results->get_children()) {
+        m_history_results->remove(*row);
+    }
+    m_history_hits.clear();
 
-                    auto widget = Gtk::manage(b_ref.raw());
+    auto c = m_core.lock();
+    auto index = m_contact->log_index();
+    if (!c || !index) {
+        return;
+    }
 
-                    if (sender != std::string(c->property_addr_public().get_value())) {
-                        add_chat_line(LINE_APPEND_APPENDABLE,
-                                      contact,
-                                      time,
-                                      Gtk::manage(widget));
-                    } else {
-                        add_chat_line(LINE_APPEND_APPENDABLE,
-                                      c,
-                                      time,
-                                      Gtk::manage(widget));
-                    }
-                } else {
-                    //not found
-                }
-            } break;
-            default:
-                //TODO: What should we do ?
-                break;
+    constexpr size_t max_results = 50;
+    toxmm::log_segment segment;
+    uint32_t loaded_day = 0;
+    for (auto& hit : index->find(m_history_search->get_text(), max_results)) {
+        if (hit.day != loaded_day) {
+            loaded_day = hit.day;
+            load_log_day(c->storage(), m_contact, Glib::Date(hit.day), segment);
+        }
+        if (hit.item >= segment.size()) {
+            continue;
+        }
+        auto item = segment.item(hit.item);
+        auto time = Glib::DateTime::create_now_utc(item->timestamp()).to_local();
+        Glib::ustring text;
+        for (auto& t : log_texts(item)) {
+            text += t;
         }
+
+        auto label = Gtk::manage(new Gtk::Label());
+        label->set_markup(Glib::ustring::compose("<small>%1</small>  %2",
+                                                 Glib::Markup::escape_text(time.format("%x %X")),
+                                                 Glib::Markup::escape_text(text)));
+        label->set_xalign(0);
+        label->set_ellipsize(Pango::ELLIPSIZE_END);
+        label->show();
+        m_history_results->add(*label);
+        m_history_hits.push_back(hit);
+    }
+}
+
+void chat::rebuild_log_index() {
+    utils::debug::scope_log lo(DBG_LVL_1("gtox"), {});
+    auto c = m_core.lock();
+    auto index = m_contact->log_index();
+    if (!c || !index) {
+        return;
     }
+    if (index->complete()) {
+        auto today = Glib::Date();
+        today.set_time_current();
+        index->compact(today.get_julian());
+        return;
+    }
+
+    //every day with a log
+    std::vector<std::string> names;
+    c->storage()->list({ m_contact->property_addr_public().get_value(), "log" }, names);
+    auto days = std::make_shared<std::vector<uint32_t>>();
+    for (auto& name : names) {
+        int year, month, day;
+        if (std::sscanf(name.c_str(), "%d-%d-%d", &year, &month, &day) == 3 &&
+            Glib::Date::valid_dmy(day, Glib::Date::Month(month), year)) {
+            days->push_back(Glib::Date(day, Glib::Date::Month(month), year).get_julian());
+        }
+    }
+    std::sort(days->begin(), days->end());
+
+    //one day per call, so the chat stays responsive
+    auto next = std::make_shared<size_t>(0);
+    Glib::signal_idle().connect(sigc::track_obj([this, days, next]() {
+        utils::debug::scope_log lo(DBG_LVL_2("gtox"), { int(*next) });
+        auto c = m_core.lock();
+        auto index = m_contact->log_index();
+        if (!c || !index) {
+            return false;
+        }
+        if (*next < days->size()) {
+            Glib::Date date(days->at((*next)++));
+            toxmm::log_segment segment;
+            std::vector<std::vector<Glib::ustring>> items;
+            try {
+                load_log_day(c->storage(), m_contact, date, segment);
+                for (size_t i = 0; i < segment.size(); ++i) {
+                    items.push_back(log_texts(segment.item(i)));
+                }
+            } catch (std::exception&) {
+                //broken log, nothing to index
+            }
+            index->set_day(date.get_julian(), items);
+            return true;
+        }
+        auto today = Glib::Date();
+        today.set_time_current();
+        index->compact(today.get_julian());
+        index->set_complete(true);
+        if (m_history_searchbar->get_search_mode()) {
+            update_history_search();
+        }
+        return false;
+    }, *this), Glib::PRIORITY_LOW);
 }
 
 void chat::add_chat_line(AppendMode append_mode,
@@ -858,59 +1375,24 @@ void chat::add_log(std::shared_ptr<toxmm::storage> storage,
     //try to load old log
     std::vector<uint8_t> content;
     storage->load(key, content);
-
-    if (content.empty()) {
-        //create empty collection
-        flatbuffers::FlatBufferBuilder fbb;
-        flatbuffers::Log::FinishCollectionBuffer(
-                    fbb,
-                    flatbuffers::Log::CreateCollection(
-                        fbb,
-                        fbb.CreateVector(std::vector<flatbuffers::Offset<flatbuffers::Log::Item>>())));
-
-        content.clear();
-        content.insert(content.end(),
-                       fbb.GetBufferPointer(),
-                       fbb.GetBufferPointer() + fbb.GetSize());
-    }
-
-    auto verify = flatbuffers::Verifier(content.data(), content.size());
-    if (!flatbuffers::Log::VerifyCollectionBuffer(verify)) {
-        throw std::runtime_error("flatbuffers::Log::VerifyCollectionBuffer failed");
-    }
-    auto data = flatbuffers::Log::GetMutableCollection(content.data());
-
-    auto schema_binary = Gio::Resource::lookup_data_global("/org/gtox/flatbuffers/Log.bfbs");
-    gsize schmea_binary_size;
-    auto schema_binary_ptr = schema_binary->get_data(schmea_binary_size);
-    auto& schema = *reflection::GetSchema(schema_binary_ptr); //doesn't this leak memory ?
-
-    flatbuffers::ResizeVector<flatbuffers::Offset<flatbuffers::Log::Item>>(
-                schema,
-                data->items()->size() + 1,
-                0,
-                data->items(),
-                &content);
-
-    //reload (otherwise it will SEGFAULT)
-    data = flatbuffers::Log::GetMutableCollection(content.data());
+    toxmm::log_segment segment;
+    segment.parse(std::move(content));
 
     flatbuffers::FlatBufferBuilder fbb;
     fbb.Finish(create_func(fbb));
-    auto new_item = flatbuffers::AddFlatBuffer(content,
-                                               fbb.GetBufferPointer(),
-                                               fbb.GetSize());
-
-    //reload (otherwise it will SEGFAULT)
-    data = flatbuffers::Log::GetMutableCollection(content.data());
-
-    data->mutable_items()->MutateOffset(
-                data->items()->size() - 1,
-                new_item);
-
-    verify = flatbuffers::Verifier(content.data(), content.size());
-    if (!flatbuffers::Log::VerifyCollectionBuffer(verify)) {
-        throw std::runtime_error("flatbuffers::Log::VerifyCollectionBuffer failed");
+    auto item = flatbuffers::GetRoot<flatbuffers::Log::Item>(fbb.GetBufferPointer());
+    auto item_index = segment.append(item);
+
+    storage->save(key, segment.serialize());
+
+    //keep the history search up to date
+    auto index = contact->log_index();
+    if (index) {
+        auto day = Glib::Date(date.get_day_of_month(),
+                              Glib::Date::Month(date.get_month()),
+                              date.get_year());
+        index->add(day.get_julian(),
+                   item_index,
+                   log_texts(item));
     }
-    storage->save(key, content);
 }
@@ -25,12 +25,17 @@
 #include "utils/dispatcher.h"
 #include "tox/types.h"
 #include "tox/storage.h"
+#include "tox/log_index.h"
 #include <memory>
-#include "resources/flatbuffers/generated/Log_generated.h"
+#include <deque>
+#include "tox/flatbuffers/generated/Log_generated.h"
+#include "tox/log_segment.h"
 #include "utils/debug.h"
 #include "detachable_window.h"
 #include "config.h"
 #include "utils/webcam.h"
+#include "utils/audio_playout.h"
+#include "utils/audio_capture.h"
 #include "widget/avatar.h"
 
 namespace widget {
@@ -38,9 +43,15 @@ namespace widget {
     class imagescaled;
 }
 
+namespace utils {
+    class scroll_benchmark;
+}
+
 namespace dialog {
     class main;
     class chat : public detachable_window, public utils::debug::track_obj<chat> {
+            //fills the chat with fake history
+            friend class utils::scroll_benchmark;
         private:
             std::weak_ptr<toxmm::core> m_core;
             std::shared_ptr<toxmm::contact> m_contact;
@@ -71,7 +82,26 @@ namespace dialog {
             Gtk::Box* m_headerbar_buttons;
             Gtk::Revealer* m_incoming_call_revealer;
 
+            Gtk::SearchBar*    m_history_searchbar;
+            Gtk::SearchEntry*  m_history_search;
+            Gtk::ListBox*      m_history_results;
+            Gtk::ToggleButton* m_history_toggle;
+            std::vector<toxmm::log_index::hit> m_history_hits;
+            //m_chat_box shows a search result instead of the latest lines
+            bool m_history_shown = false;
+            //scrolled into view once m_chat_box got allocated
+            Gtk::Widget* m_scroll_to = nullptr;
+
             utils::webcam m_webcam;
+            //I420 frames for the call, straight from the capture pipeline
+            utils::webcam_capture::handle m_call_capture;
+            std::shared_ptr<utils::handoff<toxmm::av::i420>> m_call_handoff;
+            Glib::ustring m_call_caps;
+            std::shared_ptr<GstDevice> m_call_device;
+            unsigned m_call_dropped = 0;
+            std::unique_ptr<utils::audio_playout> m_call_playout;
+            std::unique_ptr<utils::audio_capture> m_call_audio;
+            sigc::connection m_call_stats;
 
             std::vector<Glib::RefPtr<Glib::Binding>> m_bindings;
 
@@ -95,13 +125,58 @@ namespace dialog {
             int from_x = -1;
             int from_y = -1;
 
+            //y-extents of the m_chat_box children, top to bottom,
+            //rebuilt after the box changed so a selection only walks
+            //the rows it covers and a scroll only the rows in view
+            struct selection_row {
+                int y;
+                int height;
+                Gtk::Widget* widget;
+            };
+            std::vector<selection_row> m_selection_rows;
+            bool m_selection_rows_dirty = true;
+            //y range of the rows that might hold a selection, empty if top > bottom
+            int m_selection_top = 0;
+            int m_selection_bottom = -1;
+
             bool m_autoscroll = true;
 
-            void update_children(GdkEventMotion* event,
-                                 std::vector<Gtk::Widget*> children);
-            Glib::ustring get_children_selection(std::vector<Gtk::Widget*> children);
+            void update_call_capture();
+            void update_call_audio();
+            void update_call_stats();
+
+            //! refreshes the stale bubble timestamps scrolled into view
+            void update_timestamps();
+
+            void update_selection_rows();
+            std::pair<std::vector<selection_row>::iterator,
+                      std::vector<selection_row>::iterator>
+                selection_rows(int top, int bottom);
+            void update_selection(int to_x, int to_y);
+            void update_children(int to_x, int to_y, Gtk::Widget* widget);
+            void get_children_selection(Gtk::Widget* widget, std::string& res);
 
             void load_log();
+            //! replaces the chat with the lines around hit
+            void load_log_at(const toxmm::log_index::hit& hit);
+            void load_log(const std::deque<std::pair<Glib::Date, int>>& log,
+                          const std::pair<Glib::Date, int>& scroll_to = { Glib::Date(), -1 });
+            Gtk::Widget* add_log_item(const toxmm::log_segment& segment,
+                                      const flatbuffers::Log::Item* item);
+            void clear_log();
+
+            void update_history_search();
+            //! indexes the logs from before the search index, a day per idle call
+            void rebuild_log_index();
+
+            //! false when there is no log for the day
+            static bool load_log_day(
+                    std::shared_ptr<toxmm::storage> storage,
+                    std::shared_ptr<toxmm::contact> contact,
+                    const Glib::Date& date,
+                    toxmm::log_segment& segment);
+            //! what the search index gets from a log item
+            static std::vector<Glib::ustring> log_texts(const flatbuffers::Log::Item* item);
 
             enum AppendMode {
                 //adds to previouse bubble
@@ -0,0 +1,307 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "contact_item.h"
+#include "tox/contact/contact.h"
+#include "tox/contact/file/file.h"
+#include "tox/contact/file/manager.h"
+#include "tox/contact/call.h"
+#include "dialog/chat.h"
+#include "dialog/main.h"
+#include "utils/audio_notification.h"
+#include <flatbuffers/flatbuffers.h>
+
+using namespace dialog;
+
+Glib::RefPtr<contact_item> contact_item::create(dialog::main& main,
+                                                std::shared_ptr<toxmm::contact> contact) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { contact->property_name_or_addr().get_value().raw() });
+    return Glib::RefPtr<contact_item>(new contact_item(main, contact));
+}
+
+contact_item::contact_item(dialog::main& main, std::shared_ptr<toxmm::contact> contact):
+    Glib::ObjectBase(typeid(contact_item)),
+    m_main(main),
+    m_contact(contact),
+    m_sort_key(contact->property_sort_key().get_value()),
+    m_property_status_icon(*this, "contact-item-status-icon", "status_offline"),
+    m_property_unread(*this, "contact-item-unread", false),
+    m_property_chat_open(*this, "contact-item-chat-open", false) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { contact->property_name_or_addr().get_value().raw() });
+
+    //collapse presence storms, the item updates once per main-loop tick
+    auto queue_update = sigc::track_obj([this]() {
+        m_main.queue_contact_update(this);
+    }, *this);
+    m_contact->property_status().signal_changed().connect(queue_update);
+    m_contact->property_connection().signal_changed().connect(queue_update);
+    m_contact->property_sort_key().signal_changed().connect(sigc::track_obj([this]() {
+        m_main.queue_contact_update(this, true);
+    }, *this));
+    m_main.queue_contact_update(this);
+
+    //the contact manager's search index holds these
+    auto queue_search = sigc::track_obj([this]() {
+        m_main.queue_search_update();
+    }, *this);
+    m_contact->property_name().signal_changed().connect(queue_search);
+    m_contact->property_status_message().signal_changed().connect(queue_search);
+
+    auto mark_unread = [this]() {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        if (!m_chat || !m_chat->property_has_focus().get_value()) {
+            m_property_unread = true;
+        }
+    };
+
+    m_contact->signal_recv_message().connect(sigc::hide(sigc::track_obj([this, mark_unread]() {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        new utils::audio_notification("file:///usr/share/gtox/audio/Isotoxin/Notification Sounds/isotoxin_NewMessage.flac");
+        mark_unread();
+    }, *this)));
+    m_contact->signal_recv_action().connect(sigc::hide(sigc::track_obj([this, mark_unread]() {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        new utils::audio_notification("file:///usr/share/gtox/audio/Isotoxin/Notification Sounds/isotoxin_NewMessage.flac");
+        mark_unread();
+    }, *this)));
+    m_contact->signal_recv_file().connect(sigc::track_obj([this, mark_unread](toxmm::fileNr, TOX_FILE_KIND kind, size_t, Glib::ustring) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        if (kind == TOX_FILE_KIND_DATA) {
+            new utils::audio_notification("file:///usr/share/gtox/audio/Isotoxin/Notification Sounds/isotoxin_IncomingFile.flac");
+            mark_unread();
+        }
+    }, *this));
+    m_contact->property_connection().signal_changed().connect(sigc::track_obj([this]() {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        if (m_contact->property_connection() == TOX_CONNECTION_NONE) {
+            m_main.queue_notification_sound("file:///usr/share/gtox/audio/Isotoxin/Notification Sounds/isotoxin_FriendOffline.flac");
+            m_played_online_sound = false;
+        } else  if (!m_played_online_sound) {
+            m_played_online_sound = true;
+            m_main.queue_notification_sound("file:///usr/share/gtox/audio/Isotoxin/Notification Sounds/isotoxin_FriendOnline.flac");
+        }
+    }, *this));
+    m_contact->call()->signal_incoming_call().connect(sigc::track_obj([this, mark_unread]() {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        new utils::audio_notification("file:///usr/share/gtox/audio/Isotoxin/Call Sounds/isotoxin_Ringtone.flac");
+        mark_unread();
+    }, *this));
+
+    install_logging();
+}
+
+contact_item::~contact_item() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    m_main.cancel_contact_update(this);
+}
+
+void contact_item::install_logging() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    m_contact->signal_send_message().connect(sigc::track_obj([this](Glib::ustring message, std::shared_ptr<toxmm::receipt>) {
+       utils::debug::scope_log log(DBG_LVL_2("gtox"), { message.raw() });
+       dialog::chat::add_log(m_main.tox()->storage(), m_contact, [&](flatbuffers::FlatBufferBuilder& fbb) {
+            utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+           return flatbuffers::Log::CreateItem(fbb,
+                                               fbb.CreateString(m_main.tox()->property_addr_public().get_value()),
+                                               Glib::DateTime::create_now_utc().to_unix(),
+                                               flatbuffers::Log::Data::Message,
+                                               flatbuffers::Log::CreateMessage(
+                                                    fbb,
+                                                    fbb.CreateString(message))
+                                                     .Union());
+       });
+    }, *this));
+    m_contact->signal_recv_message().connect(sigc::track_obj([this](Glib::ustring message) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), { message.raw() });
+        dialog::chat::add_log(m_main.tox()->storage(), m_contact, [&](flatbuffers::FlatBufferBuilder& fbb) {
+            utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+            return flatbuffers::Log::CreateItem(fbb,
+                                                fbb.CreateString(m_contact->property_addr_public().get_value()),
+                                                Glib::DateTime::create_now_utc().to_unix(),
+                                                flatbuffers::Log::Data::Message,
+                                                flatbuffers::Log::CreateMessage(
+                                                     fbb,
+                                                     fbb.CreateString(message))
+                                                     .Union());
+        });
+    }, *this));
+    m_contact->signal_send_action().connect(sigc::track_obj([this](Glib::ustring action, std::shared_ptr<toxmm::receipt>) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), { action.raw() });
+        dialog::chat::add_log(m_main.tox()->storage(), m_contact, [&](flatbuffers::FlatBufferBuilder& fbb) {
+            utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+            return flatbuffers::Log::CreateItem(fbb,
+                                                fbb.CreateString(m_main.tox()->property_addr_public().get_value()),
+                                                Glib::DateTime::create_now_utc().to_unix(),
+                                                flatbuffers::Log::Data::Action,
+                                                flatbuffers::Log::CreateAction(
+                                                     fbb,
+                                                     fbb.CreateString(action))
+                                                      .Union());
+        });
+    }, *this));
+    m_contact->signal_recv_action().connect(sigc::track_obj([this](Glib::ustring action) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), { action.raw() });
+        dialog::chat::add_log(m_main.tox()->storage(), m_contact, [&](flatbuffers::FlatBufferBuilder& fbb) {
+            utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+            return flatbuffers::Log::CreateItem(fbb,
+                                                fbb.CreateString(m_contact->property_addr_public().get_value()),
+                                                Glib::DateTime::create_now_utc().to_unix(),
+                                                flatbuffers::Log::Data::Action,
+                                                flatbuffers::Log::CreateAction(
+                                                     fbb,
+                                                     fbb.CreateString(action))
+                                                     .Union());
+        });
+    },*this));
+    auto fm = m_contact->file_manager();
+    if (fm) {
+        fm->signal_send_file().connect(sigc::track_obj([this](std::shared_ptr<toxmm::file>& file) {
+            utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+            if (file->property_kind() != TOX_FILE_KIND_DATA) {
+                return;
+            }
+            dialog::chat::add_log(m_main.tox()->storage(), m_contact, [&](flatbuffers::FlatBufferBuilder& fbb) {
+                utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+                return flatbuffers::Log::CreateItem(fbb,
+                                                    fbb.CreateString(m_main.tox()->property_addr_public().get_value()),
+                                                    Glib::DateTime::create_now_utc().to_unix(),
+                                                    flatbuffers::Log::Data::File,
+                                                    flatbuffers::Log::CreateFile(
+                                                         fbb,
+                                                         fbb.CreateString(file->property_uuid().get_value()),
+                                                         fbb.CreateString(file->property_name().get_value()),
+                                                         fbb.CreateString(file->property_path().get_value()),
+                                                         flatbuffers::Log::FileStatus::PENDING,
+                                                         fbb.CreateString(m_contact->property_addr_public().get_value()))
+                                                          .Union());
+            });
+        }, *this));
+        fm->signal_recv_file().connect(sigc::track_obj([this](std::shared_ptr<toxmm::file>& file) {
+            utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+            if (file->property_kind() != TOX_FILE_KIND_DATA) {
+                return;
+            }
+            dialog::chat::add_log(m_main.tox()->storage(), m_contact, [&](flatbuffers::FlatBufferBuilder& fbb) {
+                utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+                return flatbuffers::Log::CreateItem(fbb,
+                                                    fbb.CreateString(m_contact->property_addr_public().get_value()),
+                                                    Glib::DateTime::create_now_utc().to_unix(),
+                                                    flatbuffers::Log::Data::File,
+                                                    flatbuffers::Log::CreateFile(
+                                                         fbb,
+                                                         fbb.CreateString(file->property_uuid().get_value()),
+                                                         fbb.CreateString(file->property_name().get_value()),
+                                                         fbb.CreateString(file->property_path().get_value()),
+                                                         flatbuffers::Log::FileStatus::PENDING,
+                                                         fbb.CreateString(m_contact->property_addr_public().get_value()))
+                                                          .Union());
+            });
+        }, *this));
+    }
+}
+
+std::shared_ptr<toxmm::contact> contact_item::get_contact() {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+    return m_contact;
+}
+
+void contact_item::update_presence() {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+    auto connection = m_contact->property_connection().get_value();
+    if (connection == TOX_CONNECTION_NONE) {
+        m_property_status_icon = "status_offline";
+        return;
+    }
+    std::string tcp = "";
+    if (connection == TOX_CONNECTION_TCP) {
+        tcp = "_tcp";
+    }
+    switch (m_contact->property_status().get_value()) {
+        case TOX_USER_STATUS_AWAY:
+            m_property_status_icon = "status_away" + tcp;
+            break;
+        case TOX_USER_STATUS_BUSY:
+            m_property_status_icon = "status_busy" + tcp;
+            break;
+        case TOX_USER_STATUS_NONE:
+            m_property_status_icon = "status_online" + tcp;
+            break;
+    }
+}
+
+const std::string& contact_item::sort_key() const {
+    return m_sort_key;
+}
+
+bool contact_item::update_sort_key() {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    auto key = m_contact->property_sort_key().get_value();
+    if (key == m_sort_key) {
+        return false;
+    }
+    m_sort_key = std::move(key);
+    return true;
+}
+
+int contact_item::compare(const Glib::RefPtr<const contact_item>& a,
+                          const Glib::RefPtr<const contact_item>& b) {
+    int res = a->m_sort_key.compare(b->m_sort_key);
+    return (res > 0) - (res < 0);
+}
+
+Glib::PropertyProxy_ReadOnly<Glib::ustring> contact_item::property_status_icon() {
+    return m_property_status_icon.get_proxy();
+}
+
+Glib::PropertyProxy_ReadOnly<bool> contact_item::property_unread() {
+    return m_property_unread.get_proxy();
+}
+
+Glib::PropertyProxy_ReadOnly<bool> contact_item::property_chat_open() {
+    return m_property_chat_open.get_proxy();
+}
+
+void contact_item::activated() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    if (m_chat) {
+        m_chat->present();
+        return;
+    }
+    auto attach = sigc::mem_fun(m_main,
+                                &dialog::main::detachable_window_add);
+    auto detach = sigc::mem_fun(m_main,
+                                &dialog::main::detachable_window_del);
+    m_chat = std::make_shared<dialog::chat>(m_main.tox(),
+                                            m_contact,
+                                            m_main.config(),
+                                            attach,
+                                            detach);
+    m_property_chat_open = true;
+    m_chat->signal_close().connect(sigc::track_obj([this]() {
+        m_chat.reset();
+        m_property_chat_open = false;
+    }, *this));
+    //clear unread after reading message
+    m_chat->property_has_focus()
+            .signal_changed()
+            .connect(sigc::track_obj([this]() {
+        if (m_chat->property_has_focus().get_value()) {
+            m_property_unread = false;
+        }
+    }, *this));
+}
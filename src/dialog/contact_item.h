@@ -0,0 +1,81 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef GTOX_CONTACT_ITEM_H
+#define GTOX_CONTACT_ITEM_H
+
+#include <gtkmm.h>
+#include "tox/types.h"
+#include "utils/debug.h"
+
+namespace dialog {
+    class main;
+    class chat;
+
+    /**
+     * @brief One contact in the contact list model.
+     *
+     * Holds everything about a contact that isn't drawn: the open chat,
+     * logging, notification sounds and presence. Rows are only views of
+     * it and can come and go.
+     */
+    class contact_item: public Glib::Object, public utils::debug::track_obj<contact_item> {
+        public:
+            static Glib::RefPtr<contact_item> create(dialog::main& main,
+                                                     std::shared_ptr<toxmm::contact> contact);
+            ~contact_item();
+
+            std::shared_ptr<toxmm::contact> get_contact();
+
+            //! opens or presents the chat
+            void activated();
+            //! refreshes property_status_icon(), called batched by dialog::main
+            void update_presence();
+
+            //! cached copy of the contact's sort key, what the model is sorted by
+            const std::string& sort_key() const;
+            //! takes over the contact's current sort key, true if it changed
+            bool update_sort_key();
+            static int compare(const Glib::RefPtr<const contact_item>& a,
+                               const Glib::RefPtr<const contact_item>& b);
+
+            Glib::PropertyProxy_ReadOnly<Glib::ustring> property_status_icon();
+            //! got something while the chat wasn't focused
+            Glib::PropertyProxy_ReadOnly<bool> property_unread();
+            Glib::PropertyProxy_ReadOnly<bool> property_chat_open();
+
+        private:
+            dialog::main& m_main;
+            std::shared_ptr<toxmm::contact> m_contact;
+            std::shared_ptr<dialog::chat> m_chat;
+            std::string m_sort_key;
+            bool m_played_online_sound = false;
+
+            Glib::Property<Glib::ustring> m_property_status_icon;
+            Glib::Property<bool> m_property_unread;
+            Glib::Property<bool> m_property_chat_open;
+
+            contact_item(dialog::main& main, std::shared_ptr<toxmm::contact> contact);
+            contact_item(const contact_item&) = delete;
+            void operator=(const contact_item&) = delete;
+
+            void install_logging();
+    };
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include "main.h"
 #include <gdkmm.h>
 #include <iostream>
+#include <algorithm>
 #include <glibmm/i18n.h>
 
 #include "tox/core.h"
@@ -27,7 +28,9 @@
 #include "tox/contact/contact.h"
 
 #include "dialog/main.h"
+#include "dialog/contact_item.h"
 #include "widget/contact.h"
+#include "utils/audio_notification.h"
 
 #include "gtox.h"
 
@@ -42,7 +45,12 @@ using namespace dialog;
 main::main(BaseObjectType* cobject,
            utils::builder builder,
            const Glib::ustring& file)
-    : Gtk::Window(cobject)
+    : Gtk::Window(cobject),
+      m_contacts(Gio::ListStore<contact_item>::create()),
+      m_contacts_active(Gio::ListStore<contact_item>::create()),
+      m_batch({m_contacts, m_contacts_active}, [this](bool reordered) {
+          batch_flushed(reordered);
+      })
 {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), { file.raw() });
     m_storage = std::make_shared<utils::storage>();
@@ -69,6 +77,8 @@ main::main(BaseObjectType* cobject,
     builder.get_widget("status_icon", m_status_icon);
     builder.get_widget("request_revealer", m_request_revealer);
     builder.get_widget("request_btn", m_request_btn);
+    builder.get_widget("searchbar", m_searchbar);
+    builder.get_widget("searchentry", m_searchentry);
 
     set_icon(Gdk::Pixbuf::create_from_resource("/org/gtox/icon/icon_128.svg"));
     signal_delete_event().connect(sigc::track_obj([this](GdkEventAny*) {
@@ -86,7 +96,8 @@ main::main(BaseObjectType* cobject,
         m_store_pos_size.disconnect();
         m_store_pos_size = Glib::signal_timeout()
                             .connect(sigc::track_obj([this, root_x, root_y, w, h]() {
-            // store in config
+            // store in config, saved once
+            auto batch = m_config->batch();
             m_config->property_window_x() = root_x;
             m_config->property_window_y() = root_y;
             m_config->property_window_w() = w;
@@ -160,22 +171,57 @@ main::main(BaseObjectType* cobject,
     m_list_contact->signal_row_activated().connect(activated);
     m_list_contact_active->signal_row_activated().connect(activated);
 
-    auto sort_func = [this](Gtk::ListBoxRow* a, Gtk::ListBoxRow* b) {
+    //one item per contact, the lists are views of the two stores
+    m_list_contact->bind_list_store(m_contacts, [this](const Glib::RefPtr<contact_item>& item) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        return Gtk::manage(widget::contact::create(*this, item).raw());
+    });
+    m_list_contact_active->bind_list_store(m_contacts_active, [this](const Glib::RefPtr<contact_item>& item) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        return Gtk::manage(widget::contact::create(*this, item, true).raw());
+    });
+
+    load_contacts();
+
+    m_searchbar->connect_entry(*m_searchentry);
+    //type-ahead search, the filter only looks up the row's contact in
+    //the result of the contact manager's index
+    m_list_contact->set_filter_func(sigc::track_obj([this](Gtk::ListBoxRow* row) {
         utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-        auto item_a = dynamic_cast<widget::contact*>(a);
-        auto item_b = dynamic_cast<widget::contact*>(b);
-        if (item_a == nullptr) {
-            return 0;
+        if (!m_searching) {
+            return true;
         }
-        if (item_b == nullptr) {
-            return 0;
+        auto item = dynamic_cast<widget::contact*>(row);
+        if (!item) {
+            return true;
         }
-        return item_a->compare(item_b);
-    };
-    m_list_contact->set_sort_func(sort_func);
-    m_list_contact_active->set_sort_func(sort_func);
-
-    load_contacts();
+        return std::binary_search(m_search_result.begin(),
+                                  m_search_result.end(),
+                                  item->get_contact()->property_nr().get_value());
+    }, *this));
+    m_searchentry->signal_search_changed().connect(sigc::track_obj([this]() {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        update_search();
+    }, *this));
+    m_searchentry->signal_activate().connect(sigc::track_obj([this]() {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        //open the first match
+        for (guint i = 0; i < m_contacts->get_n_items(); ++i) {
+            auto item = m_contacts->get_item(i);
+            if (!m_searching || std::binary_search(m_search_result.begin(),
+                                                   m_search_result.end(),
+                                                   item->get_contact()->property_nr().get_value())) {
+                m_searchbar->property_search_mode_enabled() = false;
+                item->activated();
+                return;
+            }
+        }
+    }, *this));
+    signal_key_press_event().connect(sigc::track_obj([this](GdkEventKey* event) {
+        utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+        //typing anywhere unhandled starts a search
+        return m_searchbar->handle_event(event);
+    }, *this));
 
     //Menu items
     auto contact_remove = Gtk::manage(new Gtk::MenuItem(_("Remove contact"), true));
@@ -223,23 +269,6 @@ main::main(BaseObjectType* cobject,
         }
     });
 
-    m_toxcore
-            ->contact_manager()
-            ->signal_removed()
-            .connect(sigc::track_obj(
-                         [this](std::shared_ptr<toxmm::contact> contact) {
-        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
-        for (auto widget: {m_list_contact, m_list_contact_active}) {
-            for (auto item: widget->get_children()) {
-                auto item_r = dynamic_cast<widget::contact*>(item);
-                if (item_r && item_r->get_contact() == contact) {
-                    widget->remove(*item_r);
-                    delete item_r;
-                }
-            }
-        }
-    }, *this));
-
     auto update_status_icon = sigc::track_obj([this]() {
         utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
         auto connection = m_toxcore->property_connection().get_value();
@@ -273,38 +302,14 @@ main::main(BaseObjectType* cobject,
 
     m_toxcore->contact_manager()->signal_removed().connect(sigc::track_obj([this](std::shared_ptr<toxmm::contact> contact) {
         utils::debug::scope_log log(DBG_LVL_2("gtox"), { contact->property_name_or_addr().get_value().raw() });
-        //remove contact from list
-        for (auto item_ : m_list_contact->get_children()) {
-            auto item = dynamic_cast<widget::contact*>(item_);
-            if (item && item->get_contact() == contact) {
-                delete item;
-                break;
-            }
-        }
-        for (auto item_ : m_list_contact_active->get_children()) {
-            auto item = dynamic_cast<widget::contact*>(item_);
-            if (item && item->get_contact() == contact) {
-                delete item;
-                break;
-            }
-        }
-        m_list_contact->invalidate_sort();
-        m_list_contact_active->invalidate_sort();
+        remove_contact(contact);
+        update_search();
     }, *this));
 
     m_toxcore->contact_manager()->signal_added().connect(sigc::track_obj([this](std::shared_ptr<toxmm::contact> contact) {
-    utils::debug::scope_log log(DBG_LVL_2("gtox"), { contact->property_name_or_addr().get_value().raw() });
-        //add contact to list
-        auto item_builder = widget::contact::create(*this, contact);
-        auto item = Gtk::manage(item_builder.raw());
-        m_list_contact->add(*item);
-
-        item_builder = widget::contact::create(*this, contact, true);
-        item = Gtk::manage(item_builder.raw());
-        m_list_contact_active->add(*item);
-
-        m_list_contact->invalidate_sort();
-        m_list_contact_active->invalidate_sort();
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), { contact->property_name_or_addr().get_value().raw() });
+        add_contact(contact);
+        update_search();
     }, *this));
 
     //setup status change menu
@@ -407,37 +412,53 @@ utils::builder::ref<main> main::create(const Glib::ustring& file) {
 
 void main::load_contacts() {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
-    for (auto item : m_list_contact->get_children()) {
-        delete item;
-    }
-    for (auto item : m_list_contact_active->get_children()) {
-        delete item;
-    }
+    m_contacts_active->remove_all();
+    m_contacts->remove_all();
 
     for (auto contact : m_toxcore->contact_manager()->get_all()) {
-        //normal contact list:
-        auto item_builder = widget::contact::create(*this, contact);
-        auto item = Gtk::manage(item_builder.raw());
-        m_list_contact->add(*item);
-
-        //active chat list:
-        item_builder = widget::contact::create(*this, contact, true);
-        item = Gtk::manage(item_builder.raw());
-        m_list_contact_active->add(*item);
+        add_contact(contact);
     }
+}
+
+void main::add_contact(std::shared_ptr<toxmm::contact> contact) {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), { contact->property_name_or_addr().get_value().raw() });
+    auto item = contact_item::create(*this, contact);
+    m_contacts->insert_sorted(item, &contact_item::compare);
 
-    m_list_contact->invalidate_sort();
-    m_list_contact_active->invalidate_sort();
+    //the active list only holds contacts with an open chat
+    auto raw = item.operator->();
+    item->property_chat_open().signal_changed().connect(sigc::track_obj([this, raw]() {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        auto pos = utils::presence_batch<contact_item>::find(m_contacts_active, raw);
+        bool listed = pos < m_contacts_active->get_n_items();
+        if (raw->property_chat_open().get_value() && !listed) {
+            m_contacts_active->insert_sorted(utils::presence_batch<contact_item>::ref(raw),
+                                             &contact_item::compare);
+        } else if (!raw->property_chat_open().get_value() && listed) {
+            m_contacts_active->remove(pos);
+        }
+    }, *this));
+}
+
+void main::remove_contact(std::shared_ptr<toxmm::contact> contact) {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+    for (auto store : {m_contacts_active, m_contacts}) {
+        for (guint i = 0; i < store->get_n_items(); ++i) {
+            if (store->get_item(i)->get_contact() == contact) {
+                store->remove(i);
+                break;
+            }
+        }
+    }
 }
 
 main::~main() {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
-    for (auto item : m_list_contact->get_children()) {
-        delete item;
-    }
-    for (auto item : m_list_contact_active->get_children()) {
-        delete item;
-    }
+    //drop the rows and items while we still exist, items call back into us
+    gtk_list_box_bind_model(m_list_contact->gobj(), nullptr, nullptr, nullptr, nullptr);
+    gtk_list_box_bind_model(m_list_contact_active->gobj(), nullptr, nullptr, nullptr, nullptr);
+    m_contacts_active->remove_all();
+    m_contacts->remove_all();
     // save ?
     auto t = tox();
     if (t) {
@@ -445,6 +466,61 @@ main::~main() {
     }
 }
 
+void main::queue_contact_update(contact_item* item, bool reorder) {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    m_batch.queue(item, reorder);
+}
+
+void main::cancel_contact_update(contact_item* item) {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    m_batch.cancel(item);
+}
+
+void main::queue_notification_sound(const std::string& uri) {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), { uri });
+    m_batch_sounds.insert(uri);
+    m_batch.schedule();
+}
+
+void main::queue_search_update() {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    if (!m_searching) {
+        return;
+    }
+    m_batch_search = true;
+    m_batch.schedule();
+}
+
+void main::batch_flushed(bool reordered) {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), { reordered, int(m_batch_sounds.size()) });
+    auto sounds = std::move(m_batch_sounds);
+    m_batch_sounds.clear();
+    bool search = m_batch_search || reordered;
+    m_batch_search = false;
+    if (search && m_searching) {
+        //renamed rows or new status messages might match now, or no longer
+        update_search();
+    }
+    for (auto& uri : sounds) {
+        new utils::audio_notification(uri);
+    }
+}
+
+void main::update_search() {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+    auto query = m_searchentry->get_text();
+    if (query.empty() && !m_searching) {
+        return;
+    }
+    m_searching = !query.empty();
+    if (m_searching) {
+        m_search_result = m_toxcore->contact_manager()->search(query);
+    } else {
+        m_search_result.clear();
+    }
+    m_list_contact->invalidate_filter();
+}
+
 void main::exit() {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
     hide();
@@ -21,6 +21,7 @@
 #define DIALOGCONTACT_H
 
 #include <gtkmm.h>
+#include <set>
 #include "utils/builder.h"
 #include "utils/storage.h"
 #include "tox/types.h"
@@ -28,8 +29,13 @@
 #include "config.h"
 #include "storage.h"
 #include "utils/debug.h"
+#include "utils/presence_batch.h"
 #include "detachable_window.h"
 
+namespace dialog {
+    class contact_item;
+}
+
 namespace dialog {
     // contact list with pinned chat
     class main : public Gtk::Window, public utils::debug::track_obj<main> {
@@ -48,6 +54,8 @@ namespace dialog {
             Gtk::ScrolledWindow* m_list_contact_scroll;
             Gtk::Revealer* m_request_revealer;
             Gtk::Button*   m_request_btn;
+            Gtk::SearchBar*   m_searchbar;
+            Gtk::SearchEntry* m_searchentry;
 
             Gtk::Image* m_status_icon;
 
@@ -72,6 +80,20 @@ namespace dialog {
 
             std::vector<std::pair<toxmm::contactAddrPublic, Glib::ustring>> m_requests;
 
+            //all contacts sorted by name, and the ones with an open chat
+            Glib::RefPtr<Gio::ListStore<contact_item>> m_contacts;
+            Glib::RefPtr<Gio::ListStore<contact_item>> m_contacts_active;
+
+            //presence changes collected during one main-loop tick
+            utils::presence_batch<contact_item> m_batch;
+            std::set<std::string> m_batch_sounds;
+            //a field the search matches changed
+            bool m_batch_search = false;
+
+            //contacts matching the search entry, sorted
+            bool m_searching = false;
+            std::vector<toxmm::contactNr> m_search_result;
+
         public:
             main(BaseObjectType* cobject,
                  utils::builder builder,
@@ -89,8 +111,25 @@ namespace dialog {
 
             std::shared_ptr<class config>& config();
 
+            /**
+             * @brief updates a contact row with the next batch
+             * @param reorder the sort key changed, move the row to its
+             * new position
+             */
+            void queue_contact_update(contact_item* item, bool reorder = false);
+            void cancel_contact_update(contact_item* item);
+            //! plays every distinct sound once with the next batch
+            void queue_notification_sound(const std::string& uri);
+            //! refilters a running search with the next batch
+            void queue_search_update();
+
         protected:
             void load_contacts();
+            void add_contact(std::shared_ptr<toxmm::contact> contact);
+            void remove_contact(std::shared_ptr<toxmm::contact> contact);
+            void batch_flushed(bool reordered);
+            //! asks the contact manager's index and refilters the list
+            void update_search();
 
             std::shared_ptr<utils::storage> m_storage;
     };
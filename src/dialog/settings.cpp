@@ -73,6 +73,7 @@ settings::settings(main& main)
 
     builder.get_widget("video_default_device", m_video_device);
     builder.get_widget("settings_video_error", m_video_error);
+    builder.get_widget("audio_low_latency", m_audio_low_latency);
     m_video_preview = builder.get_widget_derived<widget::imagescaled>(
                           "settings_video_player");
 
@@ -255,13 +256,27 @@ settings::settings(main& main)
                              m_p_remember->property_active(),
                              binding_flag));
 
+    //GLOBAL AUDIO-SETTINGS
+    m_bindings.push_back(Glib::Binding::bind_property(
+                             config::global().property_audio_low_latency(),
+                             m_audio_low_latency->property_active(),
+                             binding_flag));
+
     //GLOBAL VIDEO-SETTINGS
     auto webcam_devices_store = Glib::RefPtr<Gtk::ListStore>
                                 ::cast_dynamic(m_video_device->get_model());
-    for (auto device : utils::webcam::get_webcam_devices()) {
-        auto new_row = webcam_devices_store->append();
-        new_row->set_value(0, utils::webcam::get_webcam_device_name(device));
-    }
+    auto update_webcam_devices = [this, webcam_devices_store]() {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        auto active = m_video_device->property_active_id().get_value();
+        webcam_devices_store->clear();
+        for (auto device : utils::webcam::get_webcam_devices()) {
+            auto new_row = webcam_devices_store->append();
+            new_row->set_value(0, utils::webcam::get_webcam_device_name(device));
+        }
+        m_video_device->property_active_id() = active;
+    };
+    update_webcam_devices();
+    utils::webcam::signal_devices_changed().connect(sigc::track_obj(update_webcam_devices, *this));
     m_bindings.push_back(Glib::Binding::bind_property(
                              config::global().property_video_default_device(),
                              m_video_device->property_active_id(),
@@ -65,6 +65,8 @@ namespace dialog {
             widget::imagescaled* m_video_preview;
             Gtk::Label*          m_video_error;
 
+            Gtk::Switch* m_audio_low_latency;
+
             std::vector<Glib::RefPtr<Glib::Binding>> m_bindings;
 
             utils::webcam m_webcam;
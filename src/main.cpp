@@ -30,6 +30,10 @@
 #include "tox/exception.h"
 #include "utils/debug.h"
 #include "gtox.h"
+#include "widget/label.h"
+#include "utils/builder.h"
+#include "utils/log_benchmark.h"
+#include "utils/presence_benchmark.h"
 
 void print_copyright() {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
@@ -132,6 +136,11 @@ int main(int argc, char* argv[]) {
 
     print_copyright();
 
+    widget::label::benchmark();
+    utils::builder::benchmark();
+    utils::log_benchmark::run();
+    utils::presence_benchmark::run();
+
     bool non_unique = false;
     if (argc > 1) {
         non_unique = std::any_of(argv, argv + argc, [](auto x) {
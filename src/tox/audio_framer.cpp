@@ -0,0 +1,114 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "audio_framer.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace toxmm;
+
+const int audio_framer::rate;
+
+audio_framer::audio_framer(av::audio::al length,
+                           av::audio::ch channels,
+                           size_t ring_size):
+    m_length(length),
+    m_channels(channels),
+    m_ring(std::max(ring_size, size_t(2))) {
+    for (auto& s : m_ring) {
+        s.frame = av::audio(m_length, m_channels, av::audio::SAMPLING_RATE_48000);
+        s.captured = -1;
+    }
+}
+
+size_t audio_framer::frame_size() const {
+    return size_t(rate) * m_length / 1000 * m_channels;
+}
+
+void audio_framer::claim(slot& s) {
+    if (!s.frame.unique()) {
+        s.frame = av::audio(m_length, m_channels, av::audio::SAMPLING_RATE_48000);
+        ++m_allocations;
+    }
+}
+
+void audio_framer::push(const int16_t* data, size_t count, gint64 captured) {
+    const size_t size = frame_size();
+
+    //trust the running sample clock unless the capture skipped ahead or back
+    gint64 expected = m_next_captured;
+    if (expected < 0 || std::abs(captured - expected) > gint64(m_length) * 1000) {
+        //restart the partial frame at the new position
+        m_fill_pos = 0;
+        m_next_captured = captured;
+    }
+
+    while (count > 0) {
+        auto& s = m_ring[m_fill];
+        if (m_fill_pos == 0) {
+            claim(s);
+            s.captured = m_next_captured;
+        }
+        size_t n = std::min(count, size - m_fill_pos);
+        std::copy(data, data + n, s.frame.data() + m_fill_pos);
+        m_fill_pos += n;
+        data += n;
+        count -= n;
+        m_next_captured += gint64(n / m_channels) * 1000000 / rate;
+
+        if (m_fill_pos == size) {
+            m_fill_pos = 0;
+            m_fill = (m_fill + 1) % m_ring.size();
+            //next slot holds the oldest ready frame when the ring is full
+            if (m_ready == m_ring.size() - 1) {
+                ++m_dropped;
+            } else {
+                ++m_ready;
+            }
+            //keep the clock on whole frames, avoids drifting by rounding
+            m_next_captured = s.captured + gint64(m_length) * 1000;
+        }
+    }
+}
+
+bool audio_framer::pop(av::audio& frame, gint64& captured) {
+    if (m_ready == 0) {
+        return false;
+    }
+    auto& s = m_ring[(m_fill + m_ring.size() - m_ready) % m_ring.size()];
+    --m_ready;
+    frame = s.frame;
+    captured = s.captured;
+    return true;
+}
+
+av::audio::al audio_framer::length() const {
+    return m_length;
+}
+
+size_t audio_framer::ready() const {
+    return m_ready;
+}
+
+uint32_t audio_framer::dropped() const {
+    return m_dropped;
+}
+
+uint32_t audio_framer::allocations() const {
+    return m_allocations;
+}
@@ -0,0 +1,82 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef TOXMM_AUDIO_FRAMER_H
+#define TOXMM_AUDIO_FRAMER_H
+
+#include <glibmm.h>
+#include <vector>
+#include "av.h"
+
+namespace toxmm {
+    /**
+     * @brief Cuts captured 48 kHz audio into the fixed size frames toxav
+     * sends.
+     *
+     * Frames come from a preallocated ring and are timestamped from the
+     * sample position, so pacing follows the capture clock rather than
+     * the time they get popped. A slot still referenced by a popped copy
+     * is replaced instead of overwritten.
+     *
+     * Not thread-safe, guard push() and pop() with the same lock.
+     */
+    class audio_framer {
+        public:
+            static const int rate = 48000;
+
+            audio_framer(av::audio::al length,
+                         av::audio::ch channels,
+                         size_t ring_size = 8);
+
+            //! samples interleaved, captured is when the first one was recorded
+            void push(const int16_t* data, size_t count, gint64 captured);
+            //! oldest completed frame, false if there is none
+            bool pop(av::audio& frame, gint64& captured);
+
+            av::audio::al length() const;
+            //! frames waiting for pop()
+            size_t ready() const;
+            //! completed frames overwritten before pop()
+            uint32_t dropped() const;
+            //! slots that had to be reallocated because they were still in use
+            uint32_t allocations() const;
+
+        private:
+            struct slot {
+                av::audio frame;
+                gint64 captured;
+            };
+
+            av::audio::al m_length;
+            av::audio::ch m_channels;
+            std::vector<slot> m_ring;
+
+            size_t m_fill = 0;
+            size_t m_fill_pos = 0;
+            size_t m_ready = 0;
+            gint64 m_next_captured = -1;
+
+            uint32_t m_dropped = 0;
+            uint32_t m_allocations = 0;
+
+            size_t frame_size() const;
+            void claim(slot& s);
+    };
+}
+
+#endif
@@ -44,7 +44,13 @@ void av::init() {
         ((av*)_this)->m_signal_call(contactNr(nr), audio_enabled, video_enabled);
     }, this);
     toxav_callback_call_state(m_av, [](ToxAV*, uint32_t nr, uint32_t state, void* _this) {
-        ((av*)_this)->m_signal_call_state(contactNr(nr), state);
+        auto self = (av*)_this;
+        if (state & (TOXAV_FRIEND_CALL_STATE_FINISHED | TOXAV_FRIEND_CALL_STATE_ERROR)) {
+            self->m_calls.erase(nr);
+        } else {
+            self->m_calls.insert(nr);
+        }
+        self->m_signal_call_state(contactNr(nr), state);
     }, this);
     toxav_callback_bit_rate_status(m_av, [](ToxAV*, uint32_t nr, uint32_t audio_bit_rate, uint32_t video_bit_rate, void* _this) {
         ((av*)_this)->m_signal_bit_rate_status(contactNr(nr), audio_bit_rate, video_bit_rate);
@@ -108,6 +114,7 @@ void av::call(contactNr nr,
     if (error != TOXAV_ERR_CALL_OK) {
         throw exception(error);
     }
+    m_calls.insert(nr);
 }
 
 void av::answer(contactNr nr,
@@ -126,6 +133,7 @@ void av::answer(contactNr nr,
     if (error != TOXAV_ERR_ANSWER_OK) {
         throw exception(error);
     }
+    m_calls.insert(nr);
 }
 
 void av::call_control(contactNr nr,
@@ -142,6 +150,13 @@ void av::call_control(contactNr nr,
     if (error != TOXAV_ERR_CALL_CONTROL_OK) {
         throw exception(error);
     }
+    if (control == TOXAV_CALL_CONTROL_CANCEL) {
+        m_calls.erase(nr);
+    }
+}
+
+bool av::in_call() const {
+    return !m_calls.empty();
 }
 
 void av::set_bit_rate(contactNr nr,
@@ -186,34 +201,82 @@ void av::send_video_frame(contactNr nr,
     if (!m_av) {
         return;
     }
+    send_video_frame(nr, i420::from_image(img));
+}
 
-    std::vector<uint8_t> y(img.width() * img.height());
-    std::vector<uint8_t> u((img.width() / 2) * (img.height() / 2));
-    std::vector<uint8_t> v((img.width() / 2) * (img.height() / 2));
+void av::send_video_frame(contactNr nr,
+                          const av::i420 &frame) {
+    if (!m_av || frame.empty()) {
+        return;
+    }
 
-    for (int cy = 0; cy < img.height(); ++cy) {
-        for (int cx = 0; cx < img.width(); ++cx) {
-            img[{cx, cy}].as_yuv(
-                        y.at(cx + cy * img.width()),
-                        u.at((cx / 2) + (cy / 2) * (img.width() / 2)),
-                        v.at((cx / 2) + (cy / 2) * (img.width() / 2)));
+    const uint8_t* planes[3] = {frame.plane(0), frame.plane(1), frame.plane(2)};
+    if (!frame.packed()) {
+        //drop the row padding
+        int w[3] = {frame.width(), frame.width() / 2, frame.width() / 2};
+        int h[3] = {frame.height(), frame.height() / 2, frame.height() / 2};
+        m_scratch.resize(size_t(w[0]) * h[0] + 2 * size_t(w[1]) * h[1]);
+        auto out = m_scratch.data();
+        for (int p = 0; p < 3; ++p) {
+            planes[p] = out;
+            for (int row = 0; row < h[p]; ++row) {
+                auto in = frame.plane(p) + size_t(row) * frame.stride(p);
+                out = std::copy(in, in + w[p], out);
+            }
         }
     }
 
     TOXAV_ERR_SEND_FRAME error;
     toxav_video_send_frame(m_av,
                            nr,
-                           img.width(),
-                           img.height(),
-                           y.data(),
-                           u.data(),
-                           v.data(),
+                           frame.width(),
+                           frame.height(),
+                           planes[0],
+                           planes[1],
+                           planes[2],
                            &error);
     if (error != TOXAV_ERR_SEND_FRAME_OK) {
         throw exception(error);
     }
 }
 
+av::i420 av::i420::from_image(const image& img) {
+    int w = img.width();
+    int h = img.height();
+    int cw = w / 2;
+    int ch = h / 2;
+    auto mem = std::make_shared<std::vector<uint8_t>>(size_t(w) * h + 2 * size_t(cw) * ch);
+    uint8_t* y = mem->data();
+    uint8_t* u = y + size_t(w) * h;
+    uint8_t* v = u + size_t(cw) * ch;
+    auto px = img.data();
+
+    //BT.601 full range in 8.8 fixed point, same as pixel::as_yuv
+    for (int i = 0, n = w * h; i < n; ++i) {
+        int r = px[i].red();
+        int g = px[i].green();
+        int b = px[i].blue();
+        y[i] = (77 * r + 150 * g + 29 * b + 128) >> 8;
+    }
+    //chroma of the 2x2 block average
+    for (int cy = 0; cy < ch; ++cy) {
+        for (int cx = 0; cx < cw; ++cx) {
+            auto p0 = px + (cy * 2) * w + cx * 2;
+            auto p1 = p0 + w;
+            int r = (p0[0].red()   + p0[1].red()   + p1[0].red()   + p1[1].red()   + 2) >> 2;
+            int g = (p0[0].green() + p0[1].green() + p1[0].green() + p1[1].green() + 2) >> 2;
+            int b = (p0[0].blue()  + p0[1].blue()  + p1[0].blue()  + p1[1].blue()  + 2) >> 2;
+            //offset keeps the sum positive before the shift
+            int cu = (-43 * r -  85 * g + 128 * b + 32768 + 128) >> 8;
+            int cv = (128 * r - 107 * g -  21 * b + 32768 + 128) >> 8;
+            u[cx + cy * cw] = std::min(cu, 255);
+            v[cx + cy * cw] = std::min(cv, 255);
+        }
+    }
+
+    return i420(w, h, y, u, v, w, cw, cw, mem);
+}
+
 av::~av() {
     m_update_interval.disconnect();
     if (m_av) {
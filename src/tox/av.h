@@ -21,6 +21,7 @@
 
 #include "types.h"
 #include <tox/toxav.h>
+#include <set>
 #include "utils.h"
 
 namespace toxmm {
@@ -100,6 +101,64 @@ namespace toxmm {
                     }
             };
 
+            /**
+             * @brief Planar YUV 4:2:0 frame, the format toxav sends.
+             *
+             * The planes may point into memory owned by someone else,
+             * for example a mapped GstBuffer, which owner keeps alive.
+             */
+            class i420 {
+                private:
+                    int m_w = 0;
+                    int m_h = 0;
+                    const uint8_t* m_planes[3] = {nullptr, nullptr, nullptr};
+                    int m_strides[3] = {0, 0, 0};
+                    std::shared_ptr<const void> m_owner;
+                    gint64 m_timestamp = 0;
+                public:
+                    i420() {}
+                    i420(int w, int h,
+                         const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                         int y_stride, int u_stride, int v_stride,
+                         std::shared_ptr<const void> owner,
+                         gint64 timestamp = g_get_monotonic_time())
+                        : m_w(w),
+                          m_h(h),
+                          m_planes{y, u, v},
+                          m_strides{y_stride, u_stride, v_stride},
+                          m_owner(owner),
+                          m_timestamp(timestamp) {}
+
+                    //! converts to a new owned frame
+                    static i420 from_image(const image& img);
+
+                    int width() const {
+                        return m_w;
+                    }
+                    int height() const {
+                        return m_h;
+                    }
+                    const uint8_t* plane(int i) const {
+                        return m_planes[i];
+                    }
+                    int stride(int i) const {
+                        return m_strides[i];
+                    }
+                    //! g_get_monotonic_time() of the capture
+                    gint64 timestamp() const {
+                        return m_timestamp;
+                    }
+                    bool empty() const {
+                        return m_planes[0] == nullptr;
+                    }
+                    //! rows without padding, the layout toxav expects
+                    bool packed() const {
+                        return m_strides[0] == m_w &&
+                               m_strides[1] == m_w / 2 &&
+                               m_strides[2] == m_w / 2;
+                    }
+            };
+
             class audio {
                 public:
                     enum sr {
@@ -166,6 +225,10 @@ namespace toxmm {
                     size_t size() const {
                         return m_data->size();
                     }
+                    //! no copy shares the samples, safe to overwrite
+                    bool unique() const {
+                        return m_data.use_count() == 1;
+                    }
             };
 
             std::shared_ptr<toxmm::core> core();
@@ -181,10 +244,14 @@ namespace toxmm {
             void set_bit_rate(contactNr nr,
                               int32_t audio_bit_rate,
                               int32_t video_bit_rate);
+            //! a call was started or answered and didn't end yet
+            bool in_call() const;
             void send_audio_frame(contactNr nr,
                                   const audio &ad);
             void send_video_frame(contactNr nr,
                                   const image &img);
+            void send_video_frame(contactNr nr,
+                                  const i420 &frame);
 
             ~av();
 
@@ -192,6 +259,10 @@ namespace toxmm {
             ToxAV* m_av;
             std::weak_ptr<toxmm::core> m_core;
             sigc::connection m_update_interval;
+            //friends with a running call
+            std::set<uint32_t> m_calls;
+            //repacked planes of padded frames, reused
+            std::vector<uint8_t> m_scratch;
 
             av(const std::shared_ptr<toxmm::core>& core);
             av(const av&) = delete;
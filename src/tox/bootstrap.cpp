@@ -0,0 +1,368 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "bootstrap.h"
+#include "core.h"
+#include "exception.h"
+#include "flatbuffers/generated/Bootstrap_generated.h"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <iostream>
+
+using namespace toxmm;
+
+namespace {
+    //nodes tried when we go offline, before waiting for the next round
+    const size_t first_round_nodes = 4;
+    const size_t round_nodes = 2;
+    const double round_interval = 5;
+    //while online only refresh one node every now and then
+    const double online_interval = 60;
+    //assumed latency for nodes that never got us online
+    const double unknown_latency = 10;
+}
+
+double bootstrap::node::score() const {
+    //laplace smoothed success rate, divided by the expected latency
+    double rate = (successes + 1.0) / (attempts + 2.0);
+    double lat  = successes ? latency : unknown_latency;
+    return rate / (1.0 + lat / unknown_latency);
+}
+
+bootstrap::bootstrap(std::shared_ptr<toxmm::core> core):
+    Glib::ObjectBase(typeid(bootstrap)),
+    m_core(core) {
+    m_property_time_to_online = 0.0;
+}
+
+std::shared_ptr<toxmm::core> bootstrap::core() {
+    return m_core.lock();
+}
+
+void bootstrap::init() {
+    auto c = core();
+    if (!c) {
+        return;
+    }
+
+    load_flatbuffer();
+
+    m_last_connection = c->property_connection();
+    m_offline_timer.reset();
+    m_round_timer.reset();
+
+    c->property_connection().signal_changed().connect(sigc::track_obj([this]() {
+        on_connection_changed();
+    }, *this));
+}
+
+const std::vector<bootstrap::node>& bootstrap::get_all() {
+    return m_nodes;
+}
+
+std::vector<size_t> bootstrap::ranked() {
+    std::vector<size_t> order(m_nodes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return m_nodes[a].score() > m_nodes[b].score();
+    });
+    return order;
+}
+
+void bootstrap::update() {
+    auto c = core();
+    if (!c || m_nodes.empty()) {
+        return;
+    }
+
+    if (c->property_connection() != TOX_CONNECTION_NONE) {
+        if (m_round_timer.elapsed() < online_interval) {
+            return;
+        }
+        //keep the dht fed with a known good node, no bookkeeping
+        auto& best = m_nodes[ranked().front()];
+        try_host(best.ipv4, best.port, best.pubkey);
+        try_host(best.ipv6, best.port, best.pubkey);
+        m_round_timer.reset();
+        return;
+    }
+
+    if (!m_first_round && m_round_timer.elapsed() < round_interval) {
+        return;
+    }
+
+    //the best nodes not tried since we went offline, the ranking
+    //changes as attempts fail
+    auto order = ranked();
+    auto count = m_first_round ? first_round_nodes : round_nodes;
+    size_t tried = 0;
+    for (auto index : order) {
+        if (tried == count) {
+            break;
+        }
+        if (pending(index)) {
+            continue;
+        }
+        try_node(index);
+        ++tried;
+    }
+    //tried all of them, start over with the best
+    if (tried == 0) {
+        for (size_t i = 0; i < std::min(count, order.size()); ++i) {
+            try_node(order[i]);
+        }
+    }
+    //explore, so bad scored nodes get a chance to recover
+    if (!m_first_round) {
+        try_node(rand() % m_nodes.size());
+    }
+
+    m_first_round = false;
+    m_round_timer.reset();
+}
+
+void bootstrap::try_node(size_t index) {
+    auto& n = m_nodes[index];
+    n.attempts += 1;
+    //ipv4 and ipv6 of the same node count as one attempt
+    auto ok_ipv4 = try_host(n.ipv4, n.port, n.pubkey);
+    auto ok_ipv6 = try_host(n.ipv6, n.port, n.pubkey);
+    //a retried node keeps its first try, it's credited once
+    if ((ok_ipv4 || ok_ipv6) && !pending(index)) {
+        m_pending.emplace_back(index, m_offline_timer.elapsed());
+    }
+}
+
+bool bootstrap::pending(size_t index) const {
+    return std::any_of(m_pending.begin(), m_pending.end(), [&](const std::pair<size_t, double>& p) {
+        return p.first == index;
+    });
+}
+
+bool bootstrap::try_host(const std::string& host, uint16_t port, contactAddrPublic pubkey) {
+    auto c = core();
+    if (!c || host.empty()) {
+        return false;
+    }
+    TOX_ERR_BOOTSTRAP berror;
+    if (tox_bootstrap(c->toxcore(), host.c_str(), port, pubkey, &berror)) {
+        return true;
+    }
+    switch (berror) {
+        case TOX_ERR_BOOTSTRAP_BAD_HOST:
+            //host didn't resolve, not fatal, the node just gets a worse score
+            std::cerr << "TOX_ERR_BOOTSTRAP_BAD_HOST on host:" << host << " port:" << port << std::endl;
+            return false;
+        case TOX_ERR_BOOTSTRAP_BAD_PORT:
+            std::cerr << "TOX_ERR_BOOTSTRAP_BAD_PORT on host:" << host << " port:" << port << std::endl;
+            return false;
+        default:
+            throw exception(berror);
+    }
+}
+
+void bootstrap::on_connection_changed() {
+    auto c = core();
+    if (!c) {
+        return;
+    }
+    auto connection = c->property_connection().get_value();
+    auto was_offline = m_last_connection == TOX_CONNECTION_NONE;
+    m_last_connection = connection;
+
+    if (connection == TOX_CONNECTION_NONE) {
+        //start a new offline period
+        m_pending.clear();
+        m_first_round = true;
+        m_offline_timer.reset();
+        return;
+    }
+
+    if (!was_offline) {
+        //only changed between udp and tcp
+        return;
+    }
+
+    auto now = m_offline_timer.elapsed();
+    m_property_time_to_online = now;
+
+    //we can't tell which node got us online, crediting every node we
+    //tried would inflate the scores. The one tried first had the most
+    //time to answer, among those tried together the best ranked one.
+    if (!m_pending.empty()) {
+        auto order = ranked();
+        auto rank = [&](size_t index) {
+            return std::find(order.begin(), order.end(), index) - order.begin();
+        };
+        auto first = std::min_element(m_pending.begin(), m_pending.end(), [&](const std::pair<size_t, double>& a,
+                                                                               const std::pair<size_t, double>& b) {
+            //same round, a few ms apart
+            if (std::abs(a.second - b.second) > 1) {
+                return a.second < b.second;
+            }
+            return rank(a.first) < rank(b.first);
+        });
+        auto& n = m_nodes[first->first];
+        auto latency = now - first->second;
+        if (n.successes == 0) {
+            n.latency = latency;
+        } else {
+            n.latency = n.latency * 0.7 + latency * 0.3;
+        }
+        n.successes += 1;
+        n.last_success = Glib::DateTime::create_now_utc().to_unix();
+    }
+    m_pending.clear();
+    m_round_timer.reset();
+
+    save_flatbuffer();
+}
+
+void bootstrap::load_flatbuffer() {
+    auto c = core();
+    if (!c) {
+        return;
+    }
+
+    m_nodes.clear();
+
+    std::vector<uint8_t> content;
+    c->storage()->load({"toxmm_bootstrap"}, content);
+
+    if (!content.empty()) {
+        auto verify = flatbuffers::Verifier(content.data(), content.size());
+        if (!flatbuffers::Bootstrap::VerifyNodesBuffer(verify)) {
+            throw std::runtime_error("flatbuffers::Bootstrap::VerifyNodesBuffer failed");
+        }
+
+        auto data = flatbuffers::Bootstrap::GetNodes(content.data());
+        auto to_string = [](const flatbuffers::String* str) {
+            return str ? std::string(str->begin(), str->end()) : std::string();
+        };
+        if (data->nodes()) {
+            for (size_t i = 0; i < data->nodes()->size(); ++i) {
+                auto item = data->nodes()->Get(i);
+                auto pubkey = to_string(item->pubkey());
+                if (pubkey.size() != TOX_PUBLIC_KEY_SIZE * 2) {
+                    continue;
+                }
+                node n;
+                n.ipv4         = to_string(item->ipv4());
+                n.ipv6         = to_string(item->ipv6());
+                n.port         = item->port();
+                n.pubkey       = contactAddrPublic(pubkey);
+                n.attempts     = item->attempts();
+                n.successes    = item->successes();
+                n.latency      = item->latency();
+                n.last_success = item->last_success();
+                m_nodes.push_back(n);
+            }
+        }
+    }
+
+    //new shipped nodes get merged into the stored list
+    for (auto& def : default_nodes()) {
+        auto iter = std::find_if(m_nodes.begin(), m_nodes.end(), [&](const node& n) {
+            return n.pubkey == def.pubkey;
+        });
+        if (iter == m_nodes.end()) {
+            m_nodes.push_back(def);
+        }
+    }
+}
+
+void bootstrap::save_flatbuffer() {
+    using namespace flatbuffers;
+
+    auto c = core();
+    if (!c) {
+        return;
+    }
+
+    FlatBufferBuilder fbb;
+    std::vector<Offset<Bootstrap::Node>> nodes;
+    nodes.reserve(m_nodes.size());
+    for (auto& n : m_nodes) {
+        auto ipv4   = fbb.CreateString(n.ipv4);
+        auto ipv6   = fbb.CreateString(n.ipv6);
+        auto pubkey = fbb.CreateString(std::string(n.pubkey));
+        Bootstrap::NodeBuilder fb(fbb);
+        fb.add_ipv4(ipv4);
+        fb.add_ipv6(ipv6);
+        fb.add_port(n.port);
+        fb.add_pubkey(pubkey);
+        fb.add_attempts(n.attempts);
+        fb.add_successes(n.successes);
+        fb.add_latency(n.latency);
+        fb.add_last_success(n.last_success);
+        nodes.push_back(fb.Finish());
+    }
+    auto nodes_vec = fbb.CreateVector(nodes);
+    Bootstrap::NodesBuilder fb(fbb);
+    fb.add_nodes(nodes_vec);
+
+    Bootstrap::FinishNodesBuffer(fbb, fb.Finish());
+
+    std::vector<uint8_t> content(fbb.GetBufferPointer(),
+                                 fbb.GetBufferPointer() + fbb.GetSize());
+
+    c->storage()->save({"toxmm_bootstrap"}, content);
+}
+
+//fallback when nothing is stored yet
+std::vector<bootstrap::node> bootstrap::default_nodes() {
+    struct entry {
+        std::string ipv4;
+        std::string ipv6;
+        uint16_t port;
+        std::string pubkey;
+    };
+    static const std::vector<entry> entries = {{
+        {"44.76.60.215",    "2a01:4f8:191:64d6::1",               33445, "04119E835DF3E78BACF0F84235B300546AF8B936F035185E2A8E9E0A67C8924F"},
+        {"23.226.230.47",   "2604:180:1::3ded:b280",              33445, "A09162D68618E742FFBCA1C2C70385E6679604B2D80EA6E84AD0996A1AC8A074"},
+        {"178.21.112.187",  "2a02:2308::216:3eff:fe82:eaef",      33445, "4B2C19E924972CB9B57732FB172F8A8604DE13EEDA2A6234E348983344B23057"},
+        {"195.154.119.113", "2001:bc8:3698:101::1",               33445, "E398A69646B8CEACA9F0B84F553726C1C49270558C57DF5F3C368F05A7D71354"},
+        {"192.210.149.121", "",                                   33445, "F404ABAA1C99A9D37D61AB54898F56793E1DEF8BD46B1038B9D822E8460FAB67"},
+        {"46.38.239.179",   "",                                   33445, "F5A1A38EFB6BD3C2C8AF8B10D85F0F89E931704D349F1D0720C3C4059AF2440A"},
+        {"178.62.250.138",  "2a03:b0c0:2:d0::16:1",               33445, "788236D34978D1D5BD822F0A5BEBD2C53C64CC31CD3149350EE27D4D9A2F9B6B"},
+        {"130.133.110.14",  "2001:6f8:1c3c:babe::14:1",           33445, "461FA3776EF0FA655F1A05477DF1B3B614F7D6B124F7DB1DD4FE3C08B03B640F"},
+        {"104.167.101.29",  "",                                   33445, "5918AC3C06955962A75AD7DF4F80A5D7C34F7DB9E1498D2E0495DE35B3FE8A57"},
+        {"205.185.116.116", "",                                   33445, "A179B09749AC826FF01F37A9613F6B57118AE014D4196A0E1105A98F93A54702"},
+        {"198.98.51.198",   "2605:6400:1:fed5:22:45af:ec10:f329", 33445, "1D5A5F2F5D6233058BF0259B09622FB40B482E4FA0931EB8FD3AB8E7BF7DAF6F"},
+        {"80.232.246.79",   "",                                   33445, "CF6CECA0A14A31717CC8501DA51BE27742B70746956E6676FF423A529F91ED5D"},
+        {"108.61.165.198",  "",                                   33445, "8E7D0B859922EF569298B4D261A8CCB5FEA14FB91ED412A7603A585A25698832"},
+        {"212.71.252.109",  "2a01:7e00::f03c:91ff:fe69:9912",     33445, "C4CEB8C7AC607C6B374E2E782B3C00EA3A63B80D4910B8649CCACDD19F260819"},
+        {"194.249.212.109", "2001:1470:fbfe::109",                33445, "3CEE1F054081E7A011234883BC4FC39F661A55B73637A5AC293DDF1251D9432B"},
+        {"185.25.116.107",  "2a00:7a60:0:746b::3",                33445, "DA4E4ED4B697F2E9B000EEFE3A34B554ACD3F45F5C96EAEA2516DD7FF9AF7B43"},
+        {"192.99.168.140",  "2607:5300:100:200::::667",           33445, "6A4D0607A296838434A6A7DDF99F50EF9D60A2C510BBF31FE538A25CB6B4652F"},
+        {"46.101.197.175",  "2a03:b0c0:3:d0::ac:5001",              443, "CD133B521159541FB1D326DE9850F5E56A6C724B5B8E5EB5CD8D950408E95707"}
+
+    }};
+    std::vector<node> res;
+    res.reserve(entries.size());
+    for (auto& e : entries) {
+        node n;
+        n.ipv4   = e.ipv4;
+        n.ipv6   = e.ipv6;
+        n.port   = e.port;
+        n.pubkey = contactAddrPublic(e.pubkey);
+        res.push_back(n);
+    }
+    return res;
+}
@@ -0,0 +1,93 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef TOXMM_BOOTSTRAP_H
+#define TOXMM_BOOTSTRAP_H
+#include <tox/tox.h>
+#include <glibmm.h>
+#include <memory>
+#include "types.h"
+#include "utils.h"
+
+namespace toxmm {
+    /**
+     * @brief Keeps track of the DHT nodes we bootstrap from.
+     *
+     * The node list is stored in toxmm::storage together with how often
+     * a node got us online and how long it took. Nodes with the best
+     * record are tried first.
+     *
+     * toxcore has no API to list the DHT peers it learns at runtime,
+     * so only the shipped nodes and the ones stored before are ranked.
+     */
+    class bootstrap : public Glib::Object, public std::enable_shared_from_this<bootstrap> {
+            friend class core;
+        public:
+            struct node {
+                std::string ipv4;
+                std::string ipv6;
+                uint16_t port = 0;
+                contactAddrPublic pubkey;
+                uint32_t attempts = 0;
+                uint32_t successes = 0;
+                double latency = 0;
+                uint64_t last_success = 0;
+
+                double score() const;
+            };
+
+            std::shared_ptr<toxmm::core> core();
+
+            const std::vector<node>& get_all();
+
+        private:
+            std::weak_ptr<toxmm::core> m_core;
+
+            std::vector<node> m_nodes;
+            //node index and when we tried it, since we went offline
+            std::vector<std::pair<size_t, double>> m_pending;
+            TOX_CONNECTION m_last_connection = TOX_CONNECTION_NONE;
+
+            Glib::Timer m_round_timer;
+            Glib::Timer m_offline_timer;
+            bool m_first_round = true;
+
+            bootstrap(std::shared_ptr<toxmm::core> core);
+            bootstrap(const bootstrap&) = delete;
+            void operator=(const bootstrap&) = delete;
+
+            void init();
+            void update();
+
+            void try_node(size_t index);
+            bool pending(size_t index) const;
+            bool try_host(const std::string& host, uint16_t port, contactAddrPublic pubkey);
+            void on_connection_changed();
+            std::vector<size_t> ranked();
+
+            void load_flatbuffer();
+            void save_flatbuffer();
+
+            static std::vector<node> default_nodes();
+
+            // Install properties
+            INST_PROP_RO (double, property_time_to_online, "bootstrap-time-to-online")
+    };
+}
+
+#endif
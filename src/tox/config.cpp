@@ -59,11 +59,27 @@ config::config(const std::shared_ptr<toxmm::storage> storage):
                           property_proxy_port()),
                       [this](auto property) {
         property.signal_changed().connect(sigc::track_obj([this]() {
-            this->save_flatbuffer();
+            this->queue_save();
         }, *this));
     });
 }
 
+config::~config() {
+    if (m_save.connected()) {
+        m_save.disconnect();
+        save_flatbuffer();
+    }
+}
+
+void config::queue_save() {
+    //restart the delay, a burst of changes is saved once
+    m_save.disconnect();
+    m_save = Glib::signal_timeout().connect(sigc::track_obj([this]() {
+        save_flatbuffer();
+        return false;
+    }, *this), save_delay_ms, Glib::PRIORITY_LOW);
+}
+
 void config::load_flatbuffer() {
     std::vector<uint8_t> content;
     m_storage->load({"toxmm_config"}, content);
@@ -71,6 +87,7 @@ void config::load_flatbuffer() {
     if (content.empty()) {
         return;
     }
+    m_saved = content;
 
     auto verify = flatbuffers::Verifier(content.data(), content.size());
     if (!flatbuffers::Config::VerifyConfigBuffer(verify)) {
@@ -106,8 +123,12 @@ void config::save_flatbuffer() {
 
     std::vector<uint8_t> content(fbb.GetBufferPointer(),
                                  fbb.GetBufferPointer() + fbb.GetSize());
+    if (content == m_saved) {
+        return;
+    }
 
     m_storage->save({"toxmm_config"}, content);
+    m_saved = content;
 }
 
 std::shared_ptr<config> config::create(const std::shared_ptr<toxmm::storage> storage) {
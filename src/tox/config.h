@@ -27,12 +27,21 @@ namespace toxmm {
     class config : public Glib::Object, public std::enable_shared_from_this<config> {
         public:
             static std::shared_ptr<config> create(const std::shared_ptr<toxmm::storage> storage);
+            //! saves changes that are still waiting for the delay
+            ~config();
+
+            //! changes are saved together, this long after the last one
+            static const unsigned save_delay_ms = 500;
 
         private:
             void load_flatbuffer();
             void save_flatbuffer();
+            void queue_save();
 
             std::shared_ptr<toxmm::storage> m_storage;
+            //what the storage has, to skip saving the same again
+            std::vector<uint8_t> m_saved;
+            sigc::connection m_save;
 
             config(const std::shared_ptr<toxmm::storage> storage);
             config(const config&) = delete;
@@ -47,6 +47,60 @@ std::shared_ptr<toxmm::av> call::av() {
     return cr->av();
 }
 #include<iostream>
+void call::report_dropped_video_frames(unsigned count) {
+    m_property_video_dropped_frames = property_video_dropped_frames() + count;
+    m_video_controller.frames_dropped(count, g_get_monotonic_time());
+}
+
+void call::reset_video_controller() {
+    m_video_controller = video_controller();
+    m_video_controller.suggest(property_suggested_video_kilobitrate());
+    m_property_video_send_failures = 0;
+    m_property_video_dropped_frames = 0;
+    update_video_controller();
+}
+
+void call::update_video_controller() {
+    m_video_controller.update(g_get_monotonic_time());
+    auto& level = m_video_controller.current();
+    //only notify on change, the capture gets rebuilt
+    if (property_video_width() != level.width) {
+        m_property_video_width = level.width;
+    }
+    if (property_video_height() != level.height) {
+        m_property_video_height = level.height;
+    }
+    if (property_video_fps() != level.fps) {
+        m_property_video_fps = level.fps;
+    }
+    if (property_state() != CALL_CANCEL &&
+        property_video_kilobitrate() != 0 &&
+        property_video_kilobitrate() != m_video_controller.kilobitrate()) {
+        property_video_kilobitrate() = m_video_controller.kilobitrate();
+    }
+}
+
+std::shared_ptr<toxmm::jitter_buffer> call::audio_playout() {
+    return m_audio_playout;
+}
+
+void call::reset_audio_playout() {
+    m_audio_playout = std::make_shared<toxmm::jitter_buffer>();
+    update_audio_stats();
+}
+
+void call::update_audio_stats() {
+    auto& jb = *m_audio_playout;
+    if (property_audio_underruns() != jb.underruns()) {
+        m_property_audio_underruns = jb.underruns();
+    }
+    if (property_audio_overruns() != jb.overruns()) {
+        m_property_audio_overruns = jb.overruns();
+    }
+    m_property_audio_latency = jb.latency();
+    m_property_audio_buffer_target = jb.target();
+}
+
 call::call(const std::shared_ptr<toxmm::contact>& contact)
     : Glib::ObjectBase(typeid(call)),
       m_contact(contact) {
@@ -55,7 +109,10 @@ call::call(const std::shared_ptr<toxmm::contact>& contact)
     m_property_remote_state = CALL_CANCEL;
     m_property_suggested_audio_kilobitrate = 30;
     m_property_suggested_video_kilobitrate = 128;
+    m_property_video_send_latency = 0;
     m_prev_call_state = CALL_CANCEL;
+    reset_video_controller();
+    reset_audio_playout();
 
     //install all events
     property_state().signal_changed().connect(sigc::track_obj([this]() {
@@ -71,17 +128,21 @@ call::call(const std::shared_ptr<toxmm::contact>& contact)
                         if (m_prev_call_state != CALL_CANCEL) {
                             break;
                         }
+                        reset_video_controller();
+                        reset_audio_playout();
                         av->call(contact->property_nr(),
                                  property_suggested_audio_kilobitrate(),
-                                 property_suggested_video_kilobitrate());
-                        m_property_video_kilobitrate.set_value(property_suggested_audio_kilobitrate());
-                        m_property_audio_kilobitrate.set_value(property_suggested_video_kilobitrate());
+                                 m_video_controller.kilobitrate());
+                        m_property_video_kilobitrate.set_value(m_video_controller.kilobitrate());
+                        m_property_audio_kilobitrate.set_value(property_suggested_audio_kilobitrate());
                     } else if (m_prev_call_state == CALL_CANCEL) {
+                        reset_video_controller();
+                        reset_audio_playout();
                         av->answer(contact->property_nr(),
                                    property_suggested_audio_kilobitrate(),
-                                   property_suggested_video_kilobitrate());
-                        m_property_video_kilobitrate.set_value(property_suggested_audio_kilobitrate());
-                        m_property_audio_kilobitrate.set_value(property_suggested_video_kilobitrate());
+                                   m_video_controller.kilobitrate());
+                        m_property_video_kilobitrate.set_value(m_video_controller.kilobitrate());
+                        m_property_audio_kilobitrate.set_value(property_suggested_audio_kilobitrate());
                     } else {
                         av->call_control(contact->property_nr(),
                                          TOXAV_CALL_CONTROL_RESUME);
@@ -105,6 +166,7 @@ call::call(const std::shared_ptr<toxmm::contact>& contact)
                     m_property_audio_kilobitrate.set_value(0);
                     m_property_suggested_audio_kilobitrate = 30;
                     m_property_suggested_video_kilobitrate = 128;
+                    reset_video_controller();
                     m_property_remote_state.set_value(CALL_CANCEL);
                     break;
             }
@@ -145,6 +207,40 @@ call::call(const std::shared_ptr<toxmm::contact>& contact)
             }
         }
     }, *this));
+    property_video_frame_i420().signal_changed().connect(sigc::track_obj([this]() {
+        auto contact = toxmm::call::contact();
+        auto av = toxmm::call::av();
+        if (!contact || !av) {
+            return;
+        }
+        auto frame = property_video_frame_i420().get_value();
+        try {
+            av->send_video_frame(contact->property_nr(), frame);
+        } catch (const exception& ex) {
+            if (ex.type() != std::type_index(typeid(TOXAV_ERR_SEND_FRAME))) {
+                throw;
+            }
+            switch (ex.what_id()) {
+                case TOXAV_ERR_SEND_FRAME_FRIEND_NOT_IN_CALL:
+                    return;
+                case TOXAV_ERR_SEND_FRAME_SYNC:
+                case TOXAV_ERR_SEND_FRAME_RTP_FAILED:
+                    //congestion, let the controller back off
+                    m_property_video_send_failures = property_video_send_failures() + 1;
+                    m_video_controller.frame_failed(g_get_monotonic_time());
+                    update_video_controller();
+                    return;
+                default:
+                    throw;
+            }
+        }
+        auto now = g_get_monotonic_time();
+        double latency = (now - frame.timestamp()) / 1000.0;
+        double prev = property_video_send_latency();
+        m_property_video_send_latency = prev > 0 ? prev * 0.9 + latency * 0.1 : latency;
+        m_video_controller.frame_sent(now);
+        update_video_controller();
+    }, *this));
     property_audio_frame().signal_changed().connect(sigc::track_obj([this]() {
         auto contact = toxmm::call::contact();
         auto av = toxmm::call::av();
@@ -187,6 +283,10 @@ call::call(const std::shared_ptr<toxmm::contact>& contact)
     }, *this);
     property_video_kilobitrate().signal_changed().connect(update_kilobitrate);
     property_audio_kilobitrate().signal_changed().connect(update_kilobitrate);
+    signal_suggestion_updated().connect(sigc::track_obj([this]() {
+        m_video_controller.suggest(property_suggested_video_kilobitrate());
+        update_video_controller();
+    }, *this));
     signal_error().connect(sigc::track_obj([this]() {
         property_state() = CALL_CANCEL;
     }, *this));
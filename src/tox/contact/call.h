@@ -22,6 +22,8 @@
 #include <glibmm.h>
 #include "types.h"
 #include "av.h"
+#include "video_controller.h"
+#include "jitter_buffer.h"
 #include "utils.h"
 
 namespace toxmm {
@@ -39,16 +41,33 @@ namespace toxmm {
             std::shared_ptr<toxmm::core> core();
             std::shared_ptr<toxmm::av> av();
 
+            //! frames the capture dropped before they could be sent
+            void report_dropped_video_frames(unsigned count);
+
+            /**
+             * @brief received audio of the current call, pull() it from
+             * the playout device. A new buffer is made for every call.
+             */
+            std::shared_ptr<toxmm::jitter_buffer> audio_playout();
+
         private:
             std::weak_ptr<toxmm::contact> m_contact;
+            video_controller m_video_controller;
+            std::shared_ptr<toxmm::jitter_buffer> m_audio_playout;
 
             call(const std::shared_ptr<toxmm::contact>& contact);
 
             CALL_STATE m_prev_call_state;
 
+            void reset_video_controller();
+            void update_video_controller();
+            void reset_audio_playout();
+            void update_audio_stats();
+
             // Install all properties
             INST_PROP    (CALL_STATE, property_state, "call-state")
             INST_PROP    (av::image , property_video_frame, "call-video-frame")
+            INST_PROP    (av::i420  , property_video_frame_i420, "call-video-frame-i420")
             INST_PROP    (av::audio , property_audio_frame, "call-audio-frame")
             INST_PROP_RO (CALL_STATE, property_remote_state, "call-remote-state")
             INST_PROP_RO (av::image , property_remote_video_frame, "call-remote-video-frame")
@@ -57,6 +76,19 @@ namespace toxmm {
             INST_PROP    (uint32_t  , property_audio_kilobitrate, "call-audio-kilobitrate")
             INST_PROP_RO (uint32_t  , property_suggested_video_kilobitrate, "call-suggested-video-kilobitrate")
             INST_PROP_RO (uint32_t  , property_suggested_audio_kilobitrate, "call-suggested-audio-kilobitrate")
+            //milliseconds from capture to toxav, smoothed
+            INST_PROP_RO (double    , property_video_send_latency, "call-video-send-latency")
+            //capture format picked by the video_controller
+            INST_PROP_RO (int       , property_video_width, "call-video-width")
+            INST_PROP_RO (int       , property_video_height, "call-video-height")
+            INST_PROP_RO (int       , property_video_fps, "call-video-fps")
+            INST_PROP_RO (uint32_t  , property_video_send_failures, "call-video-send-failures")
+            INST_PROP_RO (uint32_t  , property_video_dropped_frames, "call-video-dropped-frames")
+            //state of the audio_playout() jitter buffer, milliseconds
+            INST_PROP_RO (uint32_t  , property_audio_underruns, "call-audio-underruns")
+            INST_PROP_RO (uint32_t  , property_audio_overruns, "call-audio-overruns")
+            INST_PROP_RO (double    , property_audio_latency, "call-audio-latency")
+            INST_PROP_RO (double    , property_audio_buffer_target, "call-audio-buffer-target")
 
             // Install all signals
             INST_SIGNAL (signal_incoming_call     , void)
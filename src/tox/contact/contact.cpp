@@ -24,6 +24,7 @@
 #include "file/manager.h"
 #include "file/file.h"
 #include "call.h"
+#include "log_index.h"
 
 using namespace toxmm;
 
@@ -40,6 +41,10 @@ contact::contact(std::shared_ptr<toxmm::contact_manager> manager, contactNr nr):
     };
     property_name().signal_changed().connect(sigc::track_obj(update_name_or_addr, *this));
     property_addr_public().signal_changed().connect(sigc::track_obj(update_name_or_addr, *this));
+    //only recollate when the displayed name changes
+    property_name_or_addr().signal_changed().connect(sigc::track_obj([this]() {
+        m_property_sort_key = sort_key(property_name_or_addr().get_value());
+    }, *this));
 
     m_property_nr = nr;
     m_property_addr_public = toxcore_get_addr();
@@ -116,16 +121,16 @@ contactAddrPublic contact::toxcore_get_addr() {
         throw std::runtime_error("core() is nullptr");
     }
 
-    contactAddrPublic addr;
+    std::array<uint8_t, TOX_PUBLIC_KEY_SIZE> key;
     TOX_ERR_FRIEND_GET_PUBLIC_KEY error;
-    auto res = tox_friend_get_public_key(c->toxcore(), m_property_nr.get_value(), addr, &error);
+    auto res = tox_friend_get_public_key(c->toxcore(), m_property_nr.get_value(), key.data(), &error);
     if (error != TOX_ERR_FRIEND_GET_PUBLIC_KEY_OK) {
         throw exception(error);
     }
     if (!res) {
         throw exception(TOX_ERR_FRIEND_GET_PUBLIC_KEY(~0));
     }
-    return addr;
+    return contactAddrPublic(key);
 }
 
 Glib::ustring contact::toxcore_get_name() {
@@ -205,6 +210,11 @@ TOX_CONNECTION contact::toxcore_get_connection() {
     return con;
 }
 
+std::string contact::sort_key(const Glib::ustring& name) {
+    //same order as comparing lowercase() names
+    return name.lowercase().collate_key();
+}
+
 std::shared_ptr<receipt> contact::send_message(const std::string& message) {
     auto c = core();
     if (!c) {
@@ -221,6 +231,7 @@ std::shared_ptr<receipt> contact::send_message(const std::string& message) {
     if (error != TOX_ERR_FRIEND_SEND_MESSAGE_OK) {
         throw exception(error);
     }
+    c->wakeup();
     auto r = std::shared_ptr<toxmm::receipt>(new toxmm::receipt(shared_from_this(), receipt));
     m_signal_send_message(message, r);
     return r;
@@ -242,6 +253,7 @@ std::shared_ptr<receipt> contact::send_action (const std::string& action) {
     if (error != TOX_ERR_FRIEND_SEND_MESSAGE_OK) {
         throw exception(error);
     }
+    c->wakeup();
     auto r = std::shared_ptr<toxmm::receipt>(new toxmm::receipt(shared_from_this(), receipt));
     m_signal_send_action(action, r);
     return r;
@@ -263,3 +275,16 @@ std::shared_ptr<toxmm::file_manager> contact::file_manager() {
 std::shared_ptr<toxmm::call> contact::call() {
     return m_call;
 }
+
+std::shared_ptr<toxmm::log_index> contact::log_index() {
+    if (!m_log_index) {
+        auto c = core();
+        if (!c) {
+            return nullptr;
+        }
+        m_log_index = std::make_shared<toxmm::log_index>(
+                          c->storage(),
+                          std::string(property_addr_public().get_value()));
+    }
+    return m_log_index;
+}
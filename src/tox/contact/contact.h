@@ -30,6 +30,7 @@ namespace toxmm {
     class file_manager;
     class receipt;
     class call;
+    class log_index;
     class contact : public Glib::Object, public std::enable_shared_from_this<contact> {
             friend class contact_manager;
             friend class file_manager;
@@ -42,11 +43,20 @@ namespace toxmm {
             std::shared_ptr<toxmm::contact_manager> contact_manager();
             std::shared_ptr<toxmm::file_manager> file_manager();
             std::shared_ptr<toxmm::call> call();
+            //! full-text index over the chat log, created on first use
+            std::shared_ptr<toxmm::log_index> log_index();
+
+            /**
+             * @brief case insensitive collation key, compare the keys
+             * with strcmp instead of comparing the names
+             */
+            static std::string sort_key(const Glib::ustring& name);
 
         private:
             std::weak_ptr<toxmm::contact_manager> m_contact_manager;
             std::shared_ptr<toxmm::file_manager>  m_file_manager;
             std::shared_ptr<toxmm::call>          m_call;
+            std::shared_ptr<toxmm::log_index>     m_log_index;
 
             std::shared_ptr<toxmm::file>  m_avatar_send;
             Glib::RefPtr<Gio::FileMonitor> m_avatar_send_monitor;
@@ -68,6 +78,8 @@ namespace toxmm {
             INST_PROP_RO (contactAddrPublic, property_addr_public, "contact-addr-public")
             INST_PROP_RO (Glib::ustring    , property_name, "contact-name")
             INST_PROP_RO (Glib::ustring    , property_name_or_addr, "contact-name-or-addr")
+            //sort_key() of property_name_or_addr
+            INST_PROP_RO (std::string      , property_sort_key, "contact-sort-key")
             INST_PROP_RO (Glib::ustring    , property_status_message, "contact-status-message")
             INST_PROP_RO (TOX_USER_STATUS  , property_status, "contact-status")
             INST_PROP_RO (TOX_CONNECTION   , property_connection, "contact-connection")
@@ -167,7 +167,10 @@ void contact_manager::init() {
     c->av()->signal_audio_receive_frame().connect(sigc::track_obj([this](contactNr contact_nr, const av::audio& ad) {
         auto contact = find(contact_nr);
         if (contact) {
-            contact->call()->m_property_remote_audio_frame = ad;
+            auto call = contact->call();
+            call->m_audio_playout->push(ad, g_get_monotonic_time());
+            call->update_audio_stats();
+            call->m_property_remote_audio_frame = ad;
         }
     }, *this));
 
@@ -185,11 +188,13 @@ void contact_manager::init() {
     for (size_t i = 0; i < tmp.size(); ++i) {
         m_contact[i] = std::shared_ptr<contact>(new contact(shared_from_this(), contactNr(tmp[i])));
         m_contact[i]->init();
+        index(m_contact[i]);
     }
 }
 
 void contact_manager::destroy() {
     m_contact.clear();
+    m_search_index.clear();
 }
 
 contact_manager::~contact_manager() {
@@ -235,6 +240,7 @@ void contact_manager::add_contact(contactAddrPublic addr_public) {
     auto contact = std::shared_ptr<toxmm::contact>(new toxmm::contact(shared_from_this(), contactNr(nr)));
     contact->init();
     m_contact.push_back(contact);
+    index(contact);
     m_signal_added(contact);
 }
 
@@ -252,6 +258,7 @@ void contact_manager::add_contact(contactAddr addr, const std::string& message)
     auto contact = std::shared_ptr<toxmm::contact>(new toxmm::contact(shared_from_this(), contactNr(nr)));
     contact->init();
     m_contact.push_back(contact);
+    index(contact);
     m_signal_added(contact);
 }
 
@@ -274,9 +281,38 @@ void contact_manager::remove_contact(std::shared_ptr<contact> contact) {
     if (iter != m_contact.end()) {
         m_contact.erase(iter);
     }
+    m_search_index.remove(contact->property_nr().get_value());
     m_signal_removed(contact);
 }
 
+void contact_manager::index(std::shared_ptr<contact> contact) {
+    std::weak_ptr<contact_manager> weak_manager = shared_from_this();
+    auto update = [weak_manager, contact = contact.get()]() {
+        auto manager = weak_manager.lock();
+        if (!manager) {
+            return;
+        }
+        contactNr nr = contact->property_nr().get_value();
+        //removed, and the number might belong to someone else by now
+        if (manager->find(nr).get() != contact) {
+            return;
+        }
+        manager->m_search_index.set(nr, {
+            contact->property_name().get_value(),
+            contact->property_status_message().get_value(),
+            Glib::ustring(contact->property_addr_public().get_value())
+        });
+    };
+    update();
+    contact->property_name().signal_changed().connect(sigc::track_obj(update, *contact));
+    contact->property_status_message().signal_changed().connect(sigc::track_obj(update, *contact));
+}
+
+std::vector<contactNr> contact_manager::search(const Glib::ustring& query) {
+    auto ids = m_search_index.find(query);
+    return std::vector<contactNr>(ids.begin(), ids.end());
+}
+
 std::shared_ptr<toxmm::core> contact_manager::core() {
     return m_core.lock();
 }
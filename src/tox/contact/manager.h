@@ -23,6 +23,7 @@
 #include <memory>
 #include "types.h"
 #include "utils.h"
+#include "search_index.h"
 
 namespace toxmm {
     class contact_manager : public std::enable_shared_from_this<contact_manager> {
@@ -37,6 +38,13 @@ namespace toxmm {
             void add_contact(contactAddr addr, const std::string& message);
             void remove_contact(std::shared_ptr<contact> contact);
 
+            /**
+             * @brief type-ahead search over names, status messages and
+             * public keys
+             * @return matching contacts ordered by contactNr
+             */
+            std::vector<contactNr> search(const Glib::ustring& query);
+
             void destroy();
             ~contact_manager();
 
@@ -46,12 +54,15 @@ namespace toxmm {
             std::weak_ptr<toxmm::core> m_core;
 
             std::vector<std::shared_ptr<contact>> m_contact;
+            search_index m_search_index;
 
             contact_manager(std::shared_ptr<toxmm::core> core);
             contact_manager(const contact_manager&) = delete;
             void operator=(const contact_manager&) = delete;
 
             void init();
+            //! adds the contact to the search index and keeps it updated
+            void index(std::shared_ptr<contact> contact);
 
             // Install signals
             INST_SIGNAL (signal_request, void, contactAddrPublic, Glib::ustring)
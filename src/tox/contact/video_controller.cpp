@@ -0,0 +1,120 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "video_controller.h"
+#include <algorithm>
+
+using namespace toxmm;
+
+const gint64 video_controller::window;
+const gint64 video_controller::hold;
+
+const std::vector<video_controller::level>& video_controller::levels() {
+    //widths are multiples of 8, so I420 rows need no padding
+    static const std::vector<level> l = {
+        { 160, 120, 10,   60},
+        { 320, 240, 15,  150},
+        { 480, 360, 20,  350},
+        { 640, 480, 30, 1000},
+        {1280, 720, 30, 2500}
+    };
+    return l;
+}
+
+void video_controller::suggest(uint32_t kilobitrate) {
+    m_suggested = kilobitrate;
+    auto& l = levels();
+    //highest level the suggestion pays for
+    m_cap = 0;
+    for (size_t i = 1; i < l.size(); ++i) {
+        if (l[i - 1].kilobitrate < kilobitrate) {
+            m_cap = i;
+        }
+    }
+    if (m_window_start < 0) {
+        //first suggestion, start at the top
+        m_level = m_cap;
+    }
+    m_level = std::min(m_level, m_cap);
+}
+
+void video_controller::start_window(gint64 now) {
+    m_window_start = now;
+    m_sent = 0;
+    m_failed = 0;
+    m_dropped = 0;
+}
+
+void video_controller::frame_sent(gint64 now) {
+    if (m_window_start < 0) {
+        start_window(now);
+    }
+    ++m_sent;
+}
+
+void video_controller::frame_failed(gint64 now) {
+    if (m_window_start < 0) {
+        start_window(now);
+    }
+    ++m_failed;
+}
+
+void video_controller::frames_dropped(unsigned count, gint64 now) {
+    if (m_window_start < 0) {
+        start_window(now);
+    }
+    m_dropped += count;
+}
+
+bool video_controller::update(gint64 now) {
+    auto prev = m_level;
+    if (m_window_start < 0) {
+        start_window(now);
+    }
+    if (now - m_window_start >= window) {
+        unsigned total = m_sent + m_failed + m_dropped;
+        bool congested = total > 0 &&
+                         (m_failed * 10 > total || m_dropped * 5 > total);
+        bool clean = m_sent > 0 && m_failed == 0 && m_dropped * 20 <= total;
+
+        if (congested && m_level > 0) {
+            --m_level;
+            m_last_change = now;
+        } else if (clean && m_level < m_cap &&
+                   (m_last_change < 0 || now - m_last_change >= hold)) {
+            ++m_level;
+            m_last_change = now;
+        }
+        start_window(now);
+    }
+    m_level = std::min(m_level, m_cap);
+    return prev != m_level;
+}
+
+const video_controller::level& video_controller::current() const {
+    return levels()[m_level];
+}
+
+uint32_t video_controller::kilobitrate() const {
+    auto budget = current().kilobitrate;
+    return m_suggested ? std::min(budget, m_suggested) : budget;
+}
+
+size_t video_controller::current_index() const {
+    return m_level;
+}
@@ -0,0 +1,81 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef TOXMM_CONTACT_VIDEO_CONTROLLER_H
+#define TOXMM_CONTACT_VIDEO_CONTROLLER_H
+
+#include <glibmm.h>
+#include <vector>
+
+namespace toxmm {
+    /**
+     * @brief Picks the capture format and video bit rate of a call.
+     *
+     * toxav's bit rate suggestion sets the upper limit. Failed sends and
+     * frames dropped before sending step the level down right away, a
+     * few clean seconds step it up again, one level at a time.
+     * Times are g_get_monotonic_time() microseconds.
+     */
+    class video_controller {
+        public:
+            struct level {
+                int width;
+                int height;
+                int fps;
+                uint32_t kilobitrate;
+            };
+
+            static const std::vector<level>& levels();
+
+            //! toxav's bit rate suggestion
+            void suggest(uint32_t kilobitrate);
+
+            void frame_sent(gint64 now);
+            void frame_failed(gint64 now);
+            void frames_dropped(unsigned count, gint64 now);
+
+            /**
+             * @brief evaluates the last window
+             * @return true when current() changed
+             */
+            bool update(gint64 now);
+
+            const level& current() const;
+            //! bit rate for the encoder, never above the suggestion
+            uint32_t kilobitrate() const;
+            size_t current_index() const;
+
+            static const gint64 window = G_USEC_PER_SEC * 2;
+            static const gint64 hold   = G_USEC_PER_SEC * 5;
+
+        private:
+            uint32_t m_suggested = 0;
+            size_t m_cap = 0;
+            size_t m_level = 0;
+
+            gint64 m_window_start = -1;
+            unsigned m_sent = 0;
+            unsigned m_failed = 0;
+            unsigned m_dropped = 0;
+            gint64 m_last_change = -1;
+
+            void start_window(gint64 now);
+    };
+}
+
+#endif
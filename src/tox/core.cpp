@@ -20,42 +20,12 @@
 #include "contact/manager.h"
 #include "exception.h"
 #include "av.h"
-#include <iostream>
+#include "bootstrap.h"
+#include <cctype>
+#include <cstring>
 
 using namespace toxmm;
 
-struct bootstrap_node {
-        std::string ipv4;
-        std::string ipv6;
-        unsigned short port;
-        std::string pubkey;
-};
-
-//TODO: hardcoded for now, somehow move it into a config
-static const std::vector<bootstrap_node>& get_bootstrap_nodes() {
-    static std::vector<bootstrap_node> bootstrap_nodes = {{
-        {"44.76.60.215",    "2a01:4f8:191:64d6::1",               33445, "04119E835DF3E78BACF0F84235B300546AF8B936F035185E2A8E9E0A67C8924F"},
-        {"23.226.230.47",   "2604:180:1::3ded:b280",              33445, "A09162D68618E742FFBCA1C2C70385E6679604B2D80EA6E84AD0996A1AC8A074"},
-        {"178.21.112.187",  "2a02:2308::216:3eff:fe82:eaef",      33445, "4B2C19E924972CB9B57732FB172F8A8604DE13EEDA2A6234E348983344B23057"},
-        {"195.154.119.113", "2001:bc8:3698:101::1",               33445, "E398A69646B8CEACA9F0B84F553726C1C49270558C57DF5F3C368F05A7D71354"},
-        {"192.210.149.121", "",                                   33445, "F404ABAA1C99A9D37D61AB54898F56793E1DEF8BD46B1038B9D822E8460FAB67"},
-        {"46.38.239.179",   "",                                   33445, "F5A1A38EFB6BD3C2C8AF8B10D85F0F89E931704D349F1D0720C3C4059AF2440A"},
-        {"178.62.250.138",  "2a03:b0c0:2:d0::16:1",               33445, "788236D34978D1D5BD822F0A5BEBD2C53C64CC31CD3149350EE27D4D9A2F9B6B"},
-        {"130.133.110.14",  "2001:6f8:1c3c:babe::14:1",           33445, "461FA3776EF0FA655F1A05477DF1B3B614F7D6B124F7DB1DD4FE3C08B03B640F"},
-        {"104.167.101.29",  "",                                   33445, "5918AC3C06955962A75AD7DF4F80A5D7C34F7DB9E1498D2E0495DE35B3FE8A57"},
-        {"205.185.116.116", "",                                   33445, "A179B09749AC826FF01F37A9613F6B57118AE014D4196A0E1105A98F93A54702"},
-        {"198.98.51.198",   "2605:6400:1:fed5:22:45af:ec10:f329", 33445, "1D5A5F2F5D6233058BF0259B09622FB40B482E4FA0931EB8FD3AB8E7BF7DAF6F"},
-        {"80.232.246.79",   "",                                   33445, "CF6CECA0A14A31717CC8501DA51BE27742B70746956E6676FF423A529F91ED5D"},
-        {"108.61.165.198",  "",                                   33445, "8E7D0B859922EF569298B4D261A8CCB5FEA14FB91ED412A7603A585A25698832"},
-        {"212.71.252.109",  "2a01:7e00::f03c:91ff:fe69:9912",     33445, "C4CEB8C7AC607C6B374E2E782B3C00EA3A63B80D4910B8649CCACDD19F260819"},
-        {"194.249.212.109", "2001:1470:fbfe::109",                33445, "3CEE1F054081E7A011234883BC4FC39F661A55B73637A5AC293DDF1251D9432B"},
-        {"185.25.116.107",  "2a00:7a60:0:746b::3",                33445, "DA4E4ED4B697F2E9B000EEFE3A34B554ACD3F45F5C96EAEA2516DD7FF9AF7B43"},
-        {"192.99.168.140",  "2607:5300:100:200::::667",           33445, "6A4D0607A296838434A6A7DDF99F50EF9D60A2C510BBF31FE538A25CB6B4652F"},
-        {"46.101.197.175",  "2a03:b0c0:3:d0::ac:5001",              443, "CD133B521159541FB1D326DE9850F5E56A6C724B5B8E5EB5CD8D950408E95707"}
-    }};
-    return bootstrap_nodes;
-}
-
 core::core(const std::string& profile_path,
            const std::shared_ptr<toxmm::storage>& storage):
     Glib::ObjectBase(typeid(core)),
@@ -73,12 +43,23 @@ void core::save() {
 }
 
 void core::destroy() {
+    if (m_update_source) {
+        g_source_destroy(m_update_source);
+        g_source_unref(m_update_source);
+        m_update_source = nullptr;
+    }
     m_contact_manager->destroy();
     m_contact_manager.reset();
     m_av.reset();
+    m_bootstrap.reset();
 }
 
 core::~core() {
+    if (m_update_source) {
+        g_source_destroy(m_update_source);
+        g_source_unref(m_update_source);
+        m_update_source = nullptr;
+    }
     if (m_toxcore) {
         save();
         tox_kill(m_toxcore);
@@ -120,7 +101,9 @@ std::vector<uint8_t> core::create_state(std::string name, std::string status, co
         throw exception(error);
     }
     //get addr
-    tox_self_get_public_key(m_toxcore, out_addr_public);
+    std::array<uint8_t, TOX_PUBLIC_KEY_SIZE> key;
+    tox_self_get_public_key(m_toxcore, key.data());
+    out_addr_public = contactAddrPublic(key);
     //get state
     std::vector<uint8_t> state(tox_get_savedata_size(m_toxcore));
     tox_get_savedata(m_toxcore, state.data());
@@ -164,7 +147,9 @@ void core::try_load(std::string path, Glib::ustring& out_name, Glib::ustring& ou
     tox_self_get_status_message(m_toxcore, (uint8_t*)out_status.raw().data());
     out_status = fix_utf8(out_status);
     //get addr
-    tox_self_get_public_key(m_toxcore, out_addr_public);
+    std::array<uint8_t, TOX_PUBLIC_KEY_SIZE> key;
+    tox_self_get_public_key(m_toxcore, key.data());
+    out_addr_public = contactAddrPublic(key);
     //check writeable
     out_writeable = m_profile.can_write();
 }
@@ -205,8 +190,9 @@ void core::init() {
 
     //set prefix for storage
     {
-        contactAddrPublic addr_public;
-        tox_self_get_public_key(m_toxcore, addr_public);
+        std::array<uint8_t, TOX_PUBLIC_KEY_SIZE> key;
+        tox_self_get_public_key(m_toxcore, key.data());
+        contactAddrPublic addr_public(key);
         m_storage->set_prefix_key(addr_public);
         m_config = config::create(m_storage);
     }
@@ -235,13 +221,13 @@ void core::init() {
         throw exception(error);
     }
 
-    m_bootstrap_timer.reset();
-
     //install events:
     tox_callback_friend_request(toxcore(), [](Tox*, const uint8_t* addr, const uint8_t* data, size_t len, void* _this) {
+        ((core*)_this)->m_idle_timer.reset();
         ((core*)_this)->m_signal_contact_request(contactAddrPublic(addr), core::fix_utf8(data, len));
     }, this);
     tox_callback_friend_message(toxcore(), [](Tox*, uint32_t nr, TOX_MESSAGE_TYPE type, const uint8_t* message, size_t len, void* _this) {
+        ((core*)_this)->m_idle_timer.reset();
         if (type == TOX_MESSAGE_TYPE_NORMAL) {
             ((core*)_this)->m_signal_contact_message(contactNr(nr), core::fix_utf8(message, len));
         } else {
@@ -260,9 +246,11 @@ void core::init() {
         ((core*)_this)->m_signal_contact_status(contactNr(nr), status);
     }, this);
     tox_callback_friend_typing(toxcore(), [](Tox*, uint32_t nr, bool is_typing, void* _this) {
+        ((core*)_this)->m_idle_timer.reset();
         ((core*)_this)->m_signal_contact_typing(contactNr(nr), is_typing);
     }, this);
     tox_callback_friend_read_receipt(toxcore(), [](Tox*, uint32_t nr, uint32_t receipt, void* _this) {
+        ((core*)_this)->m_idle_timer.reset();
         ((core*)_this)->m_signal_contact_read_receipt(contactNr(nr), receiptNr(receipt));
     }, this);
     tox_callback_friend_connection_status(toxcore(), [](Tox*, uint32_t nr, TOX_CONNECTION status, void* _this) {
@@ -272,16 +260,20 @@ void core::init() {
         ((core*)_this)->m_property_connection = connection_status;
     }, this);
     tox_callback_file_chunk_request(toxcore(), [](Tox*, uint32_t nr, uint32_t file_number, uint64_t position, size_t length, void *_this) {
+        ((core*)_this)->m_idle_timer.reset();
         ((core*)_this)->m_signal_file_chunk_request(contactNr(nr), fileNr(file_number), position, length);
     }, this);
     tox_callback_file_recv(toxcore(), [](Tox*, uint32_t nr, uint32_t file_number, uint32_t kind, uint64_t file_size, const uint8_t *filename, size_t filename_length, void *_this) {
+        ((core*)_this)->m_idle_timer.reset();
         ((core*)_this)->m_signal_file_recv(contactNr(nr), fileNr(file_number), TOX_FILE_KIND(kind), file_size, core::fix_utf8(filename, filename_length));
     }, this);
     tox_callback_file_recv_chunk(toxcore(), [](Tox*, uint32_t nr, uint32_t file_number, uint64_t position, const uint8_t *data, size_t length, void *_this) {
+        ((core*)_this)->m_idle_timer.reset();
         ((core*)_this)->m_signal_file_recv_chunk(contactNr(nr), fileNr(file_number), position, std::vector<uint8_t>(data, data+length));
     }, this);
     tox_callback_file_recv_control(toxcore(), [](Tox*, uint32_t nr, uint32_t file_number, TOX_FILE_CONTROL state, void* _this) {
-       ((core*)_this)->m_signal_file_recv_control(contactNr(nr), fileNr(file_number), state);
+        ((core*)_this)->m_idle_timer.reset();
+        ((core*)_this)->m_signal_file_recv_control(contactNr(nr), fileNr(file_number), state);
     }, this);
 
     //install logic for name_or_addr
@@ -300,9 +292,9 @@ void core::init() {
     contactAddr addr;
     tox_self_get_address(m_toxcore, addr);
     m_property_addr = addr;
-    contactAddrPublic addr_public;
-    tox_self_get_public_key(m_toxcore, addr_public);
-    m_property_addr_public = addr_public;
+    std::array<uint8_t, TOX_PUBLIC_KEY_SIZE> key;
+    tox_self_get_public_key(m_toxcore, key.data());
+    m_property_addr_public = contactAddrPublic(key);
     //get name
     std::string name(tox_self_get_name_size(m_toxcore), 0);
     tox_self_get_name(m_toxcore, (uint8_t*)name.data());
@@ -342,6 +334,8 @@ void core::init() {
     m_av->init();
     m_contact_manager = std::shared_ptr<toxmm::contact_manager>(new toxmm::contact_manager(shared_from_this()));
     m_contact_manager->init();
+    m_bootstrap = std::shared_ptr<toxmm::bootstrap>(new toxmm::bootstrap(shared_from_this()));
+    m_bootstrap->init();
 
     m_contact_manager->signal_added().connect(
                 sigc::track_obj(sigc::hide([this]() {
@@ -352,9 +346,28 @@ void core::init() {
         save();
     }), *this));
 
-    m_update_interval = Glib::signal_timeout()
-                        .connect(sigc::mem_fun(this, &core::update),
-                                 update_optimal_interval());
+    //one source for the whole lifetime, only the ready time gets moved
+    static GSourceFuncs update_funcs = {
+        nullptr,
+        nullptr,
+        [](GSource*, GSourceFunc callback, gpointer data) -> gboolean {
+            return callback(data);
+        },
+        nullptr,
+        nullptr,
+        nullptr
+    };
+    m_update_source = g_source_new(&update_funcs, sizeof(GSource));
+    g_source_set_priority(m_update_source, Glib::PRIORITY_DEFAULT_IDLE);
+    g_source_set_callback(m_update_source, [](gpointer _this) -> gboolean {
+        ((core*)_this)->update();
+        return G_SOURCE_CONTINUE;
+    }, this, nullptr);
+    m_update_due = g_get_monotonic_time() + update_optimal_interval() * 1000;
+    g_source_set_ready_time(m_update_source, m_update_due);
+    g_source_attach(m_update_source, Glib::MainContext::get_default()->gobj());
+    m_stats_timer.reset();
+    m_idle_timer.reset();
 }
 
 std::shared_ptr<toxmm::contact_manager> core::contact_manager() {
@@ -373,70 +386,57 @@ std::shared_ptr<toxmm::av> core::av() {
     return m_av;
 }
 
-bool core::update() {
-    tox_iterate(toxcore());
+std::shared_ptr<toxmm::bootstrap> core::bootstrap() {
+    return m_bootstrap;
+}
 
-    auto timer_wait = 10;
-    auto timer_connections = 5;
-    auto conenction_type = config()->property_connection_udp()
-                           ?TOX_CONNECTION_UDP
-                           :TOX_CONNECTION_TCP;
-    if (property_connection() != conenction_type) {
-        timer_wait = 60;
-        timer_connections = 1;
+void core::update() {
+    //how late we are compared to when we wanted to run
+    auto now = g_get_monotonic_time();
+    m_stats_latency += std::max<gint64>(0, now - m_update_due) / 1000.0;
+    m_stats_wakeups += 1;
+    auto elapsed = m_stats_timer.elapsed();
+    if (elapsed >= 1.0) {
+        m_property_wakeups_per_second = m_stats_wakeups / elapsed;
+        m_property_dispatch_latency = m_stats_latency / m_stats_wakeups;
+        m_stats_wakeups = 0;
+        m_stats_latency = 0;
+        m_stats_timer.reset();
     }
 
-    if (m_bootstrap_timer.elapsed() >= timer_wait) {
-        auto nodes = get_bootstrap_nodes();
-        for (auto i = 0; i < timer_connections; ++i) {
-            auto index = rand() % nodes.size();
-            TOX_ERR_BOOTSTRAP berror;
-            auto pub = from_hex(nodes[index].pubkey);
-            auto host = nodes[index].ipv4;
-            auto port = nodes[index].port;
-            if (!host.empty()) {
-                if (!tox_bootstrap(m_toxcore,
-                                   host.c_str(),
-                                   port, pub.data(),
-                                   &berror)) {
-                    if (berror == TOX_ERR_BOOTSTRAP_BAD_HOST) {
-                        std::cerr << "TOX_ERR_BOOTSTRAP_BAD_HOST on host:" << host << " port:" << port << std::endl;
-                    } else if (berror == TOX_ERR_BOOTSTRAP_BAD_PORT) {
-                        std::cerr << "TOX_ERR_BOOTSTRAP_BAD_PORT on host:" << host << " port:" << port << std::endl;
-                    } else {
-                        throw exception(berror);
-                    }
-                }
-            }
-            host = nodes[index].ipv6;
-            if (!host.empty()) {
-                if (!tox_bootstrap(m_toxcore,
-                                   host.c_str(),
-                                   port, pub.data(),
-                                   &berror)) {
-                    if (berror == TOX_ERR_BOOTSTRAP_BAD_HOST) {
-                        std::cerr << "TOX_ERR_BOOTSTRAP_BAD_HOST on host:" << host << " port:" << port << std::endl;
-                    } else if (berror == TOX_ERR_BOOTSTRAP_BAD_PORT) {
-                        std::cerr << "TOX_ERR_BOOTSTRAP_BAD_PORT on host:" << host << " port:" << port << std::endl;
-                    } else {
-                        throw exception(berror);
-                    }
-                }
-            }
-        }
-        m_bootstrap_timer.reset();
+    tox_iterate(toxcore());
+
+    if (m_bootstrap) {
+        m_bootstrap->update();
     }
 
     //next round:
-    m_update_interval = Glib::signal_timeout()
-                        .connect(sigc::mem_fun(this, &core::update),
-                                 update_optimal_interval(),
-                                 Glib::PRIORITY_DEFAULT_IDLE);
-    return false;
+    if (m_update_source) {
+        m_update_due = g_get_monotonic_time() + update_optimal_interval() * 1000;
+        g_source_set_ready_time(m_update_source, m_update_due);
+    }
+}
+
+void core::wakeup() {
+    if (!m_update_source) {
+        return;
+    }
+    m_idle_timer.reset();
+    m_update_due = g_get_monotonic_time();
+    g_source_set_ready_time(m_update_source, 0);
 }
 
 uint32_t core::update_optimal_interval() {
-    return tox_iteration_interval(m_toxcore);
+    auto interval = tox_iteration_interval(m_toxcore);
+    //a call's audio and video go through tox_iterate too
+    bool in_call = m_av && m_av->in_call();
+    if (property_connection() == TOX_CONNECTION_NONE ||
+        (m_idle_timer.elapsed() * 1000 >= idle_after_ms && !in_call)) {
+        if (interval < low_power_interval) {
+            interval = low_power_interval;
+        }
+    }
+    return interval;
 }
 
 Glib::ustring core::fix_utf8(const std::string& input) {
@@ -447,38 +447,110 @@ Glib::ustring core::fix_utf8(const uint8_t* input, int size) {
     return fix_utf8((const int8_t*)input, size);
 }
 
+namespace {
+    //skips plain ascii (no NUL) 8 bytes at a time, returns the first
+    //position that needs a real utf8 check
+    const gchar* skip_ascii(const gchar* str, const gchar* end) {
+        const uint64_t ones = 0x0101010101010101ull;
+        const uint64_t high = 0x8080808080808080ull;
+        while (end - str >= 8) {
+            uint64_t word;
+            std::memcpy(&word, str, sizeof(word));
+            //any high bit set or any zero byte
+            if ((word & high) || ((word - ones) & ~word & high)) {
+                break;
+            }
+            str += 8;
+        }
+        while (str != end && uint8_t(*str) - 1u < 0x7Fu) {
+            ++str;
+        }
+        return str;
+    }
+}
+
 Glib::ustring core::fix_utf8(const int8_t* input, int size) {
     static const Glib::ustring uFFFD(1, gunichar(0xFFFD));
-    std::string fixed;
-    fixed.reserve(size);
-    const gchar* ginput = (gchar*)input;
-    const gchar* str = ginput;
+    const gchar* str = (const gchar*)input;
+    const gchar* end = str + std::max(size, 0);
     const gchar* last_valid;
-    while(!g_utf8_validate(str, std::distance(str, ginput + size), &last_valid)) {
+
+    //fast path, valid input is copied once into the result
+    auto ascii_end = skip_ascii(str, end);
+    if (ascii_end == end ||
+        g_utf8_validate(ascii_end, end - ascii_end, &last_valid)) {
+        return Glib::ustring(str, end);
+    }
+
+    //slow path, replace each invalid byte with U+FFFD
+    std::string fixed;
+    fixed.reserve(size + uFFFD.bytes());
+    do {
         fixed.append(str, last_valid);
-        fixed.append(uFFFD.raw().begin(), uFFFD.raw().end());
+        fixed.append(uFFFD.raw());
         str = last_valid + 1;
-    }
+    } while (!g_utf8_validate(str, end - str, &last_valid));
     fixed.append(str, last_valid);
     return fixed;
 }
 
-Glib::ustring core::to_hex(const uint8_t* data, size_t len) {
-    std::string s;
+namespace {
+    struct hex_table {
+        //two chars per byte value
+        char encode[256 * 2];
+        //nibble per char, -1 for non-hex chars
+        int8_t decode[256];
+
+        hex_table() {
+            static const char digits[] = "0123456789ABCDEF";
+            for (int i = 0; i < 256; ++i) {
+                encode[i * 2 + 0] = digits[i >> 4];
+                encode[i * 2 + 1] = digits[i & 0xF];
+                decode[i] = -1;
+            }
+            for (int i = 0; i < 16; ++i) {
+                decode[uint8_t(digits[i])] = i;
+                decode[uint8_t(std::tolower(digits[i]))] = i;
+            }
+        }
+    };
+
+    const hex_table& get_hex_table() {
+        static const hex_table table;
+        return table;
+    }
+}
+
+void core::to_hex(const uint8_t* data, size_t len, char* out) {
+    const auto& table = get_hex_table();
     for (size_t i = 0; i < len; ++i) {
-        static const int8_t hex[] = "0123456789ABCDEF";
-        s += hex[(data[i] >> 4) & 0xF];
-        s += hex[data[i] & 0xF];
+        const char* hex = table.encode + data[i] * 2;
+        out[i * 2 + 0] = hex[0];
+        out[i * 2 + 1] = hex[1];
+    }
+}
+
+void core::from_hex(const char* data, size_t len, uint8_t* out) {
+    const auto& table = get_hex_table();
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        auto hi = table.decode[uint8_t(data[i + 0])];
+        auto lo = table.decode[uint8_t(data[i + 1])];
+        if ((hi | lo) < 0) {
+            throw std::invalid_argument("core::from_hex invalid character");
+        }
+        out[i / 2] = uint8_t((hi << 4) | lo);
     }
+}
+
+Glib::ustring core::to_hex(const uint8_t* data, size_t len) {
+    std::string s(len * 2, 0);
+    to_hex(data, len, &s[0]);
     return s;
 }
 
 std::vector<uint8_t> core::from_hex(std::string data) {
-    std::vector<uint8_t> tmp;
-    tmp.reserve(tmp.size() / 2);
-    for (size_t i = 0; i < data.size(); i += 2) {
-        tmp.push_back(std::stoi(data.substr(i, 2), 0, 16));  // pretty stupid
-    }
+    std::vector<uint8_t> tmp(data.size() / 2);
+    from_hex(data.data(), data.size(), tmp.data());
     return tmp;
 }
 
@@ -35,11 +35,31 @@ namespace toxmm {
             static Glib::ustring fix_utf8(const int8_t* input, int size);
             static Glib::ustring to_hex(const uint8_t* data, size_t len);
             static std::vector<uint8_t> from_hex(std::string data);
+            /**
+             * @brief writes exactly len * 2 uppercase hex chars to out,
+             * no allocation
+             */
+            static void to_hex(const uint8_t* data, size_t len, char* out);
+            /**
+             * @brief decodes len / 2 bytes into out, accepts upper and
+             * lowercase, throws std::invalid_argument on other chars
+             */
+            static void from_hex(const char* data, size_t len, uint8_t* out);
+
+            //! no events for this long counts as idle, unless in a call
+            static const unsigned idle_after_ms = 10000;
+            //! iteration interval while offline or idle
+            static const uint32_t low_power_interval = 250;
 
             static std::shared_ptr<core> create(const std::string& profile_path,
                                                 const std::shared_ptr<storage>& storage);
             void save();
             uint32_t update_optimal_interval();
+            /**
+             * @brief iterate toxcore as soon as possible, call this after
+             * queueing outgoing data
+             */
+            void wakeup();
             void destroy();
             ~core();
             Tox* toxcore();
@@ -47,6 +67,7 @@ namespace toxmm {
             std::shared_ptr<toxmm::config> config();
             std::shared_ptr<toxmm::storage> storage();
             std::shared_ptr<toxmm::av> av();
+            std::shared_ptr<toxmm::bootstrap> bootstrap();
             static void try_load(std::string path, Glib::ustring& out_name, Glib::ustring& out_status, contactAddrPublic& out_addr, bool& out_writeable);
             static std::vector<uint8_t> create_state(std::string name, std::string status, contactAddrPublic& out_addr);
 
@@ -60,10 +81,15 @@ namespace toxmm {
             std::shared_ptr<toxmm::storage> m_storage;
             std::shared_ptr<toxmm::contact_manager> m_contact_manager;
             std::shared_ptr<toxmm::av> m_av;
-            sigc::connection m_update_interval;
+            std::shared_ptr<toxmm::bootstrap> m_bootstrap;
+            GSource* m_update_source = nullptr;
+            gint64 m_update_due = 0;
+            Glib::Timer m_idle_timer;
+            Glib::Timer m_stats_timer;
+            unsigned m_stats_wakeups = 0;
+            double m_stats_latency = 0;
 
             profile m_profile;
-            Glib::Timer m_bootstrap_timer;
 
             core(const std::string& profile_path,
                  const std::shared_ptr<toxmm::storage>& storage);
@@ -71,7 +97,7 @@ namespace toxmm {
             void operator=(const core&) = delete;
 
             void init();
-            bool update();
+            void update();
 
             // Install properties
             INST_PROP_RO (contactAddr       , property_addr, "core-addr")
@@ -81,6 +107,8 @@ namespace toxmm {
             INST_PROP    (Glib::ustring     , property_status_message, "core-status-message")
             INST_PROP    (TOX_USER_STATUS   , property_status, "core-status")
             INST_PROP_RO (TOX_CONNECTION    , property_connection, "core-connection")
+            INST_PROP_RO (double            , property_wakeups_per_second, "core-wakeups-per-second")
+            INST_PROP_RO (double            , property_dispatch_latency, "core-dispatch-latency")
 
             // Install signals
             INST_SIGNAL (signal_contact_request           , void, contactAddrPublic, Glib::ustring)
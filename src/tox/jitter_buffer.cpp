@@ -0,0 +1,173 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "jitter_buffer.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace toxmm;
+
+const int jitter_buffer::rate;
+const int jitter_buffer::channels;
+
+audio_ring::audio_ring(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    m_data.resize(size);
+    m_mask = size - 1;
+}
+
+size_t audio_ring::capacity() const {
+    return m_data.size();
+}
+
+size_t audio_ring::available() const {
+    return m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_relaxed);
+}
+
+bool audio_ring::write(const int16_t* data, size_t count) {
+    size_t w = m_write.load(std::memory_order_relaxed);
+    size_t r = m_read.load(std::memory_order_acquire);
+    if (count > capacity() - (w - r)) {
+        return false;
+    }
+    size_t pos = w & m_mask;
+    size_t first = std::min(count, capacity() - pos);
+    std::copy(data, data + first, m_data.begin() + pos);
+    std::copy(data + first, data + count, m_data.begin());
+    m_write.store(w + count, std::memory_order_release);
+    return true;
+}
+
+size_t audio_ring::read(int16_t* data, size_t count) {
+    size_t r = m_read.load(std::memory_order_relaxed);
+    size_t w = m_write.load(std::memory_order_acquire);
+    count = std::min(count, w - r);
+    size_t pos = r & m_mask;
+    size_t first = std::min(count, capacity() - pos);
+    std::copy(m_data.begin() + pos, m_data.begin() + pos + first, data);
+    std::copy(m_data.begin(), m_data.begin() + (count - first), data + first);
+    m_read.store(r + count, std::memory_order_release);
+    return count;
+}
+
+size_t audio_ring::skip(size_t count) {
+    size_t r = m_read.load(std::memory_order_relaxed);
+    size_t w = m_write.load(std::memory_order_acquire);
+    count = std::min(count, w - r);
+    m_read.store(r + count, std::memory_order_release);
+    return count;
+}
+
+jitter_buffer::jitter_buffer():
+    m_ring(rate * channels),
+    m_target(size_t(rate) * channels * 60 / 1000) {
+}
+
+void jitter_buffer::push(const av::audio& frame, gint64 now) {
+    if (frame.sample_count() == 0 || frame.sampling_rate() <= 0) {
+        return;
+    }
+    double frame_us = frame.sample_count() * 1000000.0 / frame.sampling_rate();
+    if (m_last_arrival >= 0) {
+        //interarrival jitter as in RFC 3550
+        double d = std::abs(double(now - m_last_arrival) - frame_us);
+        m_jitter += (d - m_jitter) / 16.0;
+
+        double target_us = std::min(std::max(frame_us * 2 + m_jitter * 3, 20000.0), 300000.0);
+        m_target = size_t(target_us * rate / 1000000.0) * channels;
+    }
+    m_last_arrival = now;
+
+    resample(frame);
+    if (!m_ring.write(m_resampled.data(), m_resampled.size())) {
+        ++m_overruns;
+    }
+}
+
+void jitter_buffer::resample(const av::audio& frame) {
+    int ch = frame.channels();
+    int sr = frame.sampling_rate();
+    size_t n = frame.sample_count();
+    //all toxav rates divide 48 kHz, linear interpolation is enough for speech
+    int factor = std::max(1, (rate + sr / 2) / sr);
+
+    m_resampled.resize(n * factor * channels);
+    auto in = frame.data();
+    auto out = m_resampled.data();
+    for (size_t i = 0; i < n; ++i) {
+        int cur[channels];
+        for (int c = 0; c < channels; ++c) {
+            cur[c] = in[i * ch + std::min(c, ch - 1)];
+        }
+        for (int k = 1; k <= factor; ++k) {
+            for (int c = 0; c < channels; ++c) {
+                *out++ = int16_t(m_last[c] + (cur[c] - m_last[c]) * k / factor);
+            }
+        }
+        for (int c = 0; c < channels; ++c) {
+            m_last[c] = int16_t(cur[c]);
+        }
+    }
+}
+
+void jitter_buffer::pull(int16_t* out, size_t count) {
+    size_t avail = m_ring.available();
+    size_t target = m_target;
+
+    if (m_buffering) {
+        if (avail < target) {
+            std::fill(out, out + count, 0);
+            m_buffered = avail;
+            return;
+        }
+        m_buffering = false;
+    }
+
+    //drain down to the target when too much piled up
+    if (avail > target * 2 + count) {
+        m_ring.skip(avail - target);
+        ++m_overruns;
+    }
+
+    size_t got = m_ring.read(out, count);
+    if (got < count) {
+        std::fill(out + got, out + count, 0);
+        ++m_underruns;
+        m_buffering = true;
+    }
+    m_buffered = m_ring.available();
+}
+
+uint32_t jitter_buffer::underruns() const {
+    return m_underruns;
+}
+
+uint32_t jitter_buffer::overruns() const {
+    return m_overruns;
+}
+
+double jitter_buffer::latency() const {
+    return m_buffered * 1000.0 / (rate * channels);
+}
+
+double jitter_buffer::target() const {
+    return m_target * 1000.0 / (rate * channels);
+}
@@ -0,0 +1,105 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef TOXMM_JITTER_BUFFER_H
+#define TOXMM_JITTER_BUFFER_H
+
+#include <glibmm.h>
+#include <atomic>
+#include <vector>
+#include "av.h"
+
+namespace toxmm {
+    /**
+     * @brief Single producer, single consumer ring of samples. Lock-free.
+     */
+    class audio_ring {
+        public:
+            //! capacity gets rounded up to a power of two
+            audio_ring(size_t capacity);
+
+            size_t capacity() const;
+            //! consumer side, samples ready to read
+            size_t available() const;
+
+            //! producer, returns false and writes nothing when it doesn't fit
+            bool write(const int16_t* data, size_t count);
+            //! consumer, reads up to count samples
+            size_t read(int16_t* data, size_t count);
+            //! consumer, throws away up to count samples
+            size_t skip(size_t count);
+
+        private:
+            std::vector<int16_t> m_data;
+            size_t m_mask;
+            std::atomic<size_t> m_write{0};
+            std::atomic<size_t> m_read{0};
+    };
+
+    /**
+     * @brief Buffers received call audio for playout.
+     *
+     * Frames of any toxav sampling rate are resampled to 48 kHz stereo.
+     * The buffering target follows the measured arrival jitter. The
+     * consumer drains down to the target when too much piles up and
+     * plays silence while refilling after an underrun.
+     *
+     * push() and pull() may run on different threads, one each.
+     */
+    class jitter_buffer {
+        public:
+            static const int rate = 48000;
+            static const int channels = 2;
+
+            jitter_buffer();
+
+            void push(const av::audio& frame, gint64 now);
+            //! always fills count samples, silence if there is nothing
+            void pull(int16_t* out, size_t count);
+
+            //! playout ran dry
+            uint32_t underruns() const;
+            //! frames rejected because the ring was full and drains to target
+            uint32_t overruns() const;
+            //! buffered audio in milliseconds
+            double latency() const;
+            //! what the buffer aims to keep, in milliseconds
+            double target() const;
+
+        private:
+            audio_ring m_ring;
+
+            //producer
+            gint64 m_last_arrival = -1;
+            double m_jitter = 0; //microseconds
+            int16_t m_last[channels] = {0, 0};
+            std::vector<int16_t> m_resampled;
+
+            //consumer
+            bool m_buffering = true;
+
+            std::atomic<size_t> m_target;
+            std::atomic<size_t> m_buffered{0};
+            std::atomic<uint32_t> m_underruns{0};
+            std::atomic<uint32_t> m_overruns{0};
+
+            void resample(const av::audio& frame);
+    };
+}
+
+#endif
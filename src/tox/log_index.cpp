@@ -0,0 +1,476 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "log_index.h"
+#include "flatbuffers/generated/LogIndex_generated.h"
+#include "flatbuffers/generated/LogManifest_generated.h"
+#include <algorithm>
+
+using namespace toxmm;
+
+namespace {
+    //bump to drop indexes written by older versions, they get rebuilt
+    const int manifest_version = 1;
+    //longer words are cut, queries get cut the same way
+    const size_t max_word = 64;
+
+    //utf-8 continuation and lead bytes count as word characters
+    bool is_word(unsigned char c) {
+        return c >= 0x80 || g_ascii_isalnum(c);
+    }
+
+    uint64_t pack(uint32_t day, uint32_t item) {
+        return (uint64_t(day) << 32) | item;
+    }
+
+    uint32_t first_of_month(uint32_t day) {
+        Glib::Date date(day);
+        return Glib::Date(1, date.get_month(), date.get_year()).get_julian();
+    }
+
+    void insert(std::map<std::string, std::vector<uint64_t>>& out,
+                uint32_t day, uint32_t item,
+                const std::vector<Glib::ustring>& texts) {
+        auto posting = pack(day, item);
+        for (auto& text : texts) {
+            for (auto& word : log_index::words(text)) {
+                auto& list = out[word];
+                if (list.empty() || list.back() != posting) {
+                    list.push_back(posting);
+                }
+            }
+        }
+    }
+}
+
+log_index::log_index(std::shared_ptr<toxmm::storage> storage, const std::string& key):
+    m_storage(storage),
+    m_key(key) {
+}
+
+log_index::~log_index() {
+    m_save.disconnect();
+    save_open();
+}
+
+std::vector<std::string> log_index::words(const Glib::ustring& text) {
+    std::vector<std::string> res;
+    const std::string folded = text.casefold().raw();
+    size_t pos = 0;
+    while (pos < folded.size()) {
+        while (pos < folded.size() && !is_word(folded[pos])) {
+            ++pos;
+        }
+        auto begin = pos;
+        while (pos < folded.size() && is_word(folded[pos])) {
+            ++pos;
+        }
+        auto len = pos - begin;
+        if (len == 0) {
+            continue;
+        }
+        if (len > max_word) {
+            //don't cut a character in half
+            len = max_word;
+            while (len > 0 && (folded[begin + len] & 0xC0) == 0x80) {
+                --len;
+            }
+        }
+        res.emplace_back(folded, begin, len);
+    }
+    return res;
+}
+
+void log_index::load_manifest() {
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    std::vector<uint8_t> content;
+    m_storage->load({m_key, "index", "manifest"}, content);
+    if (content.empty()) {
+        return;
+    }
+    //the index can always be rebuilt from the logs,
+    //so a broken one is dropped instead of throwing
+    auto verify = flatbuffers::Verifier(content.data(), content.size());
+    if (!flatbuffers::LogManifest::VerifyManifestBuffer(verify)) {
+        return;
+    }
+    auto data = flatbuffers::LogManifest::GetManifest(content.data());
+    if (data->version() != manifest_version) {
+        return;
+    }
+    if (data->days()) {
+        m_days.assign(data->days()->begin(), data->days()->end());
+    }
+    if (data->day_segments()) {
+        m_day_segments.insert(data->day_segments()->begin(), data->day_segments()->end());
+    }
+    if (data->month_segments()) {
+        m_month_segments.insert(data->month_segments()->begin(), data->month_segments()->end());
+    }
+    m_complete = data->complete();
+}
+
+void log_index::save_manifest() {
+    flatbuffers::FlatBufferBuilder fbb;
+    std::vector<uint32_t> day_segments(m_day_segments.begin(), m_day_segments.end());
+    std::vector<uint32_t> month_segments(m_month_segments.begin(), m_month_segments.end());
+    auto days_offset = fbb.CreateVector(m_days);
+    auto day_segments_offset = fbb.CreateVector(day_segments);
+    auto month_segments_offset = fbb.CreateVector(month_segments);
+    flatbuffers::LogManifest::FinishManifestBuffer(
+                fbb,
+                flatbuffers::LogManifest::CreateManifest(
+                    fbb,
+                    manifest_version,
+                    days_offset,
+                    day_segments_offset,
+                    month_segments_offset,
+                    m_complete));
+    m_storage->save({m_key, "index", "manifest"},
+                    std::vector<uint8_t>(fbb.GetBufferPointer(),
+                                         fbb.GetBufferPointer() + fbb.GetSize()));
+}
+
+void log_index::add_day(uint32_t day) {
+    auto iter = std::lower_bound(m_days.begin(), m_days.end(), day);
+    if (iter == m_days.end() || *iter != day) {
+        m_days.insert(iter, day);
+    }
+}
+
+std::string log_index::segment_name(uint32_t day, bool month) {
+    return Glib::Date(day).format_string(month ? "%Y-%m" : "%Y-%m-%d");
+}
+
+std::vector<uint8_t>& log_index::cache(const std::string& name) {
+    auto iter = m_cache.find(name);
+    if (iter != m_cache.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, iter->second.lru);
+        return iter->second.content;
+    }
+    while (m_cache.size() >= cache_segments) {
+        m_cache.erase(m_lru.back());
+        m_lru.pop_back();
+    }
+    m_lru.push_front(name);
+    auto& entry = m_cache[name];
+    entry.lru = m_lru.begin();
+    return entry.content;
+}
+
+void log_index::uncache(const std::string& name) {
+    auto iter = m_cache.find(name);
+    if (iter != m_cache.end()) {
+        m_lru.erase(iter->second.lru);
+        m_cache.erase(iter);
+    }
+}
+
+const std::vector<uint8_t>& log_index::segment(const std::string& name) {
+    if (m_cache.count(name)) {
+        return cache(name);
+    }
+    auto& content = cache(name);
+    m_storage->load({m_key, "index", name}, content);
+    auto verify = flatbuffers::Verifier(content.data(), content.size());
+    if (!content.empty() && !flatbuffers::LogIndex::VerifySegmentBuffer(verify)) {
+        //lost, the next rebuild brings it back
+        content.clear();
+        if (m_complete) {
+            m_complete = false;
+            save_manifest();
+        }
+    }
+    return content;
+}
+
+void log_index::read(const std::string& name, postings& out) {
+    auto& content = segment(name);
+    if (content.empty()) {
+        return;
+    }
+    auto terms = flatbuffers::LogIndex::GetSegment(content.data())->terms();
+    if (!terms) {
+        return;
+    }
+    for (flatbuffers::uoffset_t i = 0; i < terms->size(); ++i) {
+        auto term = terms->Get(i);
+        if (!term->term() || !term->postings()) {
+            continue;
+        }
+        auto& list = out[term->term()->str()];
+        list.insert(list.end(), term->postings()->begin(), term->postings()->end());
+    }
+}
+
+void log_index::write(const std::string& name, postings& in) {
+    flatbuffers::FlatBufferBuilder fbb;
+    std::vector<flatbuffers::Offset<flatbuffers::LogIndex::Term>> terms;
+    terms.reserve(in.size());
+    for (auto& term : in) {
+        auto& list = term.second;
+        if (!std::is_sorted(list.begin(), list.end())) {
+            std::sort(list.begin(), list.end());
+        }
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+        auto term_offset = fbb.CreateString(term.first);
+        auto postings_offset = fbb.CreateVector(list);
+        terms.push_back(flatbuffers::LogIndex::CreateTerm(fbb, term_offset, postings_offset));
+    }
+    flatbuffers::LogIndex::FinishSegmentBuffer(
+                fbb,
+                flatbuffers::LogIndex::CreateSegment(fbb, fbb.CreateVector(terms)));
+
+    auto& content = cache(name);
+    content.assign(fbb.GetBufferPointer(), fbb.GetBufferPointer() + fbb.GetSize());
+    m_storage->save({m_key, "index", name}, content);
+}
+
+void log_index::queue_save() {
+    //restart the delay, a burst of messages is saved once
+    m_save.disconnect();
+    m_save = Glib::signal_timeout().connect([this]() {
+        save_open();
+        return false;
+    }, save_delay_ms, Glib::PRIORITY_LOW);
+}
+
+void log_index::save_open() {
+    m_save.disconnect();
+    if (!m_open_dirty) {
+        return;
+    }
+    m_open_dirty = false;
+    write(segment_name(m_open_day, false), m_open);
+}
+
+void log_index::add(uint32_t day, uint32_t item, const std::vector<Glib::ustring>& texts) {
+    load_manifest();
+    if (m_open_day != day) {
+        save_open();
+        m_open.clear();
+        auto name = segment_name(day, false);
+        read(name, m_open);
+        //only the open day stays unpacked
+        uncache(name);
+        m_open_day = day;
+    }
+    insert(m_open, day, item, texts);
+    m_open_dirty = true;
+    queue_save();
+
+    auto known = m_day_segments.count(day)
+                 && std::binary_search(m_days.begin(), m_days.end(), day);
+    if (!known) {
+        m_day_segments.insert(day);
+        add_day(day);
+        save_manifest();
+    }
+}
+
+void log_index::set_day(uint32_t day, const std::vector<std::vector<Glib::ustring>>& items) {
+    load_manifest();
+    postings p;
+    for (size_t i = 0; i < items.size(); ++i) {
+        insert(p, day, i, items[i]);
+    }
+    auto name = segment_name(day, false);
+    write(name, p);
+    if (m_open_day == day) {
+        m_open = std::move(p);
+        m_open_dirty = false;
+        m_save.disconnect();
+    }
+    m_day_segments.insert(day);
+    add_day(day);
+    save_manifest();
+}
+
+void log_index::compact(uint32_t today) {
+    load_manifest();
+    save_open();
+    auto current = first_of_month(today);
+    std::map<uint32_t, std::vector<uint32_t>> months;
+    for (auto day : m_day_segments) {
+        auto month = first_of_month(day);
+        if (month < current) {
+            months[month].push_back(day);
+        }
+    }
+    if (months.empty()) {
+        return;
+    }
+    for (auto& month : months) {
+        //logs only grow, so the union of all segments is the month
+        postings p;
+        auto name = segment_name(month.first, true);
+        if (m_month_segments.count(month.first)) {
+            read(name, p);
+        }
+        for (auto day : month.second) {
+            read(segment_name(day, false), p);
+        }
+        write(name, p);
+        m_month_segments.insert(month.first);
+        for (auto day : month.second) {
+            auto day_name = segment_name(day, false);
+            m_storage->remove({m_key, "index", day_name});
+            uncache(day_name);
+            m_day_segments.erase(day);
+            if (m_open_day == day) {
+                m_open_day = 0;
+                m_open.clear();
+            }
+        }
+    }
+    save_manifest();
+}
+
+void log_index::find(const std::vector<uint8_t>& segment,
+                     const std::vector<std::string>& words,
+                     std::vector<uint64_t>& out) {
+    if (segment.empty()) {
+        return;
+    }
+    auto terms = flatbuffers::LogIndex::GetSegment(segment.data())->terms();
+    if (!terms || terms->size() == 0) {
+        return;
+    }
+    auto term_at = [&](flatbuffers::uoffset_t i) {
+        auto term = terms->Get(i)->term();
+        return term ? std::string(term->c_str(), term->size()) : std::string();
+    };
+
+    std::vector<uint64_t> result;
+    std::vector<uint64_t> matches;
+    std::vector<uint64_t> tmp;
+    bool first = true;
+    for (auto& word : words) {
+        //binary search the first term >= word
+        flatbuffers::uoffset_t lo = 0;
+        flatbuffers::uoffset_t hi = terms->size();
+        while (lo < hi) {
+            auto mid = lo + (hi - lo) / 2;
+            if (term_at(mid) < word) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        //every term starting with word
+        matches.clear();
+        size_t merged = 0;
+        for (auto i = lo; i < terms->size(); ++i) {
+            auto term = terms->Get(i);
+            if (!term->term() || term->term()->size() < word.size()
+                || std::char_traits<char>::compare(term->term()->c_str(), word.data(), word.size()) != 0) {
+                break;
+            }
+            if (term->postings()) {
+                matches.insert(matches.end(), term->postings()->begin(), term->postings()->end());
+                ++merged;
+            }
+        }
+        if (merged > 1) {
+            std::sort(matches.begin(), matches.end());
+            matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+        }
+        if (first) {
+            result.swap(matches);
+            first = false;
+        } else {
+            tmp.clear();
+            std::set_intersection(result.begin(), result.end(),
+                                  matches.begin(), matches.end(),
+                                  std::back_inserter(tmp));
+            result.swap(tmp);
+        }
+        if (result.empty()) {
+            return;
+        }
+    }
+    out.insert(out.end(), result.begin(), result.end());
+}
+
+std::vector<log_index::hit> log_index::find(const Glib::ustring& query, size_t limit) {
+    load_manifest();
+    save_open();
+    auto query_words = words(query);
+    if (query_words.empty()) {
+        return {};
+    }
+    //longest first, they match the fewest terms
+    std::sort(query_words.begin(), query_words.end(), [](const std::string& a, const std::string& b) {
+        return a.size() != b.size() ? a.size() > b.size() : a < b;
+    });
+    query_words.erase(std::unique(query_words.begin(), query_words.end()), query_words.end());
+
+    //newest month first, older ones are only needed until limit is reached
+    std::map<uint32_t, std::vector<std::string>, std::greater<uint32_t>> months;
+    for (auto month : m_month_segments) {
+        months[month].push_back(segment_name(month, true));
+    }
+    for (auto day : m_day_segments) {
+        months[first_of_month(day)].push_back(segment_name(day, false));
+    }
+    std::vector<uint64_t> found;
+    for (auto& month : months) {
+        for (auto& name : month.second) {
+            find(segment(name), query_words, found);
+        }
+        if (limit > 0 && found.size() >= limit) {
+            break;
+        }
+    }
+
+    std::sort(found.begin(), found.end(), std::greater<uint64_t>());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    if (limit > 0 && found.size() > limit) {
+        found.resize(limit);
+    }
+
+    std::vector<hit> res;
+    res.reserve(found.size());
+    for (auto posting : found) {
+        res.push_back({ uint32_t(posting >> 32), uint32_t(posting) });
+    }
+    return res;
+}
+
+const std::vector<uint32_t>& log_index::days() {
+    load_manifest();
+    return m_days;
+}
+
+bool log_index::complete() {
+    load_manifest();
+    return m_complete;
+}
+
+void log_index::set_complete(bool complete) {
+    load_manifest();
+    if (m_complete == complete) {
+        return;
+    }
+    m_complete = complete;
+    save_manifest();
+}
@@ -0,0 +1,139 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef TOXMM_LOG_INDEX_H
+#define TOXMM_LOG_INDEX_H
+
+#include <glibmm.h>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "storage.h"
+
+namespace toxmm {
+    /**
+     * @brief Persistent full-text index over the chat log of one contact.
+     *
+     * Log items are addressed by day (julian day of a Glib::Date) and
+     * their position in that day's log. Their texts are split into
+     * casefolded words, the postings of a day are saved in a segment
+     * of their own, compact() merges finished months into one segment.
+     *
+     * A query matches items containing every word of it, each word
+     * taken as a prefix.
+     *
+     * Items added to a day are saved together, save_delay_ms after the
+     * last one, before a query, or when the index is destroyed.
+     */
+    class log_index {
+        public:
+            struct hit {
+                uint32_t day;
+                uint32_t item;
+
+                bool operator==(const hit& o) const {
+                    return day == o.day && item == o.item;
+                }
+            };
+
+            /**
+             * @param storage
+             * @param key first key element of everything saved, the contact's address
+             */
+            log_index(std::shared_ptr<toxmm::storage> storage, const std::string& key);
+            //! saves what add() still holds back
+            ~log_index();
+            log_index(const log_index&) = delete;
+            void operator=(const log_index&) = delete;
+
+            //! added items are saved together, this long after the last one
+            static const unsigned save_delay_ms = 500;
+            //! serialized segments kept in memory for queries
+            static const size_t cache_segments = 16;
+
+            //! indexes an item appended to the log of day
+            void add(uint32_t day, uint32_t item, const std::vector<Glib::ustring>& texts);
+            //! replaces everything indexed for day, the texts of each item
+            void set_day(uint32_t day, const std::vector<std::vector<Glib::ustring>>& items);
+            //! merges the day segments of the months before the one of today
+            void compact(uint32_t today);
+
+            //! items matching every word of query, newest first
+            std::vector<hit> find(const Glib::ustring& query, size_t limit = 200);
+
+            //! days that have indexed items, ascending
+            const std::vector<uint32_t>& days();
+
+            //! false until the logs from before the index was added are in it
+            bool complete();
+            void set_complete(bool complete);
+
+            //! casefolded words of text as they are indexed
+            static std::vector<std::string> words(const Glib::ustring& text);
+
+        private:
+            //word -> (day << 32) | item
+            using postings = std::map<std::string, std::vector<uint64_t>>;
+
+            std::shared_ptr<toxmm::storage> m_storage;
+            std::string m_key;
+
+            bool m_loaded = false;
+            bool m_complete = false;
+            std::vector<uint32_t> m_days;
+            std::set<uint32_t> m_day_segments;
+            //first day of the month
+            std::set<uint32_t> m_month_segments;
+
+            //serialized segments by name, loaded on first use,
+            //the least recently used ones are dropped
+            struct cached {
+                std::vector<uint8_t> content;
+                std::list<std::string>::iterator lru;
+            };
+            std::map<std::string, cached> m_cache;
+            //most recently used first
+            std::list<std::string> m_lru;
+            //the day add() writes to, kept unpacked
+            uint32_t m_open_day = 0;
+            postings m_open;
+            bool m_open_dirty = false;
+            sigc::connection m_save;
+
+            void load_manifest();
+            void save_manifest();
+            void add_day(uint32_t day);
+
+            static std::string segment_name(uint32_t day, bool month);
+            const std::vector<uint8_t>& segment(const std::string& name);
+            std::vector<uint8_t>& cache(const std::string& name);
+            void uncache(const std::string& name);
+            void queue_save();
+            void save_open();
+            void read(const std::string& name, postings& out);
+            void write(const std::string& name, postings& in);
+            void find(const std::vector<uint8_t>& segment,
+                      const std::vector<std::string>& words,
+                      std::vector<uint64_t>& out);
+    };
+}
+
+#endif
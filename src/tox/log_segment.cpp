@@ -0,0 +1,310 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "log_segment.h"
+#include "flatbuffers/generated/LogSegment_generated.h"
+#include <giomm.h>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace toxmm;
+
+void log_segment::parse(std::vector<uint8_t> content) {
+    m_keys.clear();
+    m_blocks.clear();
+    m_tail.clear();
+    m_plain.clear();
+    m_unpacked.clear();
+
+    if (content.empty()) {
+        return;
+    }
+
+    auto verify = flatbuffers::Verifier(content.data(), content.size());
+    if (content.size() < 8 ||
+        !flatbuffers::LogSegment::SegmentBufferHasIdentifier(content.data())) {
+        //saved before segments existed
+        if (!flatbuffers::Log::VerifyCollectionBuffer(verify)) {
+            throw std::runtime_error("flatbuffers::Log::VerifyCollectionBuffer failed");
+        }
+        m_plain = std::move(content);
+        return;
+    }
+
+    if (!flatbuffers::LogSegment::VerifySegmentBuffer(verify)) {
+        throw std::runtime_error("flatbuffers::LogSegment::VerifySegmentBuffer failed");
+    }
+    auto segment = flatbuffers::LogSegment::GetSegment(content.data());
+    if (segment->keys()) {
+        for (size_t i = 0; i < segment->keys()->size(); ++i) {
+            m_keys.push_back(segment->keys()->Get(i)->str());
+        }
+    }
+    if (segment->blocks()) {
+        size_t first = 0;
+        for (size_t i = 0; i < segment->blocks()->size(); ++i) {
+            auto b = segment->blocks()->Get(i);
+            if (!b->data() || b->items() == 0) {
+                throw std::runtime_error("Log block is empty");
+            }
+            m_blocks.push_back({ first,
+                                 b->items(),
+                                 b->size(),
+                                 std::vector<uint8_t>(b->data()->begin(),
+                                                      b->data()->end()) });
+            first += b->items();
+        }
+    }
+    if (segment->tail() && segment->tail()->size() > 0) {
+        m_tail.assign(segment->tail()->begin(), segment->tail()->end());
+        auto verify_tail = flatbuffers::Verifier(m_tail.data(), m_tail.size());
+        if (!flatbuffers::Log::VerifyCollectionBuffer(verify_tail)) {
+            throw std::runtime_error("flatbuffers::Log::VerifyCollectionBuffer failed");
+        }
+    }
+}
+
+std::vector<uint8_t> log_segment::serialize() const {
+    if (!m_plain.empty()) {
+        return m_plain;
+    }
+
+    flatbuffers::FlatBufferBuilder fbb;
+    std::vector<flatbuffers::Offset<flatbuffers::String>> keys;
+    for (auto& key : m_keys) {
+        keys.push_back(fbb.CreateString(key));
+    }
+    std::vector<flatbuffers::Offset<flatbuffers::LogSegment::Block>> blocks;
+    for (auto& b : m_blocks) {
+        blocks.push_back(flatbuffers::LogSegment::CreateBlock(fbb,
+                                                              b.items,
+                                                              b.size,
+                                                              fbb.CreateVector(b.data)));
+    }
+    flatbuffers::LogSegment::FinishSegmentBuffer(
+                fbb,
+                flatbuffers::LogSegment::CreateSegment(fbb,
+                                                       fbb.CreateVector(keys),
+                                                       fbb.CreateVector(blocks),
+                                                       fbb.CreateVector(m_tail)));
+    return std::vector<uint8_t>(fbb.GetBufferPointer(),
+                                fbb.GetBufferPointer() + fbb.GetSize());
+}
+
+size_t log_segment::size() const {
+    if (!m_plain.empty()) {
+        return flatbuffers::Log::GetCollection(m_plain.data())->items()->size();
+    }
+    size_t res = m_blocks.empty() ? 0 : m_blocks.back().first + m_blocks.back().items;
+    auto t = tail();
+    if (t) {
+        res += t->items()->size();
+    }
+    return res;
+}
+
+const flatbuffers::Log::Item* log_segment::item(size_t index) {
+    if (!m_plain.empty()) {
+        return flatbuffers::Log::GetCollection(m_plain.data())->items()->Get(index);
+    }
+    //first block after the index
+    auto b = std::upper_bound(m_blocks.begin(), m_blocks.end(), index,
+                              [](size_t index, const block& b) {
+        return index < b.first;
+    });
+    if (b != m_blocks.begin()) {
+        --b;
+        if (index < b->first + b->items) {
+            return unpack(b - m_blocks.begin())->items()->Get(index - b->first);
+        }
+    }
+    auto first = m_blocks.empty() ? 0 : m_blocks.back().first + m_blocks.back().items;
+    return tail()->items()->Get(index - first);
+}
+
+std::string log_segment::address(const flatbuffers::String* str) const {
+    if (!str) {
+        return {};
+    }
+    if (str->size() > 1 && str->c_str()[0] == '#') {
+        auto nr = std::strtoul(str->c_str() + 1, nullptr, 10);
+        if (nr < m_keys.size()) {
+            return m_keys[nr];
+        }
+    }
+    return str->str();
+}
+
+size_t log_segment::append(const flatbuffers::Log::Item* item) {
+    //item might be one of the plain day, kept until it is copied
+    std::vector<uint8_t> plain;
+    if (!m_plain.empty()) {
+        //convert the day on its first change
+        plain.swap(m_plain);
+        auto items = flatbuffers::Log::GetCollection(plain.data())->items();
+        for (size_t i = 0; i < items->size(); ++i) {
+            append(items->Get(i));
+        }
+    }
+
+    flatbuffers::FlatBufferBuilder fbb;
+    std::vector<flatbuffers::Offset<flatbuffers::Log::Item>> items;
+    auto t = tail();
+    if (t) {
+        for (size_t i = 0; i < t->items()->size(); ++i) {
+            items.push_back(copy(fbb, t->items()->Get(i)));
+        }
+    }
+    items.push_back(copy(fbb, item));
+    flatbuffers::Log::FinishCollectionBuffer(
+                fbb,
+                flatbuffers::Log::CreateCollection(fbb, fbb.CreateVector(items)));
+
+    auto index = size();
+    m_tail.assign(fbb.GetBufferPointer(),
+                  fbb.GetBufferPointer() + fbb.GetSize());
+
+    if (items.size() >= block_items) {
+        //full, the uncompressed copy stays around for reading
+        auto nr = m_blocks.size();
+        m_blocks.push_back({ index + 1 - items.size(),
+                             uint32_t(items.size()),
+                             uint32_t(m_tail.size()),
+                             compress(m_tail) });
+        m_unpacked[nr] = std::move(m_tail);
+        m_tail.clear();
+    }
+
+    return index;
+}
+
+const flatbuffers::Log::Collection* log_segment::tail() const {
+    if (m_tail.empty()) {
+        return nullptr;
+    }
+    return flatbuffers::Log::GetCollection(m_tail.data());
+}
+
+const flatbuffers::Log::Collection* log_segment::unpack(size_t nr) {
+    auto iter = m_unpacked.find(nr);
+    if (iter == m_unpacked.end()) {
+        auto& b = m_blocks.at(nr);
+        auto content = decompress(b.data, b.size);
+        auto verify = flatbuffers::Verifier(content.data(), content.size());
+        if (!flatbuffers::Log::VerifyCollectionBuffer(verify) ||
+            flatbuffers::Log::GetCollection(content.data())->items()->size() != b.items) {
+            throw std::runtime_error("flatbuffers::Log::VerifyCollectionBuffer failed");
+        }
+        iter = m_unpacked.emplace(nr, std::move(content)).first;
+    }
+    return flatbuffers::Log::GetCollection(iter->second.data());
+}
+
+flatbuffers::Offset<flatbuffers::String> log_segment::encode(flatbuffers::FlatBufferBuilder& fbb,
+                                                             const flatbuffers::String* str) {
+    if (!str) {
+        return 0;
+    }
+    auto addr = address(str);
+    auto key = std::find(m_keys.begin(), m_keys.end(), addr);
+    if (key == m_keys.end()) {
+        key = m_keys.insert(m_keys.end(), addr);
+    }
+    return fbb.CreateString("#" + std::to_string(key - m_keys.begin()));
+}
+
+flatbuffers::Offset<flatbuffers::Log::Item> log_segment::copy(flatbuffers::FlatBufferBuilder& fbb,
+                                                              const flatbuffers::Log::Item* item) {
+    auto str = [&](const flatbuffers::String* str) {
+        return str ? fbb.CreateString(str->c_str(), str->size())
+                   : flatbuffers::Offset<flatbuffers::String>();
+    };
+
+    flatbuffers::Offset<void> data;
+    switch (item->data_type()) {
+        case flatbuffers::Log::Data::Message: {
+            auto f = reinterpret_cast<const flatbuffers::Log::Message*>(
+                         item->data());
+            data = flatbuffers::Log::CreateMessage(fbb,
+                                                   str(f->message()),
+                                                   f->status()).Union();
+        } break;
+        case flatbuffers::Log::Data::Action: {
+            auto f = reinterpret_cast<const flatbuffers::Log::Action*>(
+                         item->data());
+            data = flatbuffers::Log::CreateAction(fbb,
+                                                  str(f->action()),
+                                                  f->status()).Union();
+        } break;
+        case flatbuffers::Log::Data::File: {
+            auto f = reinterpret_cast<const flatbuffers::Log::File*>(
+                         item->data());
+            auto uuid = str(f->uuid());
+            auto name = str(f->name());
+            auto path = str(f->path());
+            auto receiver = encode(fbb, f->receiver());
+            data = flatbuffers::Log::CreateFile(fbb,
+                                                uuid,
+                                                name,
+                                                path,
+                                                f->status(),
+                                                receiver).Union();
+        } break;
+        default:
+            break;
+    }
+    auto sender = encode(fbb, item->sender());
+    return flatbuffers::Log::CreateItem(fbb,
+                                        sender,
+                                        item->timestamp(),
+                                        data.o ? item->data_type() : flatbuffers::Log::Data::NONE,
+                                        data);
+}
+
+std::vector<uint8_t> log_segment::compress(const std::vector<uint8_t>& data) {
+    auto memory = Gio::MemoryOutputStream::create(nullptr, 0, g_realloc, g_free);
+    auto stream = Gio::ConverterOutputStream::create(
+                      memory,
+                      Gio::ZlibCompressor::create(Gio::ZLIB_COMPRESSOR_FORMAT_RAW, 9));
+    gsize written;
+    stream->write_all(data.data(), data.size(), written);
+    stream->close();
+    auto begin = static_cast<const uint8_t*>(memory->get_data());
+    return std::vector<uint8_t>(begin, begin + memory->get_data_size());
+}
+
+std::vector<uint8_t> log_segment::decompress(const std::vector<uint8_t>& data, size_t size) {
+    //one more than expected to notice a block that is too long
+    std::vector<uint8_t> res(size + 1);
+    gsize read = 0;
+    try {
+        auto memory = Gio::MemoryInputStream::create();
+        memory->add_data(data.data(), data.size());
+        auto stream = Gio::ConverterInputStream::create(
+                          memory,
+                          Gio::ZlibDecompressor::create(Gio::ZLIB_COMPRESSOR_FORMAT_RAW));
+        stream->read_all(res.data(), res.size(), read);
+    } catch (Glib::Error& e) {
+        throw std::runtime_error(std::string(e.what()));
+    }
+    if (read != size) {
+        throw std::runtime_error("Log block has the wrong size");
+    }
+    res.resize(size);
+    return res;
+}
@@ -0,0 +1,86 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef TOXMM_LOG_SEGMENT_H
+#define TOXMM_LOG_SEGMENT_H
+
+#include "flatbuffers/generated/Log_generated.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace toxmm {
+    /**
+     * @brief One day of chat log, as saved in the storage.
+     *
+     * Items are kept in zlib compressed blocks and a block only gets
+     * decompressed when one of its items is read. Addresses are saved
+     * once per day and the items refer to them by number.
+     *
+     * Days saved as a plain flatbuffers::Log::Collection are read as
+     * they are and converted on the next append.
+     */
+    class log_segment {
+        public:
+            //! items per compressed block
+            static const size_t block_items = 64;
+
+            //! throws when the content is broken, empty content is an empty day
+            void parse(std::vector<uint8_t> content);
+            std::vector<uint8_t> serialize() const;
+
+            size_t size() const;
+
+            //! valid until the next append
+            const flatbuffers::Log::Item* item(size_t index);
+
+            //! sender or receiver of an item
+            std::string address(const flatbuffers::String* str) const;
+
+            //! adds a copy of the item, returns its index
+            size_t append(const flatbuffers::Log::Item* item);
+
+        private:
+            struct block {
+                size_t first;
+                uint32_t items;
+                uint32_t size;
+                std::vector<uint8_t> data;
+            };
+
+            std::vector<std::string> m_keys;
+            std::vector<block> m_blocks;
+            std::vector<uint8_t> m_tail;
+            std::vector<uint8_t> m_plain;
+            //decompressed blocks by number
+            std::map<size_t, std::vector<uint8_t>> m_unpacked;
+
+            const flatbuffers::Log::Collection* tail() const;
+            const flatbuffers::Log::Collection* unpack(size_t nr);
+
+            flatbuffers::Offset<flatbuffers::String> encode(flatbuffers::FlatBufferBuilder& fbb,
+                                                            const flatbuffers::String* str);
+            flatbuffers::Offset<flatbuffers::Log::Item> copy(flatbuffers::FlatBufferBuilder& fbb,
+                                                             const flatbuffers::Log::Item* item);
+
+            static std::vector<uint8_t> compress(const std::vector<uint8_t>& data);
+            static std::vector<uint8_t> decompress(const std::vector<uint8_t>& data, size_t size);
+    };
+}
+
+#endif
@@ -0,0 +1,205 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "search_index.h"
+#include <algorithm>
+
+using namespace toxmm;
+
+namespace {
+    enum gram_kind : uint32_t {
+        PREFIX_1 = 1u << 24,
+        PREFIX_2 = 2u << 24,
+        TRIGRAM  = 3u << 24
+    };
+
+    //utf-8 continuation and lead bytes count as word characters
+    bool is_word(unsigned char c) {
+        return c >= 0x80 || g_ascii_isalnum(c);
+    }
+
+    bool is_space(unsigned char c) {
+        return c == '\n' || g_ascii_isspace(c);
+    }
+
+    uint32_t pack(gram_kind kind, const std::string& s, size_t pos, size_t len) {
+        uint32_t key = kind;
+        for (size_t i = 0; i < len; ++i) {
+            key |= uint32_t((unsigned char)s[pos + i]) << (8 * (2 - i));
+        }
+        return key;
+    }
+
+    //in place, a stays sorted
+    void intersect(std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+        auto out = a.begin();
+        auto other = b.begin();
+        for (auto id : a) {
+            while (other != b.end() && *other < id) {
+                ++other;
+            }
+            if (other == b.end()) {
+                break;
+            }
+            if (*other == id) {
+                *out++ = id;
+            }
+        }
+        a.erase(out, a.end());
+    }
+}
+
+std::vector<uint32_t> search_index::grams(const std::string& text) {
+    std::vector<uint32_t> res;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (is_space(text[i])) {
+            continue;
+        }
+        if (i == 0 || !is_word(text[i - 1])) {
+            res.push_back(pack(PREFIX_1, text, i, 1));
+            if (i + 1 < text.size() && !is_space(text[i + 1])) {
+                res.push_back(pack(PREFIX_2, text, i, 2));
+            }
+        }
+        if (i + 2 < text.size() && !is_space(text[i + 1]) && !is_space(text[i + 2])) {
+            res.push_back(pack(TRIGRAM, text, i, 3));
+        }
+    }
+    std::sort(res.begin(), res.end());
+    res.erase(std::unique(res.begin(), res.end()), res.end());
+    return res;
+}
+
+void search_index::set(uint32_t id, const std::vector<Glib::ustring>& fields) {
+    remove(id);
+
+    entry e;
+    for (auto& field : fields) {
+        if (!e.text.empty()) {
+            e.text += '\n';
+        }
+        e.text += field.casefold().raw();
+    }
+    e.grams = grams(e.text);
+    for (auto gram : e.grams) {
+        auto& ids = m_postings[gram];
+        ids.insert(std::upper_bound(ids.begin(), ids.end(), id), id);
+    }
+    m_entries.emplace(id, std::move(e));
+}
+
+void search_index::remove(uint32_t id) {
+    auto iter = m_entries.find(id);
+    if (iter == m_entries.end()) {
+        return;
+    }
+    for (auto gram : iter->second.grams) {
+        auto posting = m_postings.find(gram);
+        auto& ids = posting->second;
+        ids.erase(std::lower_bound(ids.begin(), ids.end(), id));
+        if (ids.empty()) {
+            m_postings.erase(posting);
+        }
+    }
+    m_entries.erase(iter);
+}
+
+void search_index::clear() {
+    m_entries.clear();
+    m_postings.clear();
+}
+
+size_t search_index::size() const {
+    return m_entries.size();
+}
+
+bool search_index::postings(const std::string& word,
+                            std::vector<const std::vector<uint32_t>*>& out) const {
+    auto add = [&](uint32_t gram) {
+        auto iter = m_postings.find(gram);
+        if (iter == m_postings.end()) {
+            return false;
+        }
+        out.push_back(&iter->second);
+        return true;
+    };
+    if (word.size() < 3) {
+        return add(word.size() == 1 ? pack(PREFIX_1, word, 0, 1)
+                                    : pack(PREFIX_2, word, 0, 2));
+    }
+    for (size_t i = 0; i + 2 < word.size(); ++i) {
+        if (!add(pack(TRIGRAM, word, i, 3))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<uint32_t> search_index::find(const Glib::ustring& query) const {
+    std::vector<std::string> words;
+    const std::string folded = query.casefold().raw();
+    for (size_t i = 0; i < folded.size();) {
+        if (is_space(folded[i])) {
+            ++i;
+            continue;
+        }
+        size_t end = i;
+        while (end < folded.size() && !is_space(folded[end])) {
+            ++end;
+        }
+        words.push_back(folded.substr(i, end - i));
+        i = end;
+    }
+
+    std::vector<uint32_t> res;
+    if (words.empty()) {
+        res.reserve(m_entries.size());
+        for (auto& e : m_entries) {
+            res.push_back(e.first);
+        }
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+    //intersect the postings of all words, shortest first
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (auto& word : words) {
+        if (!postings(word, lists)) {
+            return res;
+        }
+    }
+    std::sort(lists.begin(), lists.end(), [](auto a, auto b) {
+        return a->size() < b->size();
+    });
+    res = *lists.front();
+    for (size_t i = 1; i < lists.size() && !res.empty(); ++i) {
+        intersect(res, *lists[i]);
+    }
+
+    //words longer than a trigram can have all of them without being there,
+    //check the few ids that are left
+    for (auto& word : words) {
+        if (word.size() <= 3) {
+            continue;
+        }
+        res.erase(std::remove_if(res.begin(), res.end(), [&](uint32_t id) {
+            return m_entries.at(id).text.find(word) == std::string::npos;
+        }), res.end());
+    }
+    return res;
+}
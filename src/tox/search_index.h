@@ -0,0 +1,66 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef TOXMM_SEARCH_INDEX_H
+#define TOXMM_SEARCH_INDEX_H
+
+#include <glibmm.h>
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+namespace toxmm {
+    /**
+     * @brief Case-insensitive type-ahead index over a few text fields
+     * per id.
+     *
+     * Every query word must match. Words of three or more bytes match
+     * anywhere, looked up by trigram. Shorter words only match the
+     * start of a word, looked up by prefix.
+     */
+    class search_index {
+        public:
+            //! adds or replaces the fields of id
+            void set(uint32_t id, const std::vector<Glib::ustring>& fields);
+            void remove(uint32_t id);
+            void clear();
+
+            //! sorted ids matching every word of query, all ids if it's empty
+            std::vector<uint32_t> find(const Glib::ustring& query) const;
+
+            size_t size() const;
+
+        private:
+            struct entry {
+                //casefolded fields, separated by '\n'
+                std::string text;
+                std::vector<uint32_t> grams;
+            };
+
+            std::unordered_map<uint32_t, entry> m_entries;
+            //gram -> sorted ids
+            std::unordered_map<uint32_t, std::vector<uint32_t>> m_postings;
+
+            static std::vector<uint32_t> grams(const std::string& text);
+            //! appends the postings word needs, false if one is missing
+            bool postings(const std::string& word,
+                          std::vector<const std::vector<uint32_t>*>& out) const;
+    };
+}
+
+#endif
@@ -55,6 +55,27 @@ namespace toxmm {
              */
             virtual void load(const std::initializer_list<std::string>& key, std::vector<uint8_t>& data) = 0;
 
+            /**
+             * @brief lists the data saved below a key
+             *
+             * Sets names to the last key element of everything saved
+             * as key plus one more element, in no particular order.
+             * The default knows of nothing saved.
+             *
+             * @param key
+             * @param names
+             */
+            virtual void list(const std::initializer_list<std::string>&, std::vector<std::string>& names) {
+                names.clear();
+            }
+
+            /**
+             * @brief removes the data, if there is any
+             *
+             * @param unique key for the data
+             */
+            virtual void remove(const std::initializer_list<std::string>& key) = 0;
+
             virtual ~storage() {}
     };
 }
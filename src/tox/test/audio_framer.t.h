@@ -0,0 +1,102 @@
+#include <cxxtest/TestSuite.h>
+
+#include "../audio_framer.h"
+#include <vector>
+#include <numeric>
+
+class TestAudioFramer : public CxxTest::TestSuite
+{
+    public:
+        void test_frames() {
+            toxmm::audio_framer framer(toxmm::av::audio::al(20),
+                                       toxmm::av::audio::CHANNELS_MONO);
+            //capture hands out 256 samples at a time, not frame aligned
+            std::vector<int16_t> chunk(256);
+            int16_t value = 0;
+            gint64 captured = 1000000;
+            for (int i = 0; i < 8; ++i) {
+                for (auto& s : chunk) {
+                    s = value++;
+                }
+                framer.push(chunk.data(), chunk.size(), captured);
+                captured += 256 * 1000000 / 48000;
+            }
+            //2048 samples make two 960 sample frames
+            TS_ASSERT_EQUALS(framer.ready(), 2u);
+
+            toxmm::av::audio frame;
+            gint64 frame_captured;
+            TS_ASSERT(framer.pop(frame, frame_captured));
+            TS_ASSERT_EQUALS(frame.sample_count(), 960u);
+            TS_ASSERT_EQUALS(frame.sampling_rate(), toxmm::av::audio::SAMPLING_RATE_48000);
+            TS_ASSERT_EQUALS(frame.data()[0], 0);
+            TS_ASSERT_EQUALS(frame.data()[959], 959);
+            TS_ASSERT_EQUALS(frame_captured, 1000000);
+
+            TS_ASSERT(framer.pop(frame, frame_captured));
+            TS_ASSERT_EQUALS(frame.data()[0], 960);
+            //paced by the sample count, not by when push() got called
+            TS_ASSERT_EQUALS(frame_captured, 1020000);
+
+            TS_ASSERT(!framer.pop(frame, frame_captured));
+        }
+
+        void test_ring_reuse() {
+            toxmm::audio_framer framer(toxmm::av::audio::al(10),
+                                       toxmm::av::audio::CHANNELS_MONO,
+                                       4);
+            std::vector<int16_t> samples(480, 1);
+            toxmm::av::audio frame;
+            gint64 captured;
+            for (int i = 0; i < 20; ++i) {
+                framer.push(samples.data(), samples.size(), i * 10000);
+                TS_ASSERT(framer.pop(frame, captured));
+            }
+            //only the last popped frame is still referenced
+            TS_ASSERT_EQUALS(framer.allocations(), 0u);
+
+            //keep more frames alive than the ring has slots
+            std::vector<toxmm::av::audio> held;
+            for (int i = 20; i < 25; ++i) {
+                framer.push(samples.data(), samples.size(), i * 10000);
+                TS_ASSERT(framer.pop(frame, captured));
+                held.push_back(frame);
+            }
+            TS_ASSERT(framer.allocations() > 0u);
+            TS_ASSERT_EQUALS(framer.dropped(), 0u);
+        }
+
+        void test_drop_oldest() {
+            toxmm::audio_framer framer(toxmm::av::audio::al(10),
+                                       toxmm::av::audio::CHANNELS_MONO,
+                                       4);
+            std::vector<int16_t> samples(480);
+            for (int i = 0; i < 6; ++i) {
+                std::fill(samples.begin(), samples.end(), int16_t(i));
+                framer.push(samples.data(), samples.size(), i * 10000);
+            }
+            TS_ASSERT_EQUALS(framer.ready(), 3u);
+            TS_ASSERT_EQUALS(framer.dropped(), 3u);
+
+            toxmm::av::audio frame;
+            gint64 captured;
+            TS_ASSERT(framer.pop(frame, captured));
+            TS_ASSERT_EQUALS(frame.data()[0], 3);
+            TS_ASSERT_EQUALS(captured, 30000);
+        }
+
+        void test_resync() {
+            toxmm::audio_framer framer(toxmm::av::audio::al(20),
+                                       toxmm::av::audio::CHANNELS_MONO);
+            std::vector<int16_t> samples(500);
+            framer.push(samples.data(), samples.size(), 0);
+            //the capture restarted a second later, the partial frame is dropped
+            framer.push(samples.data(), samples.size(), 1000000);
+            framer.push(samples.data(), samples.size(), 1000000 + 500 * 1000000 / 48000);
+
+            toxmm::av::audio frame;
+            gint64 captured;
+            TS_ASSERT(framer.pop(frame, captured));
+            TS_ASSERT_EQUALS(captured, 1000000);
+        }
+};
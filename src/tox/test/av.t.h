@@ -0,0 +1,69 @@
+#include <cxxtest/TestSuite.h>
+
+#include "../av.h"
+
+class TestAv : public CxxTest::TestSuite
+{
+    private:
+        //conversion before i420::from_image, for comparison
+        static void to_yuv_reference(const toxmm::av::image& img,
+                                     std::vector<uint8_t>& y,
+                                     std::vector<uint8_t>& u,
+                                     std::vector<uint8_t>& v) {
+            y.assign(img.width() * img.height(), 0);
+            u.assign((img.width() / 2) * (img.height() / 2), 0);
+            v.assign((img.width() / 2) * (img.height() / 2), 0);
+            for (int cy = 0; cy < img.height(); ++cy) {
+                for (int cx = 0; cx < img.width(); ++cx) {
+                    img[{cx, cy}].as_yuv(
+                                y.at(cx + cy * img.width()),
+                                u.at((cx / 2) + (cy / 2) * (img.width() / 2)),
+                                v.at((cx / 2) + (cy / 2) * (img.width() / 2)));
+                }
+            }
+        }
+
+        static toxmm::av::image test_image(int w, int h) {
+            toxmm::av::image img(w, h);
+            for (int y = 0; y < h; ++y) {
+                for (int x = 0; x < w; ++x) {
+                    //2x2 blocks of one color, so the chroma doesn't depend on subsampling
+                    img[{x, y}] = toxmm::av::pixel((x / 2) * 7, (y / 2) * 5, (x / 2 + y / 2) * 3);
+                }
+            }
+            return img;
+        }
+
+    public:
+        void test_i420_from_image() {
+            auto img = test_image(64, 48);
+            auto frame = toxmm::av::i420::from_image(img);
+            TS_ASSERT(!frame.empty());
+            TS_ASSERT(frame.packed());
+            TS_ASSERT_EQUALS(frame.width(), 64);
+            TS_ASSERT_EQUALS(frame.height(), 48);
+
+            std::vector<uint8_t> y, u, v;
+            to_yuv_reference(img, y, u, v);
+            auto close = [](const uint8_t* a, const std::vector<uint8_t>& b) {
+                for (size_t i = 0; i < b.size(); ++i) {
+                    if (std::abs(int(a[i]) - int(b[i])) > 2) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            TS_ASSERT(close(frame.plane(0), y));
+            TS_ASSERT(close(frame.plane(1), u));
+            TS_ASSERT(close(frame.plane(2), v));
+        }
+
+        void test_i420_packed() {
+            uint8_t dummy[1] = {};
+            toxmm::av::i420 padded(30, 20, dummy, dummy, dummy, 32, 16, 16, nullptr);
+            TS_ASSERT(!padded.packed());
+            toxmm::av::i420 packed(32, 20, dummy, dummy, dummy, 32, 16, 16, nullptr);
+            TS_ASSERT(packed.packed());
+            TS_ASSERT(toxmm::av::i420().empty());
+        }
+};
@@ -0,0 +1,36 @@
+#include <cxxtest/TestSuite.h>
+
+#include "../types.h"
+#include "../core.h"
+#include "../bootstrap.h"
+
+#include "global_fixture.t.h"
+
+class TestBootstrap : public CxxTest::TestSuite
+{
+    public:
+        void test_default_nodes() {
+            TS_ASSERT(!gfix.core_a->bootstrap()->get_all().empty());
+        }
+
+        void test_score() {
+            toxmm::bootstrap::node unknown;
+            toxmm::bootstrap::node good;
+            good.attempts  = 3;
+            good.successes = 3;
+            good.latency   = 2;
+            toxmm::bootstrap::node slow = good;
+            slow.latency   = 30;
+            toxmm::bootstrap::node bad;
+            bad.attempts   = 5;
+            TS_ASSERT(good.score() > unknown.score());
+            TS_ASSERT(good.score() > slow.score());
+            TS_ASSERT(unknown.score() > bad.score());
+        }
+
+        void test_time_to_online() {
+            gfix.wait_for_online();
+            TS_ASSERT(gfix.core_a->bootstrap()->property_time_to_online() > 0.0);
+            TS_ASSERT(gfix.core_b->bootstrap()->property_time_to_online() > 0.0);
+        }
+};
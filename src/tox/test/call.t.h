@@ -0,0 +1,198 @@
+#include <cxxtest/TestSuite.h>
+
+#include "../types.h"
+#include "../core.h"
+#include "../contact/manager.h"
+#include "../contact/contact.h"
+#include "../contact/call.h"
+#include "../audio_framer.h"
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "global_fixture.t.h"
+
+//MUST BE AFTER TestCore !
+class TestCall : public CxxTest::TestSuite
+{
+    private:
+        static double rms(const toxmm::av::audio& frame) {
+            if (frame.size() == 0) {
+                return 0;
+            }
+            double sum = 0;
+            for (size_t i = 0; i < frame.size(); ++i) {
+                sum += double(frame.data()[i]) * frame.data()[i];
+            }
+            return std::sqrt(sum / frame.size());
+        }
+
+        static toxmm::av::image test_image(int w, int h) {
+            toxmm::av::image img(w, h);
+            for (int y = 0; y < h; ++y) {
+                for (int x = 0; x < w; ++x) {
+                    img[{x, y}] = toxmm::av::pixel(x * 255 / w, y * 255 / h, 128);
+                }
+            }
+            return img;
+        }
+
+        //sends frames from A until B received a few, returns the capture to receive time
+        static gint64 video_send(std::shared_ptr<toxmm::call> call_a,
+                                 std::shared_ptr<toxmm::call> call_b,
+                                 const std::function<void(gint64)>& send) {
+            const int wanted = 10;
+            int received = 0;
+            gint64 first_sent = -1;
+            gint64 first_received = -1;
+            sigc::connection con1 = call_b->property_remote_video_frame().signal_changed().connect([&]() {
+                if (first_sent >= 0 && received++ == 0) {
+                    first_received = g_get_monotonic_time();
+                }
+            });
+            sigc::connection con2 = Glib::signal_timeout().connect([&]() {
+                auto now = g_get_monotonic_time();
+                if (first_sent < 0) {
+                    first_sent = now;
+                }
+                send(now);
+                return true;
+            }, 40);
+            gfix.wait_while([&]() {
+                return received < wanted;
+            });
+            con1.disconnect();
+            con2.disconnect();
+            TS_ASSERT(received >= wanted);
+            TS_ASSERT(first_received >= first_sent);
+            TS_ASSERT_EQUALS(call_a->property_video_send_failures().get_value(), 0u);
+            return first_received - first_sent;
+        }
+
+    public:
+        void test_audio_round_trip() {
+            gfix.wait_for_online();
+            gfix.wait_for_contact();
+
+            //A calls B, B answers and sends back whatever it hears
+            auto call_a = gfix.contact_b->call();
+            auto call_b = gfix.contact_a->call();
+
+            sigc::connection con1 = call_b->signal_incoming_call().connect([&]() {
+                call_b->property_state() = toxmm::call::CALL_RESUME;
+            });
+            sigc::connection con2 = call_b->property_remote_audio_frame().signal_changed().connect([&]() {
+                call_b->property_audio_frame() = call_b->property_remote_audio_frame().get_value();
+            });
+
+            call_a->property_state() = toxmm::call::CALL_RESUME;
+            gfix.wait_while([&]() {
+                return call_a->property_remote_state() == toxmm::call::CALL_CANCEL ||
+                       call_b->property_state() == toxmm::call::CALL_CANCEL;
+            });
+            TS_ASSERT_DIFFERS(call_a->property_remote_state().get_value(), toxmm::call::CALL_CANCEL);
+
+            //half a second of silence, then a 1 kHz tone in 20 ms frames
+            const int silence_frames = 25;
+            const size_t samples = 960;
+            toxmm::audio_framer framer(toxmm::av::audio::al(20),
+                                       toxmm::av::audio::CHANNELS_MONO);
+            std::vector<int16_t> pcm(samples);
+            int sent = 0;
+            gint64 tone_sent = -1;
+            gint64 tone_received = -1;
+
+            sigc::connection con3 = call_a->property_remote_audio_frame().signal_changed().connect([&]() {
+                if (tone_sent >= 0 && tone_received < 0 &&
+                    rms(call_a->property_remote_audio_frame().get_value()) > 1000) {
+                    tone_received = g_get_monotonic_time();
+                }
+            });
+            sigc::connection con4 = Glib::signal_timeout().connect([&]() {
+                auto now = g_get_monotonic_time();
+                for (size_t i = 0; i < samples; ++i) {
+                    double t = double(sent * samples + i) / toxmm::audio_framer::rate;
+                    pcm[i] = sent < silence_frames ? 0 : int16_t(8000 * std::sin(2 * M_PI * 1000 * t));
+                }
+                framer.push(pcm.data(), pcm.size(), now);
+                toxmm::av::audio frame;
+                gint64 captured;
+                while (framer.pop(frame, captured)) {
+                    if (sent == silence_frames && tone_sent < 0) {
+                        tone_sent = captured;
+                    }
+                    call_a->property_audio_frame() = frame;
+                }
+                ++sent;
+                return true;
+            }, 20);
+
+            gfix.wait_while([&]() {
+                return tone_received < 0;
+            });
+            con1.disconnect();
+            con2.disconnect();
+            con3.disconnect();
+            con4.disconnect();
+
+            TS_ASSERT(tone_received > tone_sent);
+            TS_TRACE("AUDIO ROUND TRIP " + std::to_string((tone_received - tone_sent) / 1000) + "MS");
+            TS_ASSERT_EQUALS(framer.dropped(), 0u);
+
+            call_a->property_state() = toxmm::call::CALL_CANCEL;
+            gfix.wait_while([&]() {
+                return call_b->property_remote_state() != toxmm::call::CALL_CANCEL;
+            });
+            TS_ASSERT_EQUALS(call_b->property_remote_state().get_value(), toxmm::call::CALL_CANCEL);
+        }
+
+        void test_video_send() {
+            gfix.wait_for_online();
+            gfix.wait_for_contact();
+
+            auto call_a = gfix.contact_b->call();
+            auto call_b = gfix.contact_a->call();
+
+            sigc::connection con1 = call_b->signal_incoming_call().connect([&]() {
+                call_b->property_state() = toxmm::call::CALL_RESUME;
+            });
+
+            call_a->property_state() = toxmm::call::CALL_RESUME;
+            gfix.wait_while([&]() {
+                return call_a->property_remote_state() == toxmm::call::CALL_CANCEL ||
+                       call_b->property_state() == toxmm::call::CALL_CANCEL;
+            });
+            con1.disconnect();
+            TS_ASSERT_DIFFERS(call_a->property_remote_state().get_value(), toxmm::call::CALL_CANCEL);
+
+            auto img = test_image(320, 240);
+
+            //old path: RGB image, converted to I420 inside av::send_video_frame
+            auto rgb = video_send(call_a, call_b, [&](gint64) {
+                call_a->property_video_frame() = img;
+            });
+            //the RGB path carries no capture time
+            TS_ASSERT_EQUALS(call_a->property_video_send_latency().get_value(), 0.0);
+
+            //new path: I420 with the capture time, as the webcam hands it over
+            auto i420 = toxmm::av::i420::from_image(img);
+            auto yuv = video_send(call_a, call_b, [&](gint64 now) {
+                call_a->property_video_frame_i420() = toxmm::av::i420(
+                    i420.width(), i420.height(),
+                    i420.plane(0), i420.plane(1), i420.plane(2),
+                    i420.stride(0), i420.stride(1), i420.stride(2),
+                    std::make_shared<toxmm::av::i420>(i420), now);
+            });
+            TS_ASSERT(call_a->property_video_send_latency().get_value() > 0);
+            TS_TRACE("VIDEO RGB " + std::to_string(rgb / 1000) + "MS, " +
+                     "I420 " + std::to_string(yuv / 1000) + "MS, " +
+                     "SEND LATENCY " + std::to_string(call_a->property_video_send_latency().get_value()) + "MS");
+
+            call_a->property_state() = toxmm::call::CALL_CANCEL;
+            gfix.wait_while([&]() {
+                return call_b->property_remote_state() != toxmm::call::CALL_CANCEL;
+            });
+            TS_ASSERT_EQUALS(call_b->property_remote_state().get_value(), toxmm::call::CALL_CANCEL);
+        }
+};
@@ -5,6 +5,8 @@
 #include "../storage.h"
 #include "../contact/manager.h"
 #include "../contact/contact.h"
+#include "../contact/call.h"
+#include "../av.h"
 #include <giomm.h>
 #include <thread>
 #include <chrono>
@@ -13,6 +15,24 @@
 
 class TestCore : public CxxTest::TestSuite
 {
+    private:
+        //implementation before the ascii fast path, for comparison
+        static Glib::ustring fix_utf8_reference(const std::string& input) {
+            static const Glib::ustring uFFFD(1, gunichar(0xFFFD));
+            std::string fixed;
+            fixed.reserve(input.size());
+            const gchar* ginput = input.data();
+            const gchar* str = ginput;
+            const gchar* last_valid;
+            while(!g_utf8_validate(str, std::distance(str, ginput + input.size()), &last_valid)) {
+                fixed.append(str, last_valid);
+                fixed.append(uFFFD.raw().begin(), uFFFD.raw().end());
+                str = last_valid + 1;
+            }
+            fixed.append(str, last_valid);
+            return fixed;
+        }
+
     public:
         void test_to_hex() {
             TS_ASSERT_EQUALS(
@@ -30,6 +50,94 @@ class TestCore : public CxxTest::TestSuite
             TS_ASSERT_EQUALS(toxmm::core::from_hex("010203FFFE"), v);
         }
 
+        void test_hex_raw() {
+            const uint8_t data[] = {0x00, 0x0A, 0x7F, 0x80, 0xFF};
+            char hex[10];
+            toxmm::core::to_hex(data, sizeof(data), hex);
+            TS_ASSERT_EQUALS(std::string(hex, sizeof(hex)), "000A7F80FF");
+
+            uint8_t back[5] = {};
+            toxmm::core::from_hex("000a7f80ff", 10, back);
+            TS_ASSERT_SAME_DATA(back, data, sizeof(data));
+
+            TS_ASSERT_THROWS(toxmm::core::from_hex("0G", 2, back), std::invalid_argument);
+        }
+
+        void test_fix_utf8() {
+            std::vector<std::string> inputs = {
+                "",
+                "Hello, how are you doing today ?",
+                "Gr\xC3\xBC\xC3\x9F" "e aus M\xC3\xBCnchen",
+                "\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF",
+                "broken \xC3 utf8 \xFF\xFE in the middle",
+                std::string("embedded\0nul byte", 17),
+                "\xF0\x9F\x98\x80 emoji",
+                "\xE3\x81"
+            };
+            for (auto& input : inputs) {
+                auto fixed = toxmm::core::fix_utf8(input);
+                TS_ASSERT(fixed.validate());
+                TS_ASSERT_EQUALS(fixed.raw(), fix_utf8_reference(input).raw());
+            }
+            TS_ASSERT_EQUALS(toxmm::core::fix_utf8("a\xFF" "b").raw(), "a\xEF\xBF\xBD" "b");
+        }
+
+        void test_sort_key() {
+            std::vector<Glib::ustring> names = {
+                "alice", "Bob", "bob", "Zoe", "\xC3\x96tzi", "otto", "", "42", "B\xC3\xA4r"
+            };
+            for (auto& a : names) {
+                for (auto& b : names) {
+                    auto la = a.lowercase();
+                    auto lb = b.lowercase();
+                    int expected = (la < lb) ? -1 : (la > lb) ? 1 : 0;
+                    int res = toxmm::contact::sort_key(a).compare(toxmm::contact::sort_key(b));
+                    TS_ASSERT_EQUALS((res > 0) - (res < 0), expected);
+                }
+            }
+        }
+
+        void test_config_save() {
+            auto config = gfix.core_a->config();
+            auto saves = []() {
+                int n = 0;
+                for (auto& s : gfix.mock_storage_a->saves) {
+                    if (s.first.find("toxmm_config") != std::string::npos) {
+                        n += s.second;
+                    }
+                }
+                return n;
+            };
+            auto settle = []() {
+                auto start = std::chrono::steady_clock::now();
+                gfix.wait_while([&]() {
+                    return std::chrono::steady_clock::now() - start <
+                            std::chrono::milliseconds(2 * toxmm::config::save_delay_ms);
+                });
+            };
+            settle();
+            auto before = saves();
+
+            //a burst of changes is saved once, after the delay
+            config->property_download_path() = "/tmp/x/";
+            config->property_avatar_path() = "/tmp/avatar_x/";
+            config->property_download_path() = "/tmp/y/";
+            TS_ASSERT_EQUALS(saves(), before);
+            settle();
+            TS_ASSERT_EQUALS(saves(), before + 1);
+
+            config->property_download_path() = "/tmp/";
+            config->property_avatar_path() = "/tmp/avatar_a/";
+            settle();
+            TS_ASSERT_EQUALS(saves(), before + 2);
+
+            //changed back before the delay, nothing to save
+            config->property_download_path() = "/tmp/z/";
+            config->property_download_path() = "/tmp/";
+            settle();
+            TS_ASSERT_EQUALS(saves(), before + 2);
+        }
+
         void test_wait_online() {
             gfix.wait_while([]() {
                 return gfix.core_a->property_connection() == TOX_CONNECTION_NONE ||
@@ -39,6 +147,46 @@ class TestCore : public CxxTest::TestSuite
             TS_ASSERT_DIFFERS(gfix.core_b->property_connection(), TOX_CONNECTION_NONE);
         }
 
+        void test_update_stats() {
+            auto start = std::chrono::system_clock::now();
+            gfix.wait_while([&]() {
+                return std::chrono::system_clock::now() - start < std::chrono::seconds(2);
+            });
+            TS_ASSERT(gfix.core_a->property_wakeups_per_second() > 0.0);
+            TS_ASSERT(gfix.core_a->property_dispatch_latency() >= 0.0);
+        }
+
+        void test_update_interval_in_call() {
+            gfix.wait_for_online();
+            gfix.wait_for_contact();
+
+            auto call_a = gfix.contact_b->call();
+            auto call_b = gfix.contact_a->call();
+            auto con = call_b->signal_incoming_call().connect([&]() {
+                call_b->property_state() = toxmm::call::CALL_RESUME;
+            });
+            call_a->property_state() = toxmm::call::CALL_RESUME;
+            gfix.wait_while([&]() {
+                return call_a->property_remote_state() == toxmm::call::CALL_CANCEL;
+            });
+            con.disconnect();
+            TS_ASSERT(gfix.core_a->av()->in_call());
+
+            //nothing but the call going on, long enough to count as idle
+            auto start = std::chrono::steady_clock::now();
+            gfix.wait_while([&]() {
+                return std::chrono::steady_clock::now() - start <
+                        std::chrono::milliseconds(toxmm::core::idle_after_ms + 500);
+            });
+            TS_ASSERT(gfix.core_a->update_optimal_interval() < toxmm::core::low_power_interval);
+
+            call_a->property_state() = toxmm::call::CALL_CANCEL;
+            gfix.wait_while([&]() {
+                return call_b->property_remote_state() != toxmm::call::CALL_CANCEL;
+            });
+            TS_ASSERT(!gfix.core_a->av()->in_call());
+        }
+
         void test_add_contact() {
             toxmm::contactAddrPublic request_addr;
             std::string              request_message;
@@ -30,6 +30,9 @@ public:
             std::map<std::string, std::vector<uint8_t>> m_mem;
             std::string m_prefix;
         public:
+            //saves per key
+            std::map<std::string, int> saves;
+
             MockStorage() {}
             ~MockStorage() {}
             void set_prefix_key(const std::string& prefix) override {
@@ -40,6 +43,7 @@ public:
                 for(auto v : key) {
                     str_key += "_" + v;
                 }
+                ++saves[str_key];
                 auto iter = m_mem.find(str_key);
                 if (iter != m_mem.end()) {
                     TS_TRACE("MOCKSTORAGE STORE " + str_key + " OVERWRITE " + std::to_string(data.size()) + " BYTES");
@@ -63,6 +67,31 @@ public:
                 TS_TRACE("MOCKSTORAGE LOAD " + str_key + " RETURN EMPTY");
                 data.clear();
             }
+            void list(const std::initializer_list<std::string>& key, std::vector<std::string>& names) override {
+                std::string str_key = m_prefix;
+                for(auto v : key) {
+                    str_key += "_" + v;
+                }
+                str_key += "_";
+                names.clear();
+                for (auto iter = m_mem.lower_bound(str_key); iter != m_mem.end(); ++iter) {
+                    if (iter->first.compare(0, str_key.size(), str_key) != 0) {
+                        break;
+                    }
+                    auto name = iter->first.substr(str_key.size());
+                    if (name.find('_') == std::string::npos) {
+                        names.push_back(name);
+                    }
+                }
+            }
+            void remove(const std::initializer_list<std::string>& key) override {
+                std::string str_key = m_prefix;
+                for(auto v : key) {
+                    str_key += "_" + v;
+                }
+                TS_TRACE("MOCKSTORAGE REMOVE " + str_key);
+                m_mem.erase(str_key);
+            }
     };
 
     std::shared_ptr<MockStorage> mock_storage_a;
@@ -112,18 +141,18 @@ public:
         auto tox_a = core_a->toxcore();
         auto tox_b = core_b->toxcore();
 
-        toxmm::contactAddrPublic  dht_a, dht_b;
-        tox_self_get_dht_id(tox_a, dht_a);
-        tox_self_get_dht_id(tox_a, dht_b);
+        std::array<uint8_t, TOX_PUBLIC_KEY_SIZE> dht_a, dht_b;
+        tox_self_get_dht_id(tox_a, dht_a.data());
+        tox_self_get_dht_id(tox_a, dht_b.data());
         TOX_ERR_GET_PORT error;
         auto port_a = tox_self_get_udp_port(tox_a, &error);
         TS_ASSERT_EQUALS(error, TOX_ERR_GET_PORT_OK);
         auto port_b = tox_self_get_udp_port(tox_b, &error);
         TS_ASSERT_EQUALS(error, TOX_ERR_GET_PORT_OK);
         TOX_ERR_BOOTSTRAP bootstrap_error;
-        tox_bootstrap(tox_a, "127.0.0.1", port_b, dht_b, &bootstrap_error);
+        tox_bootstrap(tox_a, "127.0.0.1", port_b, dht_b.data(), &bootstrap_error);
         TS_ASSERT_EQUALS(bootstrap_error, TOX_ERR_BOOTSTRAP_OK);
-        tox_bootstrap(tox_b, "127.0.0.1", port_a, dht_a, &bootstrap_error);
+        tox_bootstrap(tox_b, "127.0.0.1", port_a, dht_a.data(), &bootstrap_error);
         TS_ASSERT_EQUALS(bootstrap_error, TOX_ERR_BOOTSTRAP_OK);
 
         contact_a = core_b->contact_manager()->find(core_a->property_addr_public());
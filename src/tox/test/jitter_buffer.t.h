@@ -0,0 +1,114 @@
+#include <cxxtest/TestSuite.h>
+
+#include "../jitter_buffer.h"
+#include <vector>
+
+class TestJitterBuffer : public CxxTest::TestSuite
+{
+    private:
+        //20 ms of a constant level
+        static toxmm::av::audio frame(toxmm::av::audio::sr rate,
+                                      toxmm::av::audio::ch channels,
+                                      int16_t level) {
+            toxmm::av::audio ad(toxmm::av::audio::al(20), channels, rate);
+            std::fill(ad.data(), ad.data() + ad.size(), level);
+            return ad;
+        }
+
+        static const size_t ms10 = toxmm::jitter_buffer::rate / 100
+                                 * toxmm::jitter_buffer::channels;
+
+    public:
+        void test_ring_wraparound() {
+            toxmm::audio_ring ring(5);
+            TS_ASSERT_EQUALS(ring.capacity(), 8u);
+
+            const int16_t a[] = {1, 2, 3, 4, 5, 6};
+            int16_t out[8] = {};
+            TS_ASSERT(ring.write(a, 6));
+            TS_ASSERT_EQUALS(ring.read(out, 4), 4u);
+            TS_ASSERT(ring.write(a, 6));
+            TS_ASSERT(!ring.write(a, 1));
+            TS_ASSERT_EQUALS(ring.available(), 8u);
+            TS_ASSERT_EQUALS(ring.skip(2), 2u);
+            TS_ASSERT_EQUALS(ring.read(out, 8), 6u);
+            const int16_t expected[] = {1, 2, 3, 4, 5, 6};
+            TS_ASSERT_SAME_DATA(out, expected, sizeof(expected));
+            TS_ASSERT_EQUALS(ring.available(), 0u);
+        }
+
+        void test_resample() {
+            toxmm::jitter_buffer jb;
+            //8 kHz mono becomes 48 kHz stereo
+            jb.push(frame(toxmm::av::audio::SAMPLING_RATE_8000,
+                          toxmm::av::audio::CHANNELS_MONO, 1000), 0);
+            jb.push(frame(toxmm::av::audio::SAMPLING_RATE_8000,
+                          toxmm::av::audio::CHANNELS_MONO, 1000), 20000);
+            jb.push(frame(toxmm::av::audio::SAMPLING_RATE_8000,
+                          toxmm::av::audio::CHANNELS_MONO, 1000), 40000);
+            jb.push(frame(toxmm::av::audio::SAMPLING_RATE_8000,
+                          toxmm::av::audio::CHANNELS_MONO, 1000), 60000);
+
+            std::vector<int16_t> out(ms10);
+            jb.pull(out.data(), out.size());
+            TS_ASSERT_EQUALS(jb.underruns(), 0u);
+            TS_ASSERT_DELTA(jb.latency(), 70.0, 0.01);
+            //past the ramp up from silence it's the input level on both channels
+            TS_ASSERT_EQUALS(out[0], 1000 / 6);
+            TS_ASSERT_EQUALS(out[1], 1000 / 6);
+            TS_ASSERT_EQUALS(out.back(), 1000);
+        }
+
+        void test_target_follows_jitter() {
+            toxmm::jitter_buffer jb;
+            gint64 now = 0;
+            for (int i = 0; i < 50; ++i) {
+                now += 20000;
+                jb.push(frame(toxmm::av::audio::SAMPLING_RATE_48000,
+                              toxmm::av::audio::CHANNELS_STEREO, 1), now);
+            }
+            auto steady = jb.target();
+            TS_ASSERT_DELTA(steady, 40.0, 0.01);
+
+            toxmm::jitter_buffer jittery;
+            now = 0;
+            for (int i = 0; i < 50; ++i) {
+                now += (i % 2) ? 5000 : 35000;
+                jittery.push(frame(toxmm::av::audio::SAMPLING_RATE_48000,
+                                   toxmm::av::audio::CHANNELS_STEREO, 1), now);
+            }
+            TS_ASSERT(jittery.target() > steady + 20.0);
+            TS_ASSERT(jittery.target() <= 300.0);
+        }
+
+        void test_underrun_and_drain() {
+            toxmm::jitter_buffer jb;
+            std::vector<int16_t> out(ms10);
+
+            //nothing buffered yet, silence without counting an underrun
+            jb.pull(out.data(), out.size());
+            TS_ASSERT_EQUALS(jb.underruns(), 0u);
+
+            gint64 now = 0;
+            for (int i = 0; i < 3; ++i) {
+                now += 20000;
+                jb.push(frame(toxmm::av::audio::SAMPLING_RATE_48000,
+                              toxmm::av::audio::CHANNELS_STEREO, 7), now);
+            }
+            for (int i = 0; i < 7; ++i) {
+                jb.pull(out.data(), out.size());
+            }
+            TS_ASSERT_EQUALS(jb.underruns(), 1u);
+            TS_ASSERT_EQUALS(out[0], 0);
+
+            //a burst well above the target gets drained
+            for (int i = 0; i < 20; ++i) {
+                jb.push(frame(toxmm::av::audio::SAMPLING_RATE_48000,
+                              toxmm::av::audio::CHANNELS_STEREO, 7), now);
+            }
+            jb.pull(out.data(), out.size());
+            TS_ASSERT_EQUALS(jb.overruns(), 1u);
+            TS_ASSERT(jb.latency() <= jb.target());
+            TS_ASSERT_EQUALS(out[0], 7);
+        }
+};
@@ -0,0 +1,130 @@
+#include <cxxtest/TestSuite.h>
+
+#include "../log_index.h"
+#include "global_fixture.t.h"
+#include <algorithm>
+
+class TestLogIndex : public CxxTest::TestSuite
+{
+    public:
+        uint32_t day(int d, int m, int y) {
+            return Glib::Date(d, Glib::Date::Month(m), y).get_julian();
+        }
+
+        std::vector<uint32_t> items(const std::vector<toxmm::log_index::hit>& hits) {
+            std::vector<uint32_t> res;
+            for (auto& h : hits) {
+                res.push_back(h.item);
+            }
+            return res;
+        }
+
+        void test_find() {
+            auto storage = std::make_shared<GlobalFixture::MockStorage>();
+            toxmm::log_index index(storage, "ADDR");
+            auto d1 = day(1, 3, 2016);
+            auto d2 = day(2, 3, 2016);
+            index.add(d1, 0, {"Hello there, Alice!"});
+            index.add(d1, 1, {"did you get the file?"});
+            index.add(d1, 2, {"holiday.png"});
+            index.add(d2, 0, {"M\xC3\xBCnchen is nice"});
+            index.add(d2, 1, {"hello again"});
+
+            //whole words and prefixes, newest first
+            TS_ASSERT_EQUALS(items(index.find("hello")), (std::vector<uint32_t>{1, 0}));
+            TS_ASSERT_EQUALS(index.find("hello").front().day, d2);
+            TS_ASSERT_EQUALS(items(index.find("hol")), (std::vector<uint32_t>{2}));
+            TS_ASSERT_EQUALS(items(index.find("png")), (std::vector<uint32_t>{2}));
+            //case insensitive
+            TS_ASSERT_EQUALS(items(index.find("ALI")), (std::vector<uint32_t>{0}));
+            TS_ASSERT_EQUALS(items(index.find("m\xC3\x9CN")), (std::vector<uint32_t>{0}));
+            //every word has to match, in any order
+            TS_ASSERT_EQUALS(items(index.find("again hel")), (std::vector<uint32_t>{1}));
+            TS_ASSERT_EQUALS(items(index.find("hello file")), (std::vector<uint32_t>{}));
+            //only at the start of words
+            TS_ASSERT_EQUALS(items(index.find("ello")), (std::vector<uint32_t>{}));
+            TS_ASSERT_EQUALS(items(index.find(" ,! ")), (std::vector<uint32_t>{}));
+            TS_ASSERT_EQUALS(index.find("h", 2).size(), 2u);
+
+            //saved, another instance sees the same
+            toxmm::log_index again(storage, "ADDR");
+            TS_ASSERT_EQUALS(items(again.find("hello")), (std::vector<uint32_t>{1, 0}));
+            TS_ASSERT_EQUALS(again.days(), (std::vector<uint32_t>{d1, d2}));
+            TS_ASSERT(!again.complete());
+        }
+
+        void test_deferred_save() {
+            auto storage = std::make_shared<GlobalFixture::MockStorage>();
+            auto d1 = day(1, 3, 2016);
+            auto d2 = day(2, 3, 2016);
+            std::vector<uint8_t> content;
+            {
+                toxmm::log_index index(storage, "ADDR");
+                index.add(d1, 0, {"first"});
+                index.add(d1, 1, {"second"});
+                //held back until the burst is over
+                storage->load({"ADDR", "index", "2016-03-01"}, content);
+                TS_ASSERT(content.empty());
+
+                //another day saves the one before
+                index.add(d2, 0, {"third"});
+                storage->load({"ADDR", "index", "2016-03-01"}, content);
+                TS_ASSERT(!content.empty());
+                storage->load({"ADDR", "index", "2016-03-02"}, content);
+                TS_ASSERT(content.empty());
+
+                //queries see everything
+                TS_ASSERT_EQUALS(items(index.find("second")), (std::vector<uint32_t>{1}));
+                TS_ASSERT_EQUALS(items(index.find("third")), (std::vector<uint32_t>{0}));
+                index.add(d2, 1, {"fourth"});
+            }
+            //and nothing is lost when the index goes away
+            toxmm::log_index again(storage, "ADDR");
+            TS_ASSERT_EQUALS(items(again.find("fourth")), (std::vector<uint32_t>{1}));
+        }
+
+        void test_many_segments() {
+            //more segments than are cached, queries still find all of them
+            auto storage = std::make_shared<GlobalFixture::MockStorage>();
+            toxmm::log_index index(storage, "ADDR");
+            auto first = day(1, 3, 2016);
+            const uint32_t n = toxmm::log_index::cache_segments * 2;
+            for (uint32_t d = first; d < first + n; ++d) {
+                index.set_day(d, {{"common"}, {"day " + std::to_string(d)}});
+            }
+            TS_ASSERT_EQUALS(index.find("common", 0).size(), size_t(n));
+            TS_ASSERT_EQUALS(index.find("common", 0).size(), size_t(n));
+            auto hits = index.find(std::to_string(first));
+            TS_ASSERT_EQUALS(hits.size(), 1u);
+            TS_ASSERT_EQUALS(hits.front().day, first);
+        }
+
+        void test_rebuild() {
+            auto storage = std::make_shared<GlobalFixture::MockStorage>();
+            toxmm::log_index index(storage, "ADDR");
+            auto jan = day(31, 1, 2016);
+            auto feb = day(1, 2, 2016);
+            auto today = day(2, 3, 2016);
+            index.add(today, 0, {"new message"});
+            index.set_day(jan, {{"first message"}, {"second"}});
+            index.set_day(feb, {{"third message"}});
+            index.set_day(feb, {{"third message"}, {"fourth message"}});
+            index.set_complete(true);
+            TS_ASSERT_EQUALS(items(index.find("message")), (std::vector<uint32_t>{0, 1, 0, 0}));
+
+            index.compact(today);
+            std::vector<std::string> names;
+            storage->list({"ADDR", "index"}, names);
+            std::sort(names.begin(), names.end());
+            TS_ASSERT_EQUALS(names, (std::vector<std::string>{"2016-01", "2016-02", "2016-03-02", "manifest"}));
+            TS_ASSERT_EQUALS(items(index.find("message")), (std::vector<uint32_t>{0, 1, 0, 0}));
+
+            //days of compacted months can still be added to
+            index.add(feb, 2, {"late message"});
+            index.compact(today);
+            toxmm::log_index again(storage, "ADDR");
+            TS_ASSERT(again.complete());
+            TS_ASSERT_EQUALS(items(again.find("mes")), (std::vector<uint32_t>{0, 2, 1, 0, 0}));
+            TS_ASSERT_EQUALS(again.days(), (std::vector<uint32_t>{jan, feb, today}));
+        }
+};
@@ -0,0 +1,242 @@
+#include <cxxtest/TestSuite.h>
+
+#include "../log_segment.h"
+#include "../flatbuffers/generated/LogSegment_generated.h"
+#include "global_fixture.t.h"
+#include <stdexcept>
+
+class TestLogSegment : public CxxTest::TestSuite
+{
+    public:
+        const std::string alice = "8E7D0B859922EF569298B4D261A8CCB5FEA14FB91ED412A7603A585A25698832";
+        const std::string bob   = "76518406F6A9F2217E8DC487CC783C25CC16A15EB36FF32E335A235342C48A39";
+
+        //a plain collection of messages "0", "1", .. alternating the sender
+        std::vector<uint8_t> plain(size_t count, size_t first = 0) {
+            flatbuffers::FlatBufferBuilder fbb;
+            std::vector<flatbuffers::Offset<flatbuffers::Log::Item>> items;
+            for (auto i = first; i < first + count; ++i) {
+                auto sender = fbb.CreateString(i % 2 ? bob : alice);
+                auto message = fbb.CreateString(std::to_string(i));
+                auto data = flatbuffers::Log::CreateMessage(
+                                fbb, message, flatbuffers::Log::MessageStatus::DONE).Union();
+                items.push_back(flatbuffers::Log::CreateItem(fbb,
+                                                             sender,
+                                                             1000 + i,
+                                                             flatbuffers::Log::Data::Message,
+                                                             data));
+            }
+            flatbuffers::Log::FinishCollectionBuffer(
+                        fbb,
+                        flatbuffers::Log::CreateCollection(fbb, fbb.CreateVector(items)));
+            return std::vector<uint8_t>(fbb.GetBufferPointer(),
+                                        fbb.GetBufferPointer() + fbb.GetSize());
+        }
+
+        void append(toxmm::log_segment& segment, size_t count) {
+            auto content = plain(count, segment.size());
+            auto items = flatbuffers::Log::GetCollection(content.data())->items();
+            for (size_t i = 0; i < items->size(); ++i) {
+                TS_ASSERT_EQUALS(segment.append(items->Get(i)), segment.size() - 1);
+            }
+        }
+
+        //every item is where plain() put it
+        void check(toxmm::log_segment& segment, size_t count) {
+            TS_ASSERT_EQUALS(segment.size(), count);
+            for (size_t i = 0; i < count; ++i) {
+                auto item = segment.item(i);
+                TS_ASSERT_EQUALS(item->timestamp(), 1000 + i);
+                TS_ASSERT_EQUALS(segment.address(item->sender()), i % 2 ? bob : alice);
+                TS_ASSERT_EQUALS(item->data_type(), flatbuffers::Log::Data::Message);
+                auto message = reinterpret_cast<const flatbuffers::Log::Message*>(item->data());
+                TS_ASSERT_EQUALS(message->message()->str(), std::to_string(i));
+                TS_ASSERT_EQUALS(message->status(), flatbuffers::Log::MessageStatus::DONE);
+            }
+        }
+
+        //a segment with a single block
+        std::vector<uint8_t> single_block(uint32_t items, uint32_t size, const std::vector<uint8_t>& data) {
+            flatbuffers::FlatBufferBuilder fbb;
+            std::vector<flatbuffers::Offset<flatbuffers::LogSegment::Block>> blocks {
+                flatbuffers::LogSegment::CreateBlock(fbb, items, size, fbb.CreateVector(data))
+            };
+            std::vector<flatbuffers::Offset<flatbuffers::String>> keys {
+                fbb.CreateString(alice), fbb.CreateString(bob)
+            };
+            flatbuffers::LogSegment::FinishSegmentBuffer(
+                        fbb,
+                        flatbuffers::LogSegment::CreateSegment(fbb,
+                                                               fbb.CreateVector(keys),
+                                                               fbb.CreateVector(blocks)));
+            return std::vector<uint8_t>(fbb.GetBufferPointer(),
+                                        fbb.GetBufferPointer() + fbb.GetSize());
+        }
+
+        void test_round_trip() {
+            toxmm::log_segment segment;
+            segment.parse({});
+            TS_ASSERT_EQUALS(segment.size(), 0u);
+
+            append(segment, 150);
+            check(segment, 150);
+
+            auto content = segment.serialize();
+            TS_ASSERT(flatbuffers::LogSegment::SegmentBufferHasIdentifier(content.data()));
+            toxmm::log_segment again;
+            again.parse(content);
+            check(again, 150);
+            //and again after reading it
+            TS_ASSERT_EQUALS(again.serialize(), content);
+
+            //appending to a parsed day
+            append(again, 10);
+            check(again, 160);
+        }
+
+        void test_block_boundary() {
+            const auto n = toxmm::log_segment::block_items;
+            toxmm::log_segment segment;
+
+            //one short of a block stays in the tail
+            append(segment, n - 1);
+            auto content = segment.serialize();
+            auto saved = flatbuffers::LogSegment::GetSegment(content.data());
+            TS_ASSERT_EQUALS(saved->blocks()->size(), 0u);
+            check(segment, n - 1);
+
+            //the last one fills it
+            append(segment, 1);
+            content = segment.serialize();
+            saved = flatbuffers::LogSegment::GetSegment(content.data());
+            TS_ASSERT_EQUALS(saved->blocks()->size(), 1u);
+            TS_ASSERT_EQUALS(saved->blocks()->Get(0)->items(), n);
+            TS_ASSERT_EQUALS(saved->tail()->size(), 0u);
+            check(segment, n);
+
+            //the next starts a new tail
+            append(segment, n + 1);
+            content = segment.serialize();
+            saved = flatbuffers::LogSegment::GetSegment(content.data());
+            TS_ASSERT_EQUALS(saved->blocks()->size(), 2u);
+            TS_ASSERT_DIFFERS(saved->tail()->size(), 0u);
+            check(segment, 2 * n + 1);
+
+            //items on both sides of each boundary, read from disk
+            toxmm::log_segment again;
+            again.parse(content);
+            for (auto i : { size_t(0), n - 1, n, 2 * n - 1, 2 * n }) {
+                TS_ASSERT_EQUALS(again.item(i)->timestamp(), 1000 + i);
+            }
+        }
+
+        void test_addresses() {
+            toxmm::log_segment segment;
+            append(segment, 4);
+
+            flatbuffers::FlatBufferBuilder fbb;
+            auto file = flatbuffers::Log::CreateFile(fbb,
+                                                     fbb.CreateString("uuid"),
+                                                     fbb.CreateString("name.png"),
+                                                     fbb.CreateString("/tmp/name.png"),
+                                                     flatbuffers::Log::FileStatus::DONE,
+                                                     fbb.CreateString(alice)).Union();
+            fbb.Finish(flatbuffers::Log::CreateItem(fbb,
+                                                    fbb.CreateString(bob),
+                                                    1004,
+                                                    flatbuffers::Log::Data::File,
+                                                    file));
+            auto index = segment.append(flatbuffers::GetRoot<flatbuffers::Log::Item>(fbb.GetBufferPointer()));
+            TS_ASSERT_EQUALS(index, 4u);
+
+            //saved once, referred to by number
+            auto content = segment.serialize();
+            auto saved = flatbuffers::LogSegment::GetSegment(content.data());
+            TS_ASSERT_EQUALS(saved->keys()->size(), 2u);
+            TS_ASSERT_EQUALS(saved->keys()->Get(0)->str(), alice);
+            TS_ASSERT_EQUALS(saved->keys()->Get(1)->str(), bob);
+
+            toxmm::log_segment again;
+            again.parse(content);
+            auto item = again.item(index);
+            TS_ASSERT_EQUALS(item->sender()->str(), "#1");
+            TS_ASSERT_EQUALS(again.address(item->sender()), bob);
+            TS_ASSERT_EQUALS(item->data_type(), flatbuffers::Log::Data::File);
+            auto f = reinterpret_cast<const flatbuffers::Log::File*>(item->data());
+            TS_ASSERT_EQUALS(f->receiver()->str(), "#0");
+            TS_ASSERT_EQUALS(again.address(f->receiver()), alice);
+            TS_ASSERT_EQUALS(f->name()->str(), "name.png");
+            TS_ASSERT_EQUALS(f->path()->str(), "/tmp/name.png");
+            TS_ASSERT_EQUALS(f->status(), flatbuffers::Log::FileStatus::DONE);
+
+            //not in the dictionary, taken as it is
+            flatbuffers::FlatBufferBuilder str;
+            str.Finish(str.CreateString("#7"));
+            TS_ASSERT_EQUALS(again.address(flatbuffers::GetRoot<flatbuffers::String>(str.GetBufferPointer())), "#7");
+            TS_ASSERT_EQUALS(again.address(nullptr), "");
+        }
+
+        void test_convert_plain() {
+            auto content = plain(100);
+            toxmm::log_segment segment;
+            segment.parse(content);
+            check(segment, 100);
+            //read as it is, saved as it is until changed
+            TS_ASSERT_EQUALS(segment.serialize(), content);
+
+            append(segment, 1);
+            check(segment, 101);
+            //an item of the day itself
+            toxmm::log_segment copy;
+            copy.parse(content);
+            TS_ASSERT_EQUALS(copy.append(copy.item(0)), 100u);
+            TS_ASSERT_EQUALS(copy.item(100)->timestamp(), 1000u);
+            TS_ASSERT_EQUALS(copy.address(copy.item(100)->sender()), alice);
+
+            auto converted = segment.serialize();
+            TS_ASSERT(flatbuffers::LogSegment::SegmentBufferHasIdentifier(converted.data()));
+            TS_ASSERT_LESS_THAN(converted.size(), content.size());
+
+            toxmm::log_segment again;
+            again.parse(converted);
+            check(again, 101);
+        }
+
+        void test_corrupt() {
+            toxmm::log_segment segment;
+            TS_ASSERT_THROWS(segment.parse({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}), std::runtime_error);
+
+            //a valid block to break
+            const auto n = toxmm::log_segment::block_items;
+            append(segment, n);
+            auto content = segment.serialize();
+            auto block = flatbuffers::LogSegment::GetSegment(content.data())->blocks()->Get(0);
+            std::vector<uint8_t> data(block->data()->begin(), block->data()->end());
+            auto size = block->size();
+
+            //no items
+            TS_ASSERT_THROWS(segment.parse(single_block(0, size, data)), std::runtime_error);
+
+            //blocks are checked when they are read
+            auto read = [&](const std::vector<uint8_t>& content) {
+                toxmm::log_segment s;
+                s.parse(content);
+                s.item(0);
+            };
+            TS_ASSERT_THROWS_NOTHING(read(single_block(n, size, data)));
+            //item count
+            TS_ASSERT_THROWS(read(single_block(n - 1, size, data)), std::runtime_error);
+            //uncompressed size
+            TS_ASSERT_THROWS(read(single_block(n, size + 1, data)), std::runtime_error);
+            TS_ASSERT_THROWS(read(single_block(n, size - 1, data)), std::runtime_error);
+            //compressed data
+            auto cut = data;
+            cut.resize(cut.size() / 2);
+            TS_ASSERT_THROWS(read(single_block(n, size, cut)), std::runtime_error);
+            auto garbage = data;
+            for (size_t i = 0; i < garbage.size(); i += 3) {
+                garbage[i] ^= 0x5A;
+            }
+            TS_ASSERT_THROWS(read(single_block(n, size, garbage)), std::runtime_error);
+        }
+};
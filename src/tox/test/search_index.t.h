@@ -0,0 +1,48 @@
+#include <cxxtest/TestSuite.h>
+
+#include "../search_index.h"
+
+class TestSearchIndex : public CxxTest::TestSuite
+{
+    public:
+        void test_find() {
+            toxmm::search_index index;
+            index.set(1, {"Alice Smith", "at work", "0A1B2C"});
+            index.set(2, {"Bob", "gone fishing", "FF00AA"});
+            index.set(3, {"M\xC3\xBCller", "", "0A9999"});
+
+            //prefixes of words
+            TS_ASSERT_EQUALS(index.find("a"), (std::vector<uint32_t>{1}));
+            TS_ASSERT_EQUALS(index.find("SM"), (std::vector<uint32_t>{1}));
+            TS_ASSERT_EQUALS(index.find("0a"), (std::vector<uint32_t>{1, 3}));
+            //but not the middle of them
+            TS_ASSERT_EQUALS(index.find("li"), (std::vector<uint32_t>{}));
+            //longer words match anywhere
+            TS_ASSERT_EQUALS(index.find("lic"), (std::vector<uint32_t>{1}));
+            TS_ASSERT_EQUALS(index.find("fish"), (std::vector<uint32_t>{2}));
+            TS_ASSERT_EQUALS(index.find("M\xC3\x9CLL"), (std::vector<uint32_t>{3}));
+            //every word has to match
+            TS_ASSERT_EQUALS(index.find("alice work"), (std::vector<uint32_t>{1}));
+            TS_ASSERT_EQUALS(index.find("alice fish"), (std::vector<uint32_t>{}));
+            //all trigrams there, but not in that order
+            TS_ASSERT_EQUALS(index.find("ali smi"), (std::vector<uint32_t>{1}));
+            TS_ASSERT_EQUALS(index.find("alicesmith"), (std::vector<uint32_t>{}));
+            //fields don't run into each other
+            TS_ASSERT_EQUALS(index.find("bobgone"), (std::vector<uint32_t>{}));
+            TS_ASSERT_EQUALS(index.find("  "), (std::vector<uint32_t>{1, 2, 3}));
+        }
+
+        void test_update() {
+            toxmm::search_index index;
+            index.set(1, {"Alice"});
+            index.set(2, {"Bob"});
+            index.set(1, {"Carol"});
+            TS_ASSERT_EQUALS(index.size(), 2u);
+            TS_ASSERT_EQUALS(index.find("ali"), (std::vector<uint32_t>{}));
+            TS_ASSERT_EQUALS(index.find("car"), (std::vector<uint32_t>{1}));
+            index.remove(2);
+            index.remove(42);
+            TS_ASSERT_EQUALS(index.find("b"), (std::vector<uint32_t>{}));
+            TS_ASSERT_EQUALS(index.size(), 1u);
+        }
+};
@@ -83,6 +83,26 @@ class TestTypes : public CxxTest::TestSuite
                         "0100000000000000000000000000000000000000000000000000000000000000");
             TS_ASSERT_EQUALS(toxmm::contactAddrPublic(b),
                              toxmm::contactAddrPublic((const uint8_t[]){1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}));
+            //hex encoded with the key, shared by copies
+            {
+                toxmm::contactAddrPublic tmp(b);
+                const std::string& hex = tmp.hex();
+                TS_ASSERT_EQUALS(hex, "0100000000000000000000000000000000000000000000000000000000000000");
+                toxmm::contactAddrPublic copy(tmp);
+                TS_ASSERT_EQUALS(&copy.hex(), &hex);
+                copy = toxmm::contactAddrPublic(c);
+                TS_ASSERT_EQUALS(copy.hex(), "0200000000000000000000000000000000000000000000000000000000000000");
+                TS_ASSERT_EQUALS(tmp.hex(), "0100000000000000000000000000000000000000000000000000000000000000");
+                TS_ASSERT_EQUALS(toxmm::contactAddrPublic("0a" + hex.substr(2)).hex(),
+                                 "0A00000000000000000000000000000000000000000000000000000000000000");
+                TS_ASSERT_EQUALS(toxmm::contactAddrPublic().hex(), std::string(toxmm::contactAddrPublic::hex_size, '0'));
+            }
+            //fixed size, no allocation
+            {
+                char hex[toxmm::contactAddrPublic::hex_size];
+                toxmm::contactAddrPublic(b).write_hex(hex);
+                TS_ASSERT_EQUALS(std::string(hex, sizeof(hex)), "0100000000000000000000000000000000000000000000000000000000000000");
+            }
         }
 
         void test_contactAddr() {
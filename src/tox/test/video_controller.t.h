@@ -0,0 +1,70 @@
+#include <cxxtest/TestSuite.h>
+
+#include "../contact/video_controller.h"
+
+class TestVideoController : public CxxTest::TestSuite
+{
+    private:
+        //feeds fps frames per second for the given time
+        static void run(toxmm::video_controller& ctrl, gint64& now, gint64 duration,
+                        int fps, int failed_every = 0) {
+            gint64 step = G_USEC_PER_SEC / fps;
+            int n = 0;
+            for (gint64 end = now + duration; now < end; now += step) {
+                if (failed_every && ++n % failed_every == 0) {
+                    ctrl.frame_failed(now);
+                } else {
+                    ctrl.frame_sent(now);
+                }
+                ctrl.update(now);
+            }
+        }
+
+    public:
+        void test_levels() {
+            auto& levels = toxmm::video_controller::levels();
+            TS_ASSERT(levels.size() > 1);
+            for (size_t i = 0; i < levels.size(); ++i) {
+                TS_ASSERT_EQUALS(levels[i].width % 8, 0);
+                TS_ASSERT_EQUALS(levels[i].height % 2, 0);
+                if (i > 0) {
+                    TS_ASSERT(levels[i].kilobitrate > levels[i - 1].kilobitrate);
+                }
+            }
+        }
+
+        void test_suggestion_caps_level() {
+            toxmm::video_controller ctrl;
+            ctrl.suggest(5000);
+            TS_ASSERT_EQUALS(ctrl.current_index(), toxmm::video_controller::levels().size() - 1);
+            ctrl.suggest(100);
+            TS_ASSERT(ctrl.current().kilobitrate <= 150);
+            TS_ASSERT_EQUALS(ctrl.kilobitrate(), 100u);
+        }
+
+        void test_backoff_and_recover() {
+            toxmm::video_controller ctrl;
+            gint64 now = 0;
+            ctrl.suggest(5000);
+            auto top = ctrl.current_index();
+
+            //every 4th frame fails
+            run(ctrl, now, G_USEC_PER_SEC * 3, 30, 4);
+            TS_ASSERT(ctrl.current_index() < top);
+
+            //dropped frames count as congestion too
+            auto after_failures = ctrl.current_index();
+            for (int i = 0; i < 3; ++i) {
+                ctrl.frames_dropped(30, now);
+                run(ctrl, now, G_USEC_PER_SEC, 30);
+            }
+            TS_ASSERT(ctrl.current_index() < after_failures || ctrl.current_index() == 0);
+
+            //clean run climbs back, one step per hold time
+            auto low = ctrl.current_index();
+            run(ctrl, now, toxmm::video_controller::hold + toxmm::video_controller::window * 2, 30);
+            TS_ASSERT_EQUALS(ctrl.current_index(), low + 1);
+            run(ctrl, now, G_USEC_PER_SEC * 60, 30);
+            TS_ASSERT_EQUALS(ctrl.current_index(), top);
+        }
+};
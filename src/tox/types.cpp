@@ -30,47 +30,72 @@ extern "C"
 
 using namespace toxmm;
 
+constexpr size_t contactAddrPublic::hex_size;
+constexpr size_t contactAddr::hex_size;
+constexpr size_t fileId::hex_size;
+constexpr size_t hash::hex_size;
+
 std::string contactAddr::to_hex() {
-    return core::to_hex(m_addr.begin(), m_addr.size());
+    std::string tmp(hex_size, 0);
+    write_hex(&tmp[0]);
+    return tmp;
+}
+
+void contactAddr::write_hex(char* out) const {
+    core::to_hex(m_addr.data(), m_addr.size(), out);
 }
 
 decltype(contactAddr::m_addr) contactAddr::from_hex(const std::string& hex) {
-    decltype(contactAddr::m_addr) tmp;
-    auto tmp_hex = core::from_hex(hex);
-    std::copy(tmp_hex.begin(), tmp_hex.begin() + std::min(tmp_hex.size(), tmp.size()), tmp.begin());
+    decltype(contactAddr::m_addr) tmp = {};
+    core::from_hex(hex.data(), std::min(hex.size(), tmp.size() * 2), tmp.data());
+    return tmp;
+}
+
+std::shared_ptr<const std::string> contactAddrPublic::to_hex(const decltype(m_addr)& addr) {
+    auto tmp = std::make_shared<std::string>(hex_size, 0);
+    core::to_hex(addr.data(), addr.size(), &(*tmp)[0]);
     return tmp;
 }
 
-std::string contactAddrPublic::to_hex() {
-    return core::to_hex(m_addr.begin(), m_addr.size());
+void contactAddrPublic::write_hex(char* out) const {
+    core::to_hex(m_addr.data(), m_addr.size(), out);
 }
 
 decltype(contactAddrPublic::m_addr) contactAddrPublic::from_hex(const std::string& hex) {
-    decltype(contactAddrPublic::m_addr) tmp;
-    auto tmp_hex = core::from_hex(hex);
-    std::copy(tmp_hex.begin(), tmp_hex.begin() + std::min(tmp_hex.size(), tmp.size()), tmp.begin());
+    decltype(contactAddrPublic::m_addr) tmp = {};
+    core::from_hex(hex.data(), std::min(hex.size(), tmp.size() * 2), tmp.data());
     return tmp;
 }
 
 std::string fileId::to_hex() {
-    return core::to_hex(m_id.begin(), m_id.size());
+    std::string tmp(hex_size, 0);
+    write_hex(&tmp[0]);
+    return tmp;
+}
+
+void fileId::write_hex(char* out) const {
+    core::to_hex(m_id.data(), m_id.size(), out);
 }
 
 decltype(fileId::m_id) fileId::from_hex(const std::string& hex) {
-    decltype(fileId::m_id) tmp;
-    auto tmp_hex = core::from_hex(hex);
-    std::copy(tmp_hex.begin(), tmp_hex.begin() + std::min(tmp_hex.size(), tmp.size()), tmp.begin());
+    decltype(fileId::m_id) tmp = {};
+    core::from_hex(hex.data(), std::min(hex.size(), tmp.size() * 2), tmp.data());
     return tmp;
 }
 
 std::string hash::to_hex() {
-    return core::to_hex(m_hash.begin(), m_hash.size());
+    std::string tmp(hex_size, 0);
+    write_hex(&tmp[0]);
+    return tmp;
+}
+
+void hash::write_hex(char* out) const {
+    core::to_hex(m_hash.data(), m_hash.size(), out);
 }
 
 decltype(hash::m_hash) hash::from_hex(const std::string& hex) {
-    decltype(hash::m_hash) tmp;
-    auto tmp_hex = core::from_hex(hex);
-    std::copy(tmp_hex.begin(), tmp_hex.begin() + std::min(tmp_hex.size(), tmp.size()), tmp.begin());
+    decltype(hash::m_hash) tmp = {};
+    core::from_hex(hex.data(), std::min(hex.size(), tmp.size() * 2), tmp.data());
     return tmp;
 }
 
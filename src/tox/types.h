@@ -29,6 +29,7 @@ namespace toxmm {
     class contact_manager;
     class profile;
     class av;
+    class bootstrap;
 
     class contactNr {
         private:
@@ -84,20 +85,27 @@ namespace toxmm {
     class contactAddrPublic {
         private:
             std::array<uint8_t, TOX_PUBLIC_KEY_SIZE> m_addr;
-            std::string to_hex();
+            //encoded with every new key, shared between copies
+            std::shared_ptr<const std::string> m_hex;
             decltype(m_addr) from_hex(const std::string& hex);
+            static std::shared_ptr<const std::string> to_hex(const decltype(m_addr)& addr);
         public:
+            static constexpr size_t hex_size = TOX_PUBLIC_KEY_SIZE * 2;
             operator decltype(m_addr)() { return m_addr; }
-            operator std::string() { return to_hex(); }
-            operator uint8_t*() { return m_addr.data(); }
-            contactAddrPublic(): m_addr() {}
-            contactAddrPublic(const uint8_t* addr) {
+            operator std::string() { return hex(); }
+            //read only, the hex has to match the key
+            operator const uint8_t*() const { return m_addr.data(); }
+            const std::string& hex() const { return *m_hex; }
+            void write_hex(char* out) const;
+            contactAddrPublic(): m_addr(), m_hex(to_hex(m_addr)) {}
+            contactAddrPublic(const uint8_t* addr): m_addr() {
                 if (addr != nullptr) {
                     std::copy(addr, addr + m_addr.size(), m_addr.begin());
                 }
+                m_hex = to_hex(m_addr);
             }
-            contactAddrPublic(decltype(m_addr) addr): m_addr(addr) {}
-            contactAddrPublic(const std::string& addr): m_addr(from_hex(addr)) {}
+            contactAddrPublic(decltype(m_addr) addr): m_addr(addr), m_hex(to_hex(m_addr)) {}
+            contactAddrPublic(const std::string& addr): m_addr(from_hex(addr)), m_hex(to_hex(m_addr)) {}
             bool operator==(const contactAddrPublic& o) const { return m_addr == o.m_addr; }
             bool operator!=(const contactAddrPublic& o) const { return m_addr != o.m_addr; }
             bool operator< (const contactAddrPublic& o) const { return m_addr <  o.m_addr; }
@@ -116,6 +124,8 @@ namespace toxmm {
            operator std::string() { return to_hex(); }
            operator uint8_t*() { return m_addr.data(); }
            operator contactAddrPublic() { return contactAddrPublic(m_addr.data()); }
+           static constexpr size_t hex_size = TOX_ADDRESS_SIZE * 2;
+           void write_hex(char* out) const;
            contactAddr(): m_addr() {}
            contactAddr(const uint8_t* addr) {
                if (addr != nullptr) {
@@ -141,6 +151,8 @@ namespace toxmm {
             operator decltype(m_id)() { return m_id; }
             operator std::string() { return to_hex(); }
             operator uint8_t*() { return m_id.data(); }
+            static constexpr size_t hex_size = TOX_FILE_ID_LENGTH * 2;
+            void write_hex(char* out) const;
             fileId(): m_id() {}
             fileId(const uint8_t* id) {
                 if (id != nullptr) {
@@ -182,6 +194,8 @@ namespace toxmm {
             operator decltype(m_hash)() { return m_hash; }
             operator std::string() { return to_hex(); }
             operator uint8_t*() { return m_hash.data(); }
+            static constexpr size_t hex_size = TOX_HASH_LENGTH * 2;
+            void write_hex(char* out) const;
             hash(): m_hash() {}
             hash(const uint8_t* hash) {
                 if (hash != nullptr) {
@@ -0,0 +1,181 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "audio_capture.h"
+#include <gstreamermm/bus.h>
+#include <gstreamermm/elementfactory.h>
+#include <gstreamermm/systemclock.h>
+#include <iostream>
+#include <vector>
+
+#ifndef SIGC_CPP11_HACK
+#define SIGC_CPP11_HACK
+namespace sigc {
+    SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
+}
+#endif
+
+using namespace utils;
+
+namespace {
+    //device buffer and period in microseconds, normal and low latency
+    const gint64 buffer_time[]  = {100000, 20000};
+    const gint64 latency_time[] = {10000, 5000};
+}
+
+audio_capture::audio_capture(utils::dispatcher::ref dispatcher,
+                             bool low_latency,
+                             slot_frame on_frame):
+    m_dispatcher(dispatcher),
+    m_low_latency(low_latency) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { low_latency });
+
+    m_state = std::make_shared<state>(low_latency
+                                      ? toxmm::av::audio::al(10)
+                                      : toxmm::av::audio::al(20),
+                                      on_frame);
+
+    m_pipeline = Gst::Pipeline::create();
+    //buffer timestamps become g_get_monotonic_time() comparable
+    m_pipeline->use_clock(Gst::SystemClock::obtain());
+    g_signal_connect(m_pipeline->gobj(), "deep-element-added",
+                     G_CALLBACK(&audio_capture::on_element_added), this);
+
+    auto src      = Gst::ElementFactory::create_element("autoaudiosrc");
+    auto convert  = Gst::ElementFactory::create_element("audioconvert");
+    auto resample = Gst::ElementFactory::create_element("audioresample");
+    m_sink        = Gst::AppSink::create();
+
+    m_sink->property_caps() = Gst::Caps::create_from_string(
+                                Glib::ustring::compose("audio/x-raw,format=S16LE,layout=interleaved,"
+                                                       "rate=%1,channels=1",
+                                                       toxmm::audio_framer::rate));
+    m_sink->property_sync() = false;
+    m_sink->property_emit_signals() = true;
+    m_sink->signal_new_sample().connect([this]() {
+        utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+        deliver(m_sink->pull_sample());
+        return Gst::FLOW_OK;
+    });
+
+    m_pipeline->add(src);
+    m_pipeline->add(convert);
+    m_pipeline->add(resample);
+    m_pipeline->add(m_sink);
+    src->link(convert);
+    convert->link(resample);
+    resample->link(m_sink);
+
+    m_bus_watch = m_pipeline->get_bus()->add_watch([](const Glib::RefPtr<Gst::Bus>&,
+                                                      const Glib::RefPtr<Gst::Message>& message) {
+        if (message->get_message_type() == Gst::MESSAGE_ERROR) {
+            auto error = Glib::RefPtr<Gst::MessageError>::cast_static(message);
+            std::cerr << "GSTREAMER-ERROR: " << error->parse().what() << std::endl;
+        }
+        return true;
+    });
+
+    m_pipeline->set_state(Gst::STATE_PLAYING);
+}
+
+audio_capture::~audio_capture() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    m_pipeline->get_bus()->remove_watch(m_bus_watch);
+    //joins the streaming thread, deliver() won't run after this
+    m_pipeline->set_state(Gst::STATE_NULL);
+}
+
+void audio_capture::on_element_added(GstBin*, GstBin*, GstElement* element, gpointer data) {
+    auto self = static_cast<audio_capture*>(data);
+    //autoaudiosrc picks the real source at runtime, size its device buffer
+    auto klass = G_OBJECT_GET_CLASS(element);
+    if (!g_object_class_find_property(klass, "buffer-time") ||
+        !g_object_class_find_property(klass, "latency-time")) {
+        return;
+    }
+    g_object_set(element,
+                 "buffer-time", buffer_time[self->m_low_latency],
+                 "latency-time", latency_time[self->m_low_latency],
+                 nullptr);
+}
+
+void audio_capture::deliver(Glib::RefPtr<Gst::Sample> sample) {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+    if (!sample) {
+        return;
+    }
+    auto buffer = gst_sample_get_buffer(sample->gobj());
+    if (!buffer) {
+        return;
+    }
+
+    gint64 captured = g_get_monotonic_time();
+    if (GST_BUFFER_PTS_IS_VALID(buffer)) {
+        auto base_time = gst_element_get_base_time(GST_ELEMENT(m_pipeline->gobj()));
+        captured = gint64((base_time + GST_BUFFER_PTS(buffer)) / 1000);
+    }
+
+    GstMapInfo map;
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        return;
+    }
+    std::unique_lock<std::mutex> lg(m_state->mutex);
+    m_state->framer.push(reinterpret_cast<const int16_t*>(map.data),
+                         map.size / sizeof(int16_t),
+                         captured);
+    gst_buffer_unmap(buffer, &map);
+
+    if (m_state->scheduled || m_state->framer.ready() == 0) {
+        return;
+    }
+    m_state->scheduled = true;
+    lg.unlock();
+
+    std::weak_ptr<state> weak = m_state;
+    m_dispatcher.emit([weak]() {
+        utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+        auto s = weak.lock();
+        if (!s) {
+            return;
+        }
+        //take everything that is ready, keeps the order and the pacing
+        std::vector<std::pair<toxmm::av::audio, gint64>> frames;
+        {
+            std::lock_guard<std::mutex> lg(s->mutex);
+            frames.reserve(s->framer.ready());
+            toxmm::av::audio frame;
+            gint64 captured;
+            while (s->framer.pop(frame, captured)) {
+                frames.emplace_back(frame, captured);
+            }
+            s->scheduled = false;
+        }
+        for (auto& f : frames) {
+            s->on_frame(f.first, f.second);
+        }
+    });
+}
+
+bool audio_capture::low_latency() const {
+    return m_low_latency;
+}
+
+uint32_t audio_capture::dropped() {
+    std::lock_guard<std::mutex> lg(m_state->mutex);
+    return m_state->framer.dropped();
+}
@@ -0,0 +1,86 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef GTOX_AUDIO_CAPTURE_H
+#define GTOX_AUDIO_CAPTURE_H
+
+#include <glibmm.h>
+#include <gstreamermm/pipeline.h>
+#include <gstreamermm/appsink.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "tox/audio_framer.h"
+#include "dispatcher.h"
+#include "debug.h"
+
+namespace utils {
+    /**
+     * @brief Records the default microphone in toxav sized frames.
+     *
+     * An appsink gets 48 kHz mono from the capture device, the samples are
+     * cut into frames on the streaming thread and handed to the main loop
+     * in order. The capture clock paces the frames, there is no timer.
+     *
+     * Low latency mode sends 10 ms frames and asks the source for a
+     * shorter device buffer, at the cost of more packets and a higher
+     * chance of glitches.
+     */
+    class audio_capture: public debug::track_obj<audio_capture> {
+        public:
+            //! frame and g_get_monotonic_time() of its first sample
+            using slot_frame = std::function<void(const toxmm::av::audio&, gint64)>;
+
+            audio_capture(utils::dispatcher::ref dispatcher,
+                          bool low_latency,
+                          slot_frame on_frame);
+            ~audio_capture();
+
+            audio_capture(const audio_capture&) = delete;
+            void operator=(const audio_capture&) = delete;
+
+            bool low_latency() const;
+            //! frames that got overwritten because the main loop was too slow
+            uint32_t dropped();
+
+        private:
+            struct state {
+                std::mutex mutex;
+                toxmm::audio_framer framer;
+                bool scheduled = false;
+                slot_frame on_frame;
+
+                state(toxmm::av::audio::al length, slot_frame on_frame):
+                    framer(length, toxmm::av::audio::CHANNELS_MONO),
+                    on_frame(on_frame) {}
+            };
+
+            utils::dispatcher::ref m_dispatcher;
+            bool m_low_latency;
+            std::shared_ptr<state> m_state;
+            Glib::RefPtr<Gst::Pipeline> m_pipeline;
+            Glib::RefPtr<Gst::AppSink> m_sink;
+            guint m_bus_watch = 0;
+
+            static void on_element_added(GstBin* bin, GstBin* sub_bin,
+                                         GstElement* element, gpointer data);
+            void deliver(Glib::RefPtr<Gst::Sample> sample);
+    };
+}
+
+#endif
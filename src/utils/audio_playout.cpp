@@ -0,0 +1,116 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "audio_playout.h"
+#include <gstreamermm/bus.h>
+#include <gstreamermm/elementfactory.h>
+#include <gst/app/gstappsrc.h>
+#include <iostream>
+
+#ifndef SIGC_CPP11_HACK
+#define SIGC_CPP11_HACK
+namespace sigc {
+    SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
+}
+#endif
+
+using namespace utils;
+
+namespace {
+    const int chunk_ms = 10;
+
+    void on_need_data(GstAppSrc* src, guint, gpointer data) {
+        auto buffer = static_cast<toxmm::jitter_buffer*>(data);
+        const size_t samples = toxmm::jitter_buffer::rate * chunk_ms / 1000
+                             * toxmm::jitter_buffer::channels;
+        auto gbuffer = gst_buffer_new_allocate(nullptr, samples * sizeof(int16_t), nullptr);
+        GstMapInfo map;
+        if (!gst_buffer_map(gbuffer, &map, GST_MAP_WRITE)) {
+            gst_buffer_unref(gbuffer);
+            return;
+        }
+        buffer->pull(reinterpret_cast<int16_t*>(map.data), samples);
+        gst_buffer_unmap(gbuffer, &map);
+        GST_BUFFER_DURATION(gbuffer) = chunk_ms * GST_MSECOND;
+        gst_app_src_push_buffer(src, gbuffer);
+    }
+}
+
+audio_playout::audio_playout(std::shared_ptr<toxmm::jitter_buffer> buffer):
+    m_buffer(buffer) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+
+    m_pipeline = Gst::Pipeline::create();
+    auto src      = Gst::ElementFactory::create_element("appsrc");
+    auto convert  = Gst::ElementFactory::create_element("audioconvert");
+    auto resample = Gst::ElementFactory::create_element("audioresample");
+    auto sink     = Gst::ElementFactory::create_element("autoaudiosink");
+
+    auto caps = gst_caps_new_simple("audio/x-raw",
+                                    "format", G_TYPE_STRING, "S16LE",
+                                    "layout", G_TYPE_STRING, "interleaved",
+                                    "rate", G_TYPE_INT, toxmm::jitter_buffer::rate,
+                                    "channels", G_TYPE_INT, toxmm::jitter_buffer::channels,
+                                    nullptr);
+    //keep at most two chunks queued in appsrc, the jitter buffer does the buffering
+    guint64 chunk_bytes = toxmm::jitter_buffer::rate * chunk_ms / 1000
+                        * toxmm::jitter_buffer::channels * sizeof(int16_t);
+    g_object_set(src->gobj(),
+                 "caps", caps,
+                 "format", GST_FORMAT_TIME,
+                 "is-live", TRUE,
+                 "do-timestamp", TRUE,
+                 "max-bytes", chunk_bytes * 2,
+                 nullptr);
+    gst_caps_unref(caps);
+
+    //the jitter buffer outlives the pipeline, we stop it in the destructor
+    GstAppSrcCallbacks callbacks = {};
+    callbacks.need_data = &on_need_data;
+    gst_app_src_set_callbacks(GST_APP_SRC(src->gobj()), &callbacks, m_buffer.get(), nullptr);
+
+    m_pipeline->add(src);
+    m_pipeline->add(convert);
+    m_pipeline->add(resample);
+    m_pipeline->add(sink);
+    src->link(convert);
+    convert->link(resample);
+    resample->link(sink);
+
+    m_bus_watch = m_pipeline->get_bus()->add_watch([](const Glib::RefPtr<Gst::Bus>&,
+                                                      const Glib::RefPtr<Gst::Message>& message) {
+        if (message->get_message_type() == Gst::MESSAGE_ERROR) {
+            auto error = Glib::RefPtr<Gst::MessageError>::cast_static(message);
+            std::cerr << "GSTREAMER-ERROR: " << error->parse().what() << std::endl;
+        }
+        return true;
+    });
+
+    m_pipeline->set_state(Gst::STATE_PLAYING);
+}
+
+audio_playout::~audio_playout() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    m_pipeline->get_bus()->remove_watch(m_bus_watch);
+    //joins the streaming thread, no more pulls after this
+    m_pipeline->set_state(Gst::STATE_NULL);
+}
+
+std::shared_ptr<toxmm::jitter_buffer> audio_playout::buffer() const {
+    return m_buffer;
+}
@@ -0,0 +1,52 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef GTOX_AUDIO_PLAYOUT_H
+#define GTOX_AUDIO_PLAYOUT_H
+
+#include <glibmm.h>
+#include <gstreamermm/pipeline.h>
+#include <memory>
+#include "tox/jitter_buffer.h"
+#include "utils/debug.h"
+
+namespace utils {
+    /**
+     * @brief Plays a call's jitter buffer on the default audio device.
+     *
+     * appsrc asks for 10 ms at a time and the audio sink's clock paces
+     * the requests, so no timer is involved.
+     */
+    class audio_playout: public debug::track_obj<audio_playout> {
+        public:
+            audio_playout(std::shared_ptr<toxmm::jitter_buffer> buffer);
+            ~audio_playout();
+
+            audio_playout(const audio_playout&) = delete;
+            void operator=(const audio_playout&) = delete;
+
+            std::shared_ptr<toxmm::jitter_buffer> buffer() const;
+
+        private:
+            std::shared_ptr<toxmm::jitter_buffer> m_buffer;
+            Glib::RefPtr<Gst::Pipeline> m_pipeline;
+            guint m_bus_watch = 0;
+    };
+}
+
+#endif
@@ -18,6 +18,16 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>
 **/
 #include "builder.h"
+#include "debug.h"
+#include <giomm.h>
+#include <map>
+#include <memory>
+#include <vector>
+#include <cstring>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
 
 using namespace utils;
 
@@ -43,3 +53,303 @@ GtkWidget* builder::get_cwidget(const Glib::ustring& name)
 
   return GTK_WIDGET(cobject);
 }
+
+namespace {
+    /**
+     * A ui file parsed once. Plain widget trees (objects, properties,
+     * packing, style classes) are built straight from it, everything
+     * else goes through gtk_builder_add_from_string.
+     */
+    struct blueprint {
+        struct object;
+        using values = std::vector<std::pair<const gchar*, Glib::ValueBase>>;
+        struct child {
+            std::string type;
+            std::shared_ptr<object> obj;
+            values packing;
+        };
+        struct object {
+            GType type;
+            std::string id;
+            values properties;
+            std::vector<std::string> style_classes;
+            std::vector<child> children;
+        };
+
+        Glib::RefPtr<const Glib::Bytes> xml;
+        //empty if the file needs the full GtkBuilder
+        std::vector<std::shared_ptr<object>> objects;
+    };
+
+    class blueprint_parser {
+        private:
+            GtkBuilder* m_builder;
+            blueprint& m_blueprint;
+            std::vector<std::string> m_elements;
+            std::vector<std::shared_ptr<blueprint::object>> m_objects;
+            std::vector<blueprint::child*> m_children;
+            const gchar* m_property = nullptr;
+            bool m_translatable = false;
+            std::string m_context;
+            std::string m_text;
+
+            static const gchar* attribute(const gchar** names, const gchar** values, const char* name) {
+                for (; *names; ++names, ++values) {
+                    if (strcmp(*names, name) == 0) {
+                        return *values;
+                    }
+                }
+                return nullptr;
+            }
+
+            bool parent_is(const char* name) {
+                return m_elements.size() >= 2 && m_elements[m_elements.size() - 2] == name;
+            }
+
+            static void unsupported(GError** error, const std::string& what) {
+                g_set_error(error, G_MARKUP_ERROR, G_MARKUP_ERROR_UNKNOWN_ELEMENT,
+                            "unsupported %s", what.c_str());
+            }
+
+            void start(const gchar* element, const gchar** names, const gchar** values, GError** error) {
+                m_elements.push_back(element);
+                std::string name = element;
+                if (name == "interface" || name == "requires" ||
+                    name == "placeholder" || name == "packing" || name == "style") {
+                    return;
+                }
+                if (name == "object") {
+                    auto cls = attribute(names, values, "class");
+                    auto type = cls ? gtk_builder_get_type_from_name(m_builder, cls) : G_TYPE_INVALID;
+                    if (type == G_TYPE_INVALID ||
+                        attribute(names, values, "constructor") ||
+                        (!parent_is("child") && !parent_is("interface"))) {
+                        return unsupported(error, "object");
+                    }
+                    auto obj = std::make_shared<blueprint::object>();
+                    obj->type = type;
+                    auto id = attribute(names, values, "id");
+                    obj->id = id ? id : "";
+                    if (parent_is("child")) {
+                        m_children.back()->obj = obj;
+                    } else {
+                        m_blueprint.objects.push_back(obj);
+                    }
+                    m_objects.push_back(obj);
+                    return;
+                }
+                if (name == "child" && parent_is("object")) {
+                    if (attribute(names, values, "internal-child")) {
+                        return unsupported(error, "internal-child");
+                    }
+                    auto type = attribute(names, values, "type");
+                    m_objects.back()->children.push_back({ type ? type : "", nullptr, {} });
+                    m_children.push_back(&m_objects.back()->children.back());
+                    return;
+                }
+                if (name == "property" && (parent_is("object") || parent_is("packing"))) {
+                    auto prop = attribute(names, values, "name");
+                    auto translatable = attribute(names, values, "translatable");
+                    auto context = attribute(names, values, "context");
+                    if (!prop || attribute(names, values, "bind-source")) {
+                        return unsupported(error, "property");
+                    }
+                    m_property = g_intern_string(prop);
+                    m_translatable = translatable && (strcmp(translatable, "yes") == 0 ||
+                                                      strcmp(translatable, "True") == 0);
+                    m_context = context ? context : "";
+                    m_text.clear();
+                    return;
+                }
+                if (name == "class" && parent_is("style")) {
+                    auto cls = attribute(names, values, "name");
+                    if (cls) {
+                        m_objects.back()->style_classes.push_back(cls);
+                    }
+                    return;
+                }
+                unsupported(error, name);
+            }
+
+            void end(const gchar* element, GError** error) {
+                std::string name = element;
+                if (name == "object") {
+                    m_objects.pop_back();
+                } else if (name == "child") {
+                    //placeholders leave empty children behind
+                    if (!m_children.back()->obj) {
+                        m_objects.back()->children.pop_back();
+                    }
+                    m_children.pop_back();
+                } else if (name == "property" && m_property) {
+                    property(error);
+                }
+                m_elements.pop_back();
+            }
+
+            void property(GError** error) {
+                auto obj = m_objects.back();
+                auto packing = parent_is("packing");
+                auto klass = G_OBJECT_CLASS(g_type_class_ref(obj->type));
+                auto pspec = packing
+                             ? (GTK_IS_CONTAINER_CLASS(klass)
+                                ? gtk_container_class_find_child_property(klass, m_property)
+                                : nullptr)
+                             : g_object_class_find_property(klass, m_property);
+                g_type_class_unref(klass);
+                if (!pspec) {
+                    return unsupported(error, std::string("property ") + m_property);
+                }
+                const gchar* text = m_text.c_str();
+                if (m_translatable) {
+                    text = m_context.empty() ? g_dgettext(nullptr, text)
+                                             : g_dpgettext2(nullptr, m_context.c_str(), text);
+                }
+                GValue value = G_VALUE_INIT;
+                if (!gtk_builder_value_from_string(m_builder, pspec, text, &value, error)) {
+                    return;
+                }
+                Glib::ValueBase copy;
+                copy.init(&value);
+                g_value_unset(&value);
+                if (packing) {
+                    m_children.back()->packing.emplace_back(pspec->name, copy);
+                } else {
+                    obj->properties.emplace_back(pspec->name, copy);
+                }
+                m_property = nullptr;
+            }
+
+        public:
+            blueprint_parser(GtkBuilder* builder, blueprint& blueprint)
+                : m_builder(builder), m_blueprint(blueprint) {}
+
+            bool parse(const gchar* data, gsize size) {
+                static const GMarkupParser parser = {
+                    [](GMarkupParseContext*, const gchar* element,
+                       const gchar** names, const gchar** values,
+                       gpointer self, GError** error) {
+                        static_cast<blueprint_parser*>(self)->start(element, names, values, error);
+                    },
+                    [](GMarkupParseContext*, const gchar* element,
+                       gpointer self, GError** error) {
+                        static_cast<blueprint_parser*>(self)->end(element, error);
+                    },
+                    [](GMarkupParseContext*, const gchar* text, gsize size,
+                       gpointer self, GError**) {
+                        auto parser = static_cast<blueprint_parser*>(self);
+                        if (parser->m_property) {
+                            parser->m_text.append(text, size);
+                        }
+                    },
+                    nullptr,
+                    nullptr
+                };
+                auto context = g_markup_parse_context_new(&parser, GMarkupParseFlags(0), this, nullptr);
+                bool ok = g_markup_parse_context_parse(context, data, size, nullptr) &&
+                          g_markup_parse_context_end_parse(context, nullptr);
+                g_markup_parse_context_free(context);
+                return ok;
+            }
+    };
+
+    GObject* build(GtkBuilder* builder, const blueprint::object& blueprint) {
+        std::vector<GParameter> params;
+        for (auto& prop : blueprint.properties) {
+            params.push_back({ prop.first, *prop.second.gobj() });
+        }
+        auto obj = G_OBJECT(g_object_newv(blueprint.type, params.size(), params.data()));
+        //own one full reference, like GtkBuilder does
+        if (G_IS_INITIALLY_UNOWNED(obj)) {
+            g_object_ref_sink(obj);
+        }
+        if (!blueprint.style_classes.empty()) {
+            auto style = gtk_widget_get_style_context(GTK_WIDGET(obj));
+            for (auto& cls : blueprint.style_classes) {
+                gtk_style_context_add_class(style, cls.c_str());
+            }
+        }
+        for (auto& child : blueprint.children) {
+            auto child_obj = build(builder, *child.obj);
+            gtk_buildable_add_child(GTK_BUILDABLE(obj), builder, child_obj,
+                                    child.type.empty() ? nullptr : child.type.c_str());
+            for (auto& prop : child.packing) {
+                gtk_container_child_set_property(GTK_CONTAINER(obj), GTK_WIDGET(child_obj),
+                                                 prop.first, prop.second.gobj());
+            }
+            g_object_unref(child_obj);
+        }
+        if (!blueprint.id.empty()) {
+            gtk_builder_expose_object(builder, blueprint.id.c_str(), obj);
+        }
+        return obj;
+    }
+}
+
+void builder::add_from_blueprint(const Glib::RefPtr<Gtk::Builder>& builder,
+                                 const Glib::ustring& resource) {
+    //ui resources are stored compressed, only inflate and parse them once
+    static std::map<Glib::ustring, blueprint> blueprints;
+    auto iter = blueprints.find(resource);
+    if (iter == blueprints.end()) {
+        blueprint bp;
+        bp.xml = Gio::Resource::lookup_data_global(resource);
+        gsize size;
+        auto data = (const gchar*)bp.xml->get_data(size);
+        if (!blueprint_parser(builder->gobj(), bp).parse(data, size)) {
+            //signals, menus, object references and the like
+            bp.objects.clear();
+        }
+        iter = blueprints.emplace(resource, std::move(bp)).first;
+    }
+
+    auto& bp = iter->second;
+    if (!bp.objects.empty()) {
+        for (auto& obj : bp.objects) {
+            g_object_unref(build(builder->gobj(), *obj));
+        }
+        return;
+    }
+
+    gsize size;
+    auto data = (const gchar*)bp.xml->get_data(size);
+    GError* error = nullptr;
+    if (!gtk_builder_add_from_string(builder->gobj(), data, size, &error)) {
+        std::string message = error->message;
+        g_error_free(error);
+        throw std::runtime_error("gToxBuilder - " + message);
+    }
+}
+
+void builder::benchmark() {
+    static auto env_instances = std::stoi("0" + Glib::getenv("GTOX_DBG_BUILDER_BENCH"));
+    if (env_instances <= 0) {
+        return;
+    }
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { env_instances });
+
+    auto time = [&](std::function<void()> func) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < env_instances; ++i) {
+            func();
+        }
+        std::chrono::duration<double, std::micro> took = std::chrono::steady_clock::now() - start;
+        return took.count() / env_instances;
+    };
+
+    for (auto resource : { "/org/gtox/ui/chat_bubble_left.ui",
+                           "/org/gtox/ui/list_item_contact.ui",
+                           "/org/gtox/ui/chat_filerecv.ui" }) {
+        auto time_resource = time([&]() {
+            Gtk::Builder::create_from_resource(resource);
+        });
+        auto time_blueprint = time([&]() {
+            add_from_blueprint(Gtk::Builder::create(), resource);
+        });
+        std::clog << std::fixed << std::setprecision(2)
+                  << "BUILDER-BENCH: " << resource
+                  << " resource " << time_resource << " us"
+                  << " blueprint " << time_blueprint << " us"
+                  << std::endl;
+    }
+}
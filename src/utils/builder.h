@@ -124,12 +124,30 @@ namespace utils {
             ref<T_Widget> create_ref(const Glib::ustring resource,
                               const Glib::ustring& name,
                               T&& ... params) {
-                auto ori_builder = Gtk::Builder::create_from_resource(resource);
+                auto ori_builder = Gtk::Builder::create();
+                add_from_blueprint(ori_builder, resource);
                 auto builder = utils::builder(ori_builder);
                 return { builder, builder
                         .get_widget_derived<T_Widget>(name, params ...) };
             }
 
+            /**
+             * @brief Same as Gtk::Builder::add_from_resource, but each
+             * resource is inflated and parsed once. Plain widget trees
+             * are built from the parsed blueprint, files with signals,
+             * menus or object references are fed to GtkBuilder again.
+             */
+            static void add_from_blueprint(const Glib::RefPtr<Gtk::Builder>& builder,
+                                           const Glib::ustring& resource);
+
+            /**
+             * @brief Debug aid, prints the time to build the row widgets
+             * from the resource and from the kept blueprint.
+             *
+             * Enabled by GTOX_DBG_BUILDER_BENCH=<instances>
+             */
+            static void benchmark();
+
         protected:
             GtkWidget* get_cwidget(const Glib::ustring& name);
     };
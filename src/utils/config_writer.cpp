@@ -0,0 +1,147 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "config_writer.h"
+#include "worker_pool.h"
+#include "debug.h"
+#include <giomm.h>
+#include <iostream>
+
+using namespace utils;
+
+namespace {
+    //one thread keeps the writes in order
+    utils::worker_pool& write_pool() {
+        static utils::worker_pool pool(1);
+        return pool;
+    }
+}
+
+config_writer::config_writer(const std::string& path,
+                             slot_serialize serialize,
+                             unsigned delay_ms):
+    m_file(std::make_shared<file>()),
+    m_serialize(serialize),
+    m_delay_ms(delay_ms) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { path });
+    m_file->path = path;
+}
+
+config_writer::~config_writer() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    m_timeout.disconnect();
+    //a queued write might never run, the pool can be destroyed first
+    bool queued;
+    {
+        std::lock_guard<std::mutex> lg(m_file->mutex);
+        queued = m_file->written < m_version;
+    }
+    if (m_dirty || queued) {
+        flush(true);
+    }
+}
+
+void config_writer::changed() {
+    utils::debug::scope_log log(DBG_LVL_3("gtox"), {});
+    m_dirty = true;
+    if (m_batches == 0) {
+        schedule();
+    }
+}
+
+void config_writer::schedule() {
+    utils::debug::scope_log log(DBG_LVL_3("gtox"), {});
+    //restart the delay with every change
+    m_timeout.disconnect();
+    m_timeout = Glib::signal_timeout().connect([this]() {
+        flush(false);
+        return false;
+    }, m_delay_ms, Glib::PRIORITY_LOW);
+}
+
+void config_writer::flush(bool wait) {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), { wait });
+    m_dirty = false;
+    auto version = ++m_version;
+    auto content = m_serialize();
+    if (wait) {
+        write(m_file, version, content);
+        return;
+    }
+    auto f = m_file;
+    write_pool().push([f, version, content]() {
+        write(f, version, content);
+    });
+}
+
+void config_writer::write(const std::shared_ptr<file>& f,
+                          uint64_t version,
+                          const std::vector<uint8_t>& content) {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), { f->path, int(content.size()) });
+    std::lock_guard<std::mutex> lg(f->mutex);
+    //a newer version got written already
+    if (version <= f->written) {
+        return;
+    }
+    f->written = version;
+
+    if (!f->known) {
+        f->known = true;
+        try {
+            auto old = Glib::file_get_contents(f->path);
+            f->content.assign(old.begin(), old.end());
+        } catch (Glib::FileError&) {
+            //not there yet
+        }
+    }
+    if (f->content == content) {
+        return;
+    }
+
+    try {
+        auto file = Gio::File::create_for_path(f->path);
+        auto parent = file->get_parent();
+        if (parent) {
+            if (!Glib::file_test(parent->get_path(), Glib::FILE_TEST_IS_DIR)) {
+                parent->make_directory_with_parents();
+            }
+        }
+        auto stream = file->replace();
+        stream->truncate(0);
+        stream->write_bytes(Glib::Bytes::create(content.data(), content.size()));
+        stream->close();
+        f->content = content;
+    } catch (Glib::Error& e) {
+        //might be the background thread, nobody to throw to
+        std::cerr << "CONFIG-ERROR: " << f->path << " " << e.what() << std::endl;
+    }
+}
+
+config_writer::batch::batch(config_writer& writer): m_writer(&writer) {
+    ++m_writer->m_batches;
+}
+
+config_writer::batch::batch(batch&& o): m_writer(o.m_writer) {
+    o.m_writer = nullptr;
+}
+
+config_writer::batch::~batch() {
+    if (m_writer && --m_writer->m_batches == 0 && m_writer->m_dirty) {
+        m_writer->schedule();
+    }
+}
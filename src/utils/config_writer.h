@@ -0,0 +1,91 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef GTOX_CONFIG_WRITER_H
+#define GTOX_CONFIG_WRITER_H
+
+#include <glibmm.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <mutex>
+
+namespace utils {
+    /**
+     * @brief Writes a config file once changes settle down.
+     *
+     * Changes within the delay, or while a batch is open, are serialized
+     * once. The file gets written on a background thread, and only if
+     * the bytes differ from what is on disk.
+     */
+    class config_writer {
+        public:
+            using slot_serialize = std::function<std::vector<uint8_t>()>;
+
+            //! serialize is called on the main loop
+            config_writer(const std::string& path,
+                          slot_serialize serialize,
+                          unsigned delay_ms = 500);
+            //! writes what's pending before returning
+            ~config_writer();
+            config_writer(const config_writer&) = delete;
+            void operator=(const config_writer&) = delete;
+
+            //! something changed, write after the delay
+            void changed();
+
+            //! holds back the write until the last batch is gone
+            class batch {
+                public:
+                    batch(config_writer& writer);
+                    batch(batch&& o);
+                    ~batch();
+                    batch(const batch&) = delete;
+                    void operator=(const batch&) = delete;
+                private:
+                    config_writer* m_writer;
+            };
+
+        private:
+            //shared with the write jobs
+            struct file {
+                std::string path;
+                std::mutex mutex;
+                bool known = false;
+                std::vector<uint8_t> content;
+                uint64_t written = 0;
+            };
+
+            std::shared_ptr<file> m_file;
+            slot_serialize m_serialize;
+            unsigned m_delay_ms;
+
+            sigc::connection m_timeout;
+            bool m_dirty = false;
+            int m_batches = 0;
+            uint64_t m_version = 0;
+
+            void schedule();
+            void flush(bool wait);
+            static void write(const std::shared_ptr<file>& f,
+                              uint64_t version,
+                              const std::vector<uint8_t>& content);
+    };
+}
+
+#endif
@@ -0,0 +1,128 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "dispatcher.h"
+#include "debug.h"
+#include <unordered_map>
+#include <iostream>
+
+using namespace utils;
+
+std::atomic<uint64_t> dispatch_queue::key::s_next{0};
+
+dispatch_queue& dispatch_queue::instance() {
+    //never destroyed, threads may still push while we exit
+    static dispatch_queue* queue = []() {
+        auto q = new dispatch_queue();
+        q->print_stats_every(std::stoi("0" + Glib::getenv("GTOX_DBG_DISPATCH_STATS")));
+        return q;
+    }();
+    return *queue;
+}
+
+void dispatch_queue::push(std::function<void()> func, uint64_t key) {
+    auto n = new node{std::move(func), key, m_head.load(std::memory_order_relaxed)};
+    while (!m_head.compare_exchange_weak(n->next, n,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+    }
+
+    auto depth = ++m_depth;
+    auto max_depth = m_max_depth.load(std::memory_order_relaxed);
+    while (depth > max_depth &&
+           !m_max_depth.compare_exchange_weak(max_depth, depth)) {
+    }
+
+    //the first push since the last drain schedules the next one
+    if (!m_scheduled.exchange(true)) {
+        ++m_wakeups;
+        Glib::signal_idle().connect([this]() {
+            drain();
+            return false;
+        });
+    }
+}
+
+void dispatch_queue::drain() {
+    //clear first, so a push racing with us schedules another round
+    m_scheduled = false;
+    node* list = m_head.exchange(nullptr, std::memory_order_acquire);
+
+    //the list is newest first, turn it around
+    node* fifo = nullptr;
+    size_t count = 0;
+    bool keyed = false;
+    while (list) {
+        auto next = list->next;
+        list->next = fifo;
+        fifo = list;
+        list = next;
+        ++count;
+        keyed |= fifo->key != 0;
+    }
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), { int(count) });
+
+    std::unordered_map<uint64_t, node*> latest;
+    if (keyed) {
+        for (auto n = fifo; n; n = n->next) {
+            if (n->key) {
+                latest[n->key] = n;
+            }
+        }
+    }
+
+    //what gets pushed while running waits for the next round
+    while (fifo) {
+        std::unique_ptr<node> n(fifo);
+        fifo = fifo->next;
+        --m_depth;
+        if (n->key && latest[n->key] != n.get()) {
+            ++m_coalesced;
+            continue;
+        }
+        ++m_dispatched;
+        n->func();
+    }
+}
+
+dispatch_queue::stats dispatch_queue::get_stats() const {
+    return {
+        m_depth.load(),
+        m_max_depth.load(),
+        m_wakeups.load(),
+        m_dispatched.load(),
+        m_coalesced.load()
+    };
+}
+
+void dispatch_queue::print_stats_every(unsigned seconds) {
+    if (seconds == 0) {
+        return;
+    }
+    Glib::signal_timeout().connect_seconds([this]() {
+        auto s = get_stats();
+        std::clog << "DISPATCH-STATS:"
+                  << " depth " << s.depth
+                  << " max " << s.max_depth
+                  << " wakeups " << s.wakeups
+                  << " dispatched " << s.dispatched
+                  << " coalesced " << s.coalesced
+                  << std::endl;
+        return true;
+    }, seconds);
+}
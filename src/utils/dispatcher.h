@@ -1,6 +1,8 @@
 #ifndef DISPATCHER_H
 #define DISPATCHER_H
 #include <memory>
+#include <atomic>
+#include <functional>
 #include <glibmm.h>
 
 #ifndef SIGC_CPP11_HACK
@@ -11,6 +13,78 @@ namespace sigc {
 #endif
 
 namespace utils {
+    /**
+     * @brief Closures waiting for the gtk main loop.
+     *
+     * Any thread pushes onto a lock-free list, one idle source runs
+     * everything that piled up since the last one.
+     */
+    class dispatch_queue {
+        public:
+            struct stats {
+                //! waiting right now, and the most ever
+                size_t depth;
+                size_t max_depth;
+                //! idle sources it took to run them
+                uint64_t wakeups;
+                uint64_t dispatched;
+                //! dropped for a newer closure with the same key
+                uint64_t coalesced;
+            };
+
+            /**
+             * @brief Marks closures that replace each other.
+             *
+             * Owned by the caller, copies mark the same closures. Unlike
+             * addresses the ids are never reused.
+             */
+            class key {
+                public:
+                    key(): m_id(++s_next) {}
+                    uint64_t id() const {
+                        return m_id;
+                    }
+                private:
+                    uint64_t m_id;
+                    static std::atomic<uint64_t> s_next;
+            };
+
+            static dispatch_queue& instance();
+
+            /**
+             * @brief can be called from any thread
+             * @param key if not 0, only the newest closure with this
+             * key id runs per wakeup
+             */
+            void push(std::function<void()> func, uint64_t key = 0);
+
+            stats get_stats() const;
+
+        private:
+            struct node {
+                std::function<void()> func;
+                uint64_t key;
+                node* next;
+            };
+
+            std::atomic<node*> m_head{nullptr};
+            std::atomic<bool> m_scheduled{false};
+
+            std::atomic<size_t> m_depth{0};
+            std::atomic<size_t> m_max_depth{0};
+            std::atomic<uint64_t> m_wakeups{0};
+            std::atomic<uint64_t> m_dispatched{0};
+            std::atomic<uint64_t> m_coalesced{0};
+
+            dispatch_queue() {}
+            dispatch_queue(const dispatch_queue&) = delete;
+            void operator=(const dispatch_queue&) = delete;
+
+            void drain();
+            //! GTOX_DBG_DISPATCH_STATS=<seconds> prints the stats that often
+            void print_stats_every(unsigned seconds);
+    };
+
     /**
      * @brief The Dispatcher, executes given function on gtk main loop.
      *
@@ -28,15 +102,22 @@ namespace utils {
                     std::weak_ptr<bool> m_exists;
                 public:
                     ref(const dispatcher& o): m_exists(o.m_exists) {}
-                    template<typename T> sigc::connection emit(T f) const {
+                    template<typename T> void emit(T f) const {
+                        push(0, f);
+                    }
+                    //! latest wins, see dispatch_queue::push()
+                    template<typename T> void emit(const dispatch_queue::key& key, T f) const {
+                        push(key.id(), f);
+                    }
+                private:
+                    template<typename T> void push(uint64_t key, T f) const {
                         std::weak_ptr<bool> weak = m_exists;
-                        return Glib::signal_idle().connect([f, weak]() {
+                        dispatch_queue::instance().push([f, weak]() {
                             auto strong = weak.lock();
                             if (strong) {
                                 f();
                             }
-                            return false;
-                        });
+                        }, key);
                     }
             };
 
@@ -44,20 +125,28 @@ namespace utils {
         private:
             std::shared_ptr<bool> m_exists = std::make_shared<bool>(true);
         public:
-            template<typename T> sigc::connection emit(T f) const {
+            template<typename T> void emit(T f) const {
+                push(0, f);
+            }
+            //! latest wins, see dispatch_queue::push()
+            template<typename T> void emit(const dispatch_queue::key& key, T f) const {
+                push(key.id(), f);
+            }
+            dispatcher() {}
+            dispatcher(const dispatcher&) = delete;
+            void operator=(const dispatcher&) = delete;
+
+        private:
+            template<typename T> void push(uint64_t key, T f) const {
                 std::weak_ptr<bool> weak = m_exists;
-                return Glib::signal_idle().connect([f, weak]() {
+                dispatch_queue::instance().push([f, weak]() {
                     auto strong = weak.lock();
                     //make sure our dispatcher still exists !
                     if (strong) {
                         f();
                     }
-                    return false;
-                });
+                }, key);
             }
-            dispatcher() {}
-            dispatcher(const dispatcher&) = delete;
-            void operator=(const dispatcher&) = delete;
     };
 }
 #endif
@@ -17,6 +17,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>
 **/
 #include "gstreamer.h"
+#include "video_frame.h"
 #include <gstreamermm/bus.h>
 #include <glibmm/i18n.h>
 #include <gstreamermm/uridecodebin.h>
@@ -65,10 +66,21 @@ void gstreamer::init() {
     m_appsink->property_drop() = true;
     m_appsink->property_emit_signals() = true;
 
-    utils::dispatcher::ref weak_dispatcher = m_dispatcher;
     auto resolution = std::make_shared<std::pair<int, int>>();
+    auto handoff = std::make_shared<frame_handoff>(m_dispatcher, [this](Glib::RefPtr<Gdk::Pixbuf> frame) {
+        utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+        gint64 pos, dur;
+        if (m_playbin
+            && m_playbin->query_position(Gst::FORMAT_TIME, pos)
+            && m_playbin->query_duration(Gst::FORMAT_TIME, dur)) {
+            //set
+            m_property_duration.set_value(dur);
+            m_property_position.set_value(pos);
+        }
+        m_property_pixbuf.set_value(frame);
+    });
 
-    m_appsink->signal_new_preroll().connect(sigc::track_obj([this, sink = m_appsink, weak_dispatcher, resolution, prev_dispatched = sigc::connection()]() mutable {
+    m_appsink->signal_new_preroll().connect(sigc::track_obj([sink = m_appsink, handoff, resolution]() {
         utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
         auto preroll = sink->pull_preroll();
         if (!preroll) {
@@ -95,39 +107,19 @@ void gstreamer::init() {
         resolution->second = h;
 
         auto frame = extract_frame(preroll, resolution);
-        prev_dispatched.disconnect();
-        prev_dispatched = weak_dispatcher.emit([this, frame]() {
-            utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-            gint64 pos, dur;
-            if (m_playbin
-                && m_playbin->query_position(Gst::FORMAT_TIME, pos)
-                && m_playbin->query_duration(Gst::FORMAT_TIME, dur)) {
-                //set
-                m_property_duration.set_value(dur);
-                m_property_position.set_value(pos);
-            }
-            m_property_pixbuf.set_value(frame);
-        });
+        if (frame) {
+            handoff->push(frame);
+        }
         return Gst::FLOW_OK;
 
     }, *this));
-    m_appsink->signal_new_sample().connect(sigc::track_obj([this, sink = m_appsink, weak_dispatcher, resolution, prev_dispatched = sigc::connection()]() mutable {
+    m_appsink->signal_new_sample().connect(sigc::track_obj([sink = m_appsink, handoff, resolution]() {
         utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
         auto sample = sink->pull_sample();
         auto frame = extract_frame(sample, resolution);
-        prev_dispatched.disconnect();
-        prev_dispatched = weak_dispatcher.emit([this, frame]() {
-            utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-            gint64 pos, dur;
-            if (m_playbin
-                && m_playbin->query_position(Gst::FORMAT_TIME, pos)
-                && m_playbin->query_duration(Gst::FORMAT_TIME, dur)) {
-                //set
-                m_property_duration.set_value(dur);
-                m_property_position.set_value(pos);
-            }
-            m_property_pixbuf.set_value(frame);
-        });
+        if (frame) {
+            handoff->push(frame);
+        }
         return Gst::FLOW_OK;
     }, *this));
 
@@ -325,54 +317,8 @@ Glib::RefPtr<Gdk::Pixbuf> gstreamer::get_video_preview(Glib::ustring uri) {
 Glib::RefPtr<Gdk::Pixbuf> gstreamer::extract_frame(Glib::RefPtr<Gst::Sample> sample,
                                                    std::shared_ptr<std::pair<int, int>> resolution) {
     utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-    static auto null = Glib::RefPtr<Gdk::Pixbuf>();
     if (!sample) {
-        return null;
-    }
-    /*
-    Generates crashes, not idea why
-    using "resolution" now..
-    gets filled by preroll
-
-    auto caps = sample->get_caps();
-    if (!caps) {
-        return null;
-    }
-    if (caps->empty()) {
-        return null;
-    }
-    if (caps->empty()) {
-        return null;
-    }
-    auto struc = caps->get_structure(0);
-    int w,h;
-    if (!struc.get_field("width", w)) {
-        return null;
-    }
-    if (!struc.get_field("height", h)) {
-        return null;
-    }
-    */
-    auto buffer = sample->get_buffer();
-    if (!buffer) {
-        return null;
-    }
-    auto map = Glib::RefPtr<Gst::MapInfo>(new Gst::MapInfo);
-    if (!buffer->map(map, Gst::MAP_READ)) {
-        return null;
+        return Glib::RefPtr<Gdk::Pixbuf>();
     }
-    auto mem = new uint8_t[map->get_size()];
-    std::copy(map->get_data(), map->get_data() + map->get_size(), mem);
-    buffer->unmap(map);
-
-    return Gdk::Pixbuf::create_from_data(mem,
-                                               Gdk::COLORSPACE_RGB,
-                                               false,
-                                               8,
-                                               resolution->first,
-                                               resolution->second,
-                                               GST_ROUND_UP_4( resolution->first*3 ),
-                                               [](const guint8* data) {
-        delete[] data;
-    });
+    return video_frame::wrap(sample->gobj(), resolution->first, resolution->second);
 }
@@ -0,0 +1,104 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "log_benchmark.h"
+#include "tox/log_segment.h"
+#include <glibmm.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace utils;
+
+void log_benchmark::run() {
+    static auto env_items = std::stoi("0" + Glib::getenv("GTOX_DBG_LOG_BENCH"));
+    if (env_items <= 0) {
+        return;
+    }
+
+    const std::string addrs[] = {
+        "8E7D0B859922EF569298B4D261A8CCB5FEA14FB91ED412A7603A585A25698832",
+        "76518406F6A9F2217E8DC487CC783C25CC16A15EB36FF32E335A235342C48A39",
+    };
+    const std::vector<std::string> messages {
+        "ok",
+        "see you tomorrow :)",
+        "did you read <https://github.com/KoKuToru/gTox.git> & the issues?",
+        "that is really important, read it",
+        "fine, Grüße aus München",
+        "long message in the middle of a line that is going to wrap at least"
+        " once or twice when the chat window isn't very wide",
+    };
+
+    //the same day as plain collection and as segment
+    flatbuffers::FlatBufferBuilder fbb;
+    std::vector<flatbuffers::Offset<flatbuffers::Log::Item>> items;
+    for (int i = 0; i < env_items; ++i) {
+        auto sender = fbb.CreateString(addrs[(i / 3) % 2]);
+        auto message = fbb.CreateString(messages[i % messages.size()]);
+        auto data = flatbuffers::Log::CreateMessage(fbb, message).Union();
+        items.push_back(flatbuffers::Log::CreateItem(fbb,
+                                                     sender,
+                                                     1450000000 + i * 60,
+                                                     flatbuffers::Log::Data::Message,
+                                                     data));
+    }
+    flatbuffers::Log::FinishCollectionBuffer(
+                fbb,
+                flatbuffers::Log::CreateCollection(fbb, fbb.CreateVector(items)));
+    std::vector<uint8_t> plain(fbb.GetBufferPointer(),
+                               fbb.GetBufferPointer() + fbb.GetSize());
+
+    //converted on the first append
+    toxmm::log_segment segment;
+    segment.parse(plain);
+    auto start = std::chrono::steady_clock::now();
+    segment.append(segment.item(0));
+    std::chrono::duration<double, std::micro> convert = std::chrono::steady_clock::now() - start;
+    auto packed = segment.serialize();
+
+    //what chat::load_log does with a day, reading the newest lines or all
+    auto load = [&](const std::vector<uint8_t>& content, size_t lines) {
+        constexpr int runs = 100;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < runs; ++r) {
+            toxmm::log_segment s;
+            s.parse(content);
+            auto size = s.size();
+            for (auto i = size - std::min(size, lines); i < size; ++i) {
+                s.address(s.item(i)->sender());
+            }
+        }
+        std::chrono::duration<double, std::micro> took = std::chrono::steady_clock::now() - start;
+        return took.count() / runs;
+    };
+
+    std::clog << std::fixed << std::setprecision(2)
+              << "LOG-BENCH: " << env_items << " items"
+              << " plain " << plain.size() << " bytes"
+              << " segment " << packed.size() << " bytes"
+              << " (" << 100.0 * packed.size() / plain.size() << "%)"
+              << " convert " << convert.count() << " us" << std::endl
+              << "LOG-BENCH: newest 100 plain " << load(plain, 100) << " us"
+              << " segment " << load(packed, 100) << " us" << std::endl
+              << "LOG-BENCH: all plain " << load(plain, env_items) << " us"
+              << " segment " << load(packed, env_items) << " us" << std::endl;
+}
@@ -0,0 +1,38 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef GTOX_LOG_BENCHMARK_H
+#define GTOX_LOG_BENCHMARK_H
+
+namespace utils {
+    /**
+     * @brief Debug aid, compares a day of chat history stored as plain
+     * flatbuffers::Log::Collection with the same day as toxmm::log_segment.
+     *
+     * Prints the sizes, the conversion time and how long loading the
+     * newest 100 or all items of the day takes.
+     *
+     * Enabled by GTOX_DBG_LOG_BENCH=<items per day>.
+     */
+    class log_benchmark {
+        public:
+            static void run();
+    };
+}
+
+#endif
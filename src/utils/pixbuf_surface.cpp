@@ -0,0 +1,67 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "pixbuf_surface.h"
+#include "debug.h"
+
+using namespace utils;
+
+Cairo::RefPtr<Cairo::ImageSurface> pixbuf_surface::get(const Glib::RefPtr<Gdk::Pixbuf>& pix) {
+    if (pix == m_pixbuf && m_surface) {
+        return m_surface;
+    }
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+    m_pixbuf = pix;
+
+    int w = pix->get_width();
+    int h = pix->get_height();
+    if (!m_surface || m_surface->get_width() != w || m_surface->get_height() != h) {
+        m_surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, w, h);
+    }
+
+    //same as gdk_cairo_set_source_pixbuf does, alpha gets premultiplied
+    m_surface->flush();
+    auto channels = pix->get_n_channels();
+    auto src_stride = pix->get_rowstride();
+    auto dst_stride = m_surface->get_stride();
+    const guint8* src = pix->get_pixels();
+    unsigned char* dst = m_surface->get_data();
+    for (int y = 0; y < h; ++y) {
+        auto s = src + y * src_stride;
+        auto d = reinterpret_cast<uint32_t*>(dst + y * dst_stride);
+        for (int x = 0; x < w; ++x, s += channels) {
+            uint32_t a = channels == 4 ? s[3] : 0xFF;
+            uint32_t r = s[0];
+            uint32_t g = s[1];
+            uint32_t b = s[2];
+            if (a != 0xFF) {
+                //rounded (c * a) / 255
+                auto mul = [a](uint32_t c) {
+                    auto t = c * a + 0x80;
+                    return ((t >> 8) + t) >> 8;
+                };
+                r = mul(r);
+                g = mul(g);
+                b = mul(b);
+            }
+            d[x] = (a << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+    m_surface->mark_dirty();
+    return m_surface;
+}
@@ -0,0 +1,43 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef H_GTOX_PIXBUF_SURFACE
+#define H_GTOX_PIXBUF_SURFACE
+
+#include <gtkmm.h>
+
+namespace utils {
+    /**
+     * @brief Keeps the pixels of a pixbuf in a cairo surface.
+     *
+     * Gdk::Cairo::set_source_pixbuf converts into a new surface on each
+     * call. This converts into the same surface as long as the pixbuf
+     * size stays the same, so video frames don't allocate.
+     */
+    class pixbuf_surface {
+        public:
+            //! valid until the next call, converts only when pix changed
+            Cairo::RefPtr<Cairo::ImageSurface> get(const Glib::RefPtr<Gdk::Pixbuf>& pix);
+
+        private:
+            Cairo::RefPtr<Cairo::ImageSurface> m_surface;
+            Glib::RefPtr<Gdk::Pixbuf> m_pixbuf;
+    };
+}
+
+#endif
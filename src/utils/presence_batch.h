@@ -0,0 +1,164 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef GTOX_PRESENCE_BATCH_H
+#define GTOX_PRESENCE_BATCH_H
+
+#include <gtkmm.h>
+#include <functional>
+#include <set>
+#include <vector>
+
+namespace utils {
+    /**
+     * @brief Collects contact row updates during one main-loop tick and
+     * applies them before gtk does resize and redraw.
+     *
+     * Items whose sort key changed are moved one by one, O(log n)
+     * compares each, instead of re-sorting the stores.
+     *
+     * T needs update_presence(), sort_key(), update_sort_key() and
+     * compare(), see dialog::contact_item.
+     */
+    template<typename T>
+    class presence_batch {
+        public:
+            using store = Glib::RefPtr<Gio::ListStore<T>>;
+            //! called after every flush, true if an item was moved
+            using slot_flushed = std::function<void(bool)>;
+
+            presence_batch(std::vector<store> stores, slot_flushed on_flushed = nullptr):
+                m_stores(stores),
+                m_on_flushed(on_flushed) {}
+            ~presence_batch() {
+                m_idle.disconnect();
+            }
+
+            /**
+             * @brief updates the item with the next batch
+             * @param reorder the sort key changed, move the item to its
+             * new position
+             */
+            void queue(T* item, bool reorder = false) {
+                m_items.insert(item);
+                if (reorder) {
+                    m_reorder.insert(item);
+                }
+                schedule();
+            }
+
+            void cancel(T* item) {
+                m_items.erase(item);
+                m_reorder.erase(item);
+            }
+
+            //! flushes with the next tick, even without queued items
+            void schedule() {
+                if (m_idle.connected()) {
+                    return;
+                }
+                m_idle = Glib::signal_idle().connect([this]() {
+                    flush();
+                    return false;
+                }, Glib::PRIORITY_HIGH_IDLE);
+            }
+
+            bool pending() const {
+                return m_idle.connected();
+            }
+
+            void flush() {
+                m_idle.disconnect();
+                auto items = std::move(m_items);
+                auto reorder = std::move(m_reorder);
+                m_items.clear();
+                m_reorder.clear();
+
+                for (auto item : items) {
+                    item->update_presence();
+                }
+                bool moved = false;
+                for (auto item : reorder) {
+                    moved |= move(item);
+                }
+                if (m_on_flushed) {
+                    m_on_flushed(moved);
+                }
+            }
+
+            //! binary search by the key the item was inserted with
+            static guint find(const store& store, T* item) {
+                guint n = store->get_n_items();
+                guint lo = 0;
+                guint hi = n;
+                while (lo < hi) {
+                    guint mid = lo + (hi - lo) / 2;
+                    if (store->get_item(mid)->sort_key() < item->sort_key()) {
+                        lo = mid + 1;
+                    } else {
+                        hi = mid;
+                    }
+                }
+                //same key, find the right one
+                for (; lo < n; ++lo) {
+                    auto other = store->get_item(lo);
+                    if (other.operator->() == item) {
+                        return lo;
+                    }
+                    if (other->sort_key() != item->sort_key()) {
+                        break;
+                    }
+                }
+                return n;
+            }
+
+            static Glib::RefPtr<T> ref(T* item) {
+                item->reference();
+                return Glib::RefPtr<T>(item);
+            }
+
+        private:
+            std::vector<store> m_stores;
+            slot_flushed m_on_flushed;
+
+            std::set<T*> m_items;
+            std::set<T*> m_reorder;
+            sigc::connection m_idle;
+
+            bool move(T* raw) {
+                //positions by the old key
+                std::vector<guint> pos;
+                for (auto& store : m_stores) {
+                    pos.push_back(find(store, raw));
+                }
+                if (!raw->update_sort_key()) {
+                    return false;
+                }
+                auto item = ref(raw);
+                for (size_t i = 0; i < m_stores.size(); ++i) {
+                    if (pos[i] < m_stores[i]->get_n_items()) {
+                        m_stores[i]->remove(pos[i]);
+                        m_stores[i]->insert_sorted(item, &T::compare);
+                    }
+                }
+                return true;
+            }
+    };
+}
+
+#endif
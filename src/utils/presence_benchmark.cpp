@@ -0,0 +1,277 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "presence_benchmark.h"
+#include "debug.h"
+#include "presence_batch.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+    //what one contact ends up with after a storm
+    struct presence {
+        Glib::ustring name;
+        Glib::ustring status;
+        Glib::ustring icon = "status_offline";
+    };
+
+    //stands in for dialog::contact_item, next for the toxmm::contact
+    class item: public Glib::Object {
+        public:
+            Glib::Property<Glib::ustring> name;
+            Glib::Property<Glib::ustring> status;
+            Glib::Property<Glib::ustring> icon;
+            presence next;
+
+            item(const Glib::ustring& n):
+                Glib::ObjectBase(typeid(item)),
+                name(*this, "name", n),
+                status(*this, "status"),
+                icon(*this, "icon", "status_offline") {
+                next.name = n;
+                m_sort_key = n.collate_key();
+            }
+
+            void update_presence() {
+                if (icon.get_value() != next.icon) {
+                    icon = next.icon;
+                }
+                if (status.get_value() != next.status) {
+                    status = next.status;
+                }
+                if (name.get_value() != next.name) {
+                    name = next.name;
+                }
+            }
+
+            const std::string& sort_key() const {
+                return m_sort_key;
+            }
+
+            bool update_sort_key() {
+                auto key = next.name.collate_key();
+                if (key == m_sort_key) {
+                    return false;
+                }
+                m_sort_key = std::move(key);
+                return true;
+            }
+
+            static int compare(const Glib::RefPtr<const item>& a,
+                               const Glib::RefPtr<const item>& b) {
+                int res = a->m_sort_key.compare(b->m_sort_key);
+                return (res > 0) - (res < 0);
+            }
+
+        private:
+            std::string m_sort_key;
+    };
+
+    //stands in for widget::contact, the bindings go away with the row
+    class row: public Gtk::Box {
+        public:
+            row(const Glib::RefPtr<item>& it):
+                Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 6),
+                m_labels(Gtk::ORIENTATION_VERTICAL) {
+                m_name.set_xalign(0);
+                m_status.set_xalign(0);
+                m_status.set_ellipsize(Pango::ELLIPSIZE_END);
+                m_labels.add(m_name);
+                m_labels.add(m_status);
+                add(m_icon);
+                add(m_labels);
+                show_all();
+                m_bindings[0] = Glib::Binding::bind_property(it->name.get_proxy(),
+                                                             m_name.property_label(),
+                                                             Glib::BINDING_SYNC_CREATE);
+                m_bindings[1] = Glib::Binding::bind_property(it->status.get_proxy(),
+                                                             m_status.property_label(),
+                                                             Glib::BINDING_SYNC_CREATE);
+                m_bindings[2] = Glib::Binding::bind_property(it->icon.get_proxy(),
+                                                             m_icon.property_icon_name(),
+                                                             Glib::BINDING_SYNC_CREATE);
+            }
+
+        private:
+            Gtk::Image m_icon;
+            Gtk::Box m_labels;
+            Gtk::Label m_name;
+            Gtk::Label m_status;
+            Glib::RefPtr<Glib::Binding> m_bindings[3];
+    };
+
+    class bench {
+        public:
+            bench(int contacts):
+                m_contacts(Gio::ListStore<item>::create()),
+                m_active(Gio::ListStore<item>::create()),
+                m_batch({m_contacts, m_active}) {
+                m_loop = Glib::MainLoop::create();
+
+                for (int i = 0; i < contacts; ++i) {
+                    auto it = Glib::RefPtr<item>(new item(name(i, 0)));
+                    m_items.push_back(it);
+                    m_contacts->insert_sorted(it, &item::compare);
+                    //a few open chats
+                    if (i % 20 == 0) {
+                        m_active->insert_sorted(it, &item::compare);
+                    }
+                }
+
+                auto create_row = [](const Glib::RefPtr<item>& it) -> Gtk::Widget* {
+                    return Gtk::manage(new row(it));
+                };
+                m_list.bind_model(m_contacts, create_row);
+                m_list_active.bind_model(m_active, create_row);
+
+                auto scrolled = Gtk::manage(new Gtk::ScrolledWindow());
+                scrolled->add(m_list);
+                scrolled->set_hexpand(true);
+                m_box.add(m_list_active);
+                m_box.add(*scrolled);
+                m_window.add(m_box);
+                m_window.set_default_size(600, 800);
+                m_window.show_all();
+            }
+
+            void run() {
+                g_signal_connect(m_window.get_frame_clock()->gobj(),
+                                 "after-paint",
+                                 G_CALLBACK(+[](GdkFrameClock*, gpointer self) {
+                                     static_cast<bench*>(self)->painted();
+                                 }),
+                                 this);
+                next_storm();
+                m_loop->run();
+            }
+
+        private:
+            static const int rounds = 10;
+
+            Glib::RefPtr<Glib::MainLoop> m_loop;
+            Glib::RefPtr<Gio::ListStore<item>> m_contacts;
+            Glib::RefPtr<Gio::ListStore<item>> m_active;
+            std::vector<Glib::RefPtr<item>> m_items;
+            //the same batching dialog::main does
+            utils::presence_batch<item> m_batch;
+
+            Gtk::Window m_window;
+            Gtk::Box m_box;
+            Gtk::ListBox m_list;
+            Gtk::ListBox m_list_active;
+
+            bool m_batched = false;
+            int m_round = 0;
+            gint64 m_storm_start = -1;
+            std::vector<gint64> m_times[2];
+
+            static Glib::ustring name(int i, int round) {
+                //shuffles the order with every round
+                return Glib::ustring::compose("contact %1", (i * 7919 + round * 104729) % 100003);
+            }
+
+            void next_storm() {
+                Glib::signal_timeout().connect_once([this]() {
+                    storm();
+                }, 30);
+            }
+
+            //four callbacks per contact, as toxcore fires them
+            void storm() {
+                utils::debug::scope_log log(DBG_LVL_2("gtox"), { m_batched, m_round });
+                m_storm_start = g_get_monotonic_time();
+                auto r = m_round + 1;
+                Glib::ustring connection = r % 2 ? "status_online" : "status_offline";
+                Glib::ustring status     = r % 2 ? "status_away"   : "status_offline";
+                Glib::ustring message    = Glib::ustring::compose("status message %1", r);
+                for (size_t i = 0; i < m_items.size(); ++i) {
+                    auto it = m_items[i].operator->();
+                    it->next.icon = connection;
+                    changed(it);
+                    it->next.icon = status;
+                    changed(it);
+                    it->next.name = name(i, r);
+                    changed(it, true);
+                    it->next.status = message;
+                    changed(it);
+                }
+            }
+
+            //direct applies every callback right away, batched once per tick
+            void changed(item* it, bool reorder = false) {
+                m_batch.queue(it, reorder);
+                if (!m_batched) {
+                    m_batch.flush();
+                }
+            }
+
+            void painted() {
+                if (m_storm_start < 0 || m_batch.pending()) {
+                    return;
+                }
+                m_times[m_batched].push_back(g_get_monotonic_time() - m_storm_start);
+                m_storm_start = -1;
+                if (++m_round == rounds) {
+                    if (m_batched) {
+                        report();
+                        m_loop->quit();
+                        return;
+                    }
+                    m_batched = true;
+                    m_round = 0;
+                }
+                next_storm();
+            }
+
+            void report() {
+                std::clog << std::fixed << std::setprecision(2)
+                          << "PRESENCE-BENCH: " << m_items.size() << " contacts, "
+                          << m_items.size() * 4 << " changes per storm" << std::endl;
+                const char* names[] = { "direct", "batched" };
+                for (int i = 0; i < 2; ++i) {
+                    auto& f = m_times[i];
+                    std::sort(f.begin(), f.end());
+                    gint64 sum = 0;
+                    for (auto t : f) {
+                        sum += t;
+                    }
+                    std::clog << "PRESENCE-BENCH: " << names[i]
+                              << " storm to painted frame"
+                              << " avg " << sum / 1000.0 / f.size() << " ms"
+                              << " median " << f[f.size() / 2] / 1000.0 << " ms"
+                              << " max " << f.back() / 1000.0 << " ms"
+                              << std::endl;
+                }
+            }
+    };
+}
+
+void presence_benchmark::run() {
+    static auto env_contacts = std::stoi("0" + Glib::getenv("GTOX_DBG_PRESENCE_BENCH"));
+    if (env_contacts <= 0) {
+        return;
+    }
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { env_contacts });
+    bench b(env_contacts);
+    b.run();
+}
@@ -0,0 +1,44 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef GTOX_PRESENCE_BENCHMARK_H
+#define GTOX_PRESENCE_BENCHMARK_H
+
+#include <gtkmm.h>
+
+namespace utils {
+    /**
+     * @brief Debug aid, measures frame times of presence storms.
+     *
+     * Fills a contact list with simulated contacts, then changes the
+     * connection, status, name and status message of every one of them
+     * at once, like toxcore does when we come online.
+     * The changes are applied once one by one, as they come in, and once
+     * batched per main-loop tick like dialog::main does.
+     * Prints how long it took from a storm until its frame was painted.
+     *
+     * Enabled by GTOX_DBG_PRESENCE_BENCH=<contacts>.
+     */
+    class presence_benchmark {
+        public:
+            //! runs its own main loop, returns when done
+            static void run();
+    };
+}
+
+#endif
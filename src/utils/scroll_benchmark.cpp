@@ -0,0 +1,122 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "scroll_benchmark.h"
+#include "debug.h"
+#include "dialog/chat.h"
+#include "widget/chat_message.h"
+#include "tox/core.h"
+#include "tox/contact/contact.h"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <vector>
+
+using namespace utils;
+
+int scroll_benchmark::lines() {
+    static auto env_lines = std::stoi("0" + Glib::getenv("GTOX_DBG_SCROLL_BENCH"));
+    return env_lines;
+}
+
+void scroll_benchmark::fill(dialog::chat& chat) {
+    //only the first chat opened, like the benchmarks run from main
+    static bool done = false;
+    auto lines = scroll_benchmark::lines();
+    auto core = chat.m_core.lock();
+    if (done || lines <= 0 || !core) {
+        return;
+    }
+    done = true;
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { lines });
+    //one bubble per line
+    auto contact = chat.m_contact;
+    auto now = Glib::DateTime::create_now_utc();
+    for (int i = 0; i < lines; ++i) {
+        auto time = now.add_minutes(i - lines);
+        Glib::ustring text;
+        for (int j = 0; j <= i % 7; ++j) {
+            text += Glib::ustring::compose("benchmark line %1, some words to wrap. ", i);
+        }
+        if (i % 2) {
+            chat.add_chat_line(dialog::chat::LINE_NEW_APPENDABLE, contact, time,
+                               Gtk::manage(new widget::chat_message(contact->property_name_or_addr(),
+                                                                    time,
+                                                                    text)));
+        } else {
+            chat.add_chat_line(dialog::chat::LINE_NEW_APPENDABLE, core, time,
+                               Gtk::manage(new widget::chat_message(core->property_name_or_addr(),
+                                                                    time,
+                                                                    text)));
+        }
+    }
+    run(*chat.m_scrolled);
+}
+
+void scroll_benchmark::run(Gtk::ScrolledWindow& scrolled, double step) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { step });
+    struct state {
+        gint64 last = -1;
+        std::vector<gint64> frames;
+    };
+    auto s = std::make_shared<state>();
+    auto start = [&scrolled, s, step]() {
+        scrolled.get_vadjustment()->set_value(0);
+        scrolled.add_tick_callback([&scrolled, s, step](const Glib::RefPtr<Gdk::FrameClock>& clock) {
+            auto now = clock->get_frame_time();
+            if (s->last >= 0) {
+                s->frames.push_back(now - s->last);
+            }
+            s->last = now;
+
+            auto adj = scrolled.get_vadjustment();
+            auto end = adj->get_upper() - adj->get_page_size();
+            if (adj->get_value() < end) {
+                adj->set_value(std::min(end, adj->get_value() + step));
+                return true;
+            }
+
+            auto& f = s->frames;
+            if (f.empty()) {
+                return false;
+            }
+            std::sort(f.begin(), f.end());
+            gint64 sum = 0;
+            for (auto t : f) {
+                sum += t;
+            }
+            std::clog << std::fixed << std::setprecision(2)
+                      << "SCROLL-BENCH: " << f.size() << " frames"
+                      << " avg " << sum / 1000.0 / f.size() << " ms"
+                      << " p95 " << f[f.size() * 95 / 100] / 1000.0 << " ms"
+                      << " max " << f.back() / 1000.0 << " ms"
+                      << std::endl;
+            return false;
+        });
+    };
+    if (scrolled.get_mapped()) {
+        start();
+        return;
+    }
+    auto con = std::make_shared<sigc::connection>();
+    *con = scrolled.signal_map().connect([con, start]() {
+        con->disconnect();
+        start();
+    });
+}
@@ -0,0 +1,49 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef GTOX_SCROLL_BENCHMARK_H
+#define GTOX_SCROLL_BENCHMARK_H
+
+#include <gtkmm.h>
+
+namespace dialog {
+    class chat;
+}
+
+namespace utils {
+    /**
+     * @brief Debug aid, scrolls a window from top to bottom, one step
+     * per frame, and prints how long the frames took.
+     *
+     * Enabled by GTOX_DBG_SCROLL_BENCH=<lines>, the chat gets that
+     * many messages first.
+     */
+    class scroll_benchmark {
+        public:
+            //! lines asked for, 0 when not enabled
+            static int lines();
+
+            //! fills the first chat with fake history and scrolls through it
+            static void fill(dialog::chat& chat);
+
+            //! starts once the window is mapped
+            static void run(Gtk::ScrolledWindow& scrolled, double step = 60);
+    };
+}
+
+#endif
@@ -58,6 +58,40 @@ void storage::save(const std::initializer_list<std::string>& key, const std::vec
     stream->close();
 }
 
+void storage::list(const std::initializer_list<std::string>& key, std::vector<std::string>& names) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { std::vector<std::string>(key) });
+    names.clear();
+    auto dir_path = get_path_for_key(key);
+    dir_path.resize(dir_path.size() - 4); // ".bin"
+
+    auto dir = Gio::File::create_for_path(dir_path);
+    Glib::RefPtr<Gio::FileEnumerator> children;
+    try {
+        children = dir->enumerate_children(G_FILE_ATTRIBUTE_STANDARD_NAME);
+    } catch (Gio::Error) {
+        //no folder, nothing saved
+        return;
+    }
+    const std::string ext = ".bin";
+    while (auto info = children->next_file()) {
+        auto name = info->get_name();
+        if (name.size() > ext.size() &&
+            name.compare(name.size() - ext.size(), ext.size(), ext) == 0) {
+            names.push_back(name.substr(0, name.size() - ext.size()));
+        }
+    }
+}
+
+void storage::remove(const std::initializer_list<std::string>& key) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { std::vector<std::string>(key) });
+    auto file = Gio::File::create_for_path(get_path_for_key(key));
+    try {
+        file->remove();
+    } catch (Gio::Error) {
+        //already gone
+    }
+}
+
 std::string storage::get_path_for_key(const std::initializer_list<std::string>& key) {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), { std::vector<std::string>(key) });
     std::string file_path = Glib::build_filename(Glib::get_user_config_dir(),
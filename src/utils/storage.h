@@ -18,6 +18,8 @@ namespace utils {
             void set_prefix_key(const std::string& prefix) override;
             void load(const std::initializer_list<std::string>& key, std::vector<uint8_t>& data) override;
             void save(const std::initializer_list<std::string>& key, const std::vector<uint8_t>& data) override;
+            void list(const std::initializer_list<std::string>& key, std::vector<std::string>& names) override;
+            void remove(const std::initializer_list<std::string>& key) override;
 
             std::string get_path_for_key(const std::initializer_list<std::string>& key);
     };
@@ -0,0 +1,120 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "timestamp_ticker.h"
+#include "debug.h"
+
+using namespace utils;
+
+class timestamp_ticker::entry {
+    public:
+        Glib::DateTime time;
+        std::function<void()> refresh;
+        bool queued = false;
+        std::multimap<gint64, entry*>::iterator pos;
+};
+
+timestamp_ticker& timestamp_ticker::instance() {
+    static timestamp_ticker ticker;
+    return ticker;
+}
+
+timestamp_ticker::handle timestamp_ticker::add(Glib::DateTime time, std::function<void()> refresh) {
+    utils::debug::scope_log log(DBG_LVL_3("gtox"), { time.format("%c").raw() });
+    auto e = new entry;
+    e->time = time.to_local();
+    e->refresh = refresh;
+    instance().queue(e);
+    instance().schedule();
+    return handle(e, [](entry* e) {
+        instance().unqueue(e);
+        delete e;
+    });
+}
+
+gint64 timestamp_ticker::next_change(const Glib::DateTime& time) {
+    auto local = time.to_local();
+    auto now   = Glib::DateTime::create_now_local();
+    if (local.get_year() != now.get_year()) {
+        //shows the full date, never changes again
+        return -1;
+    }
+    //week and day based texts change at midnight
+    auto tomorrow = now.add_days(1);
+    gint64 due = Glib::DateTime::create_local(tomorrow.get_year(),
+                                              tomorrow.get_month(),
+                                              tomorrow.get_day_of_month(),
+                                              0, 0, 0).to_unix();
+    auto start = local.to_unix();
+    auto age   = std::max<gint64>(0, now.to_unix() - start);
+    if (age < 60 * 60) {
+        due = std::min(due, start + (age / 60 + 1) * 60);
+    } else if (age < 24 * 60 * 60) {
+        due = std::min(due, start + (age / (60 * 60) + 1) * 60 * 60);
+    }
+    return due;
+}
+
+void timestamp_ticker::queue(entry* e) {
+    auto due = next_change(e->time);
+    if (due < 0) {
+        return;
+    }
+    e->pos = m_queue.emplace(due, e);
+    e->queued = true;
+}
+
+void timestamp_ticker::unqueue(entry* e) {
+    if (e->queued) {
+        m_queue.erase(e->pos);
+        e->queued = false;
+    }
+}
+
+void timestamp_ticker::schedule() {
+    if (m_queue.empty()) {
+        m_timer.disconnect();
+        m_timer_due = -1;
+        return;
+    }
+    auto due = m_queue.begin()->first;
+    if (m_timer.connected() && m_timer_due <= due) {
+        return;
+    }
+    m_timer.disconnect();
+    m_timer_due = due;
+    auto delay = std::max<gint64>(1, due - Glib::DateTime::create_now_local().to_unix());
+    m_timer = Glib::signal_timeout().connect_seconds([this]() {
+        tick();
+        return false;
+    }, delay);
+}
+
+void timestamp_ticker::tick() {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+    m_timer.disconnect();
+    m_timer_due = -1;
+    auto now = Glib::DateTime::create_now_local().to_unix();
+    while (!m_queue.empty() && m_queue.begin()->first <= now) {
+        auto e = m_queue.begin()->second;
+        unqueue(e);
+        e->refresh();
+        queue(e);
+    }
+    schedule();
+}
@@ -0,0 +1,65 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef H_GTOX_TIMESTAMP_TICKER
+#define H_GTOX_TIMESTAMP_TICKER
+
+#include <glibmm.h>
+#include <functional>
+#include <memory>
+#include <map>
+
+namespace utils {
+    /**
+     * @brief One shared timer for relative timestamps ("5 mins", "2 hrs").
+     *
+     * Every entry is queued by the time its text can change next: each
+     * minute within the first hour, each hour within the first day, at
+     * midnight within the same year and never after that.
+     * Only entries that are due get refreshed.
+     * Main-loop only.
+     */
+    class timestamp_ticker {
+        public:
+            class entry;
+            using handle = std::shared_ptr<entry>;
+
+            /**
+             * @brief registers a refresh callback, keep the handle alive
+             * as long as the callback is valid
+             */
+            static handle add(Glib::DateTime time, std::function<void()> refresh);
+
+            //! unix time when the text for time changes next, -1 for never
+            static gint64 next_change(const Glib::DateTime& time);
+
+        private:
+            std::multimap<gint64, entry*> m_queue;
+            sigc::connection m_timer;
+            gint64 m_timer_due = -1;
+
+            static timestamp_ticker& instance();
+
+            void queue(entry* e);
+            void unqueue(entry* e);
+            void schedule();
+            void tick();
+    };
+}
+
+#endif
@@ -0,0 +1,147 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "video_frame.h"
+#include "debug.h"
+#include <gst/video/video.h>
+#include <vector>
+
+using namespace utils;
+
+struct video_frame::mapped {
+    GstBuffer* buffer;
+    GstMapInfo map;
+};
+
+namespace {
+    //recycled mapped structs, a stream only has a few frames alive
+    std::mutex free_mutex;
+    std::vector<void*> free_list;
+    const size_t free_max = 16;
+}
+
+video_frame::mapped* video_frame::acquire() {
+    {
+        std::lock_guard<std::mutex> lg(free_mutex);
+        if (!free_list.empty()) {
+            auto m = static_cast<mapped*>(free_list.back());
+            free_list.pop_back();
+            return m;
+        }
+    }
+    return new mapped();
+}
+
+void video_frame::release(guchar*, gpointer data) {
+    auto m = static_cast<mapped*>(data);
+    if (m->buffer) {
+        gst_buffer_unmap(m->buffer, &m->map);
+        gst_buffer_unref(m->buffer);
+        m->buffer = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lg(free_mutex);
+        if (free_list.size() < free_max) {
+            free_list.push_back(m);
+            return;
+        }
+    }
+    delete m;
+}
+
+Glib::RefPtr<Gdk::Pixbuf> video_frame::wrap(GstSample* sample, int width, int height) {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), { width, height });
+    if (!sample || width <= 0 || height <= 0) {
+        return {};
+    }
+    auto buffer = gst_sample_get_buffer(sample);
+    if (!buffer) {
+        return {};
+    }
+
+    auto m = acquire();
+    m->buffer = nullptr;
+    if (!gst_buffer_map(buffer, &m->map, GST_MAP_READ)) {
+        release(nullptr, m);
+        return {};
+    }
+
+    //videoconvert aligns RGB rows to 4 bytes
+    int stride = GST_ROUND_UP_4(width * 3);
+    if (m->map.size < gsize(stride) * (height - 1) + gsize(width) * 3) {
+        gst_buffer_unmap(buffer, &m->map);
+        release(nullptr, m);
+        return {};
+    }
+    m->buffer = gst_buffer_ref(buffer);
+
+    return Glib::wrap(gdk_pixbuf_new_from_data(m->map.data,
+                                               GDK_COLORSPACE_RGB,
+                                               false,
+                                               8,
+                                               width,
+                                               height,
+                                               stride,
+                                               &video_frame::release,
+                                               m),
+                      false);
+}
+
+toxmm::av::i420 video_frame::wrap_i420(GstSample* sample, gint64 captured) {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+    if (!sample) {
+        return {};
+    }
+    auto buffer = gst_sample_get_buffer(sample);
+    auto caps = gst_sample_get_caps(sample);
+    GstVideoInfo info;
+    if (!buffer || !caps || !gst_video_info_from_caps(&info, caps)) {
+        return {};
+    }
+    if (GST_VIDEO_INFO_FORMAT(&info) != GST_VIDEO_FORMAT_I420) {
+        return {};
+    }
+
+    auto m = acquire();
+    m->buffer = nullptr;
+    if (!gst_buffer_map(buffer, &m->map, GST_MAP_READ)) {
+        release(nullptr, m);
+        return {};
+    }
+    if (m->map.size < GST_VIDEO_INFO_SIZE(&info)) {
+        gst_buffer_unmap(buffer, &m->map);
+        release(nullptr, m);
+        return {};
+    }
+    m->buffer = gst_buffer_ref(buffer);
+
+    auto data = m->map.data;
+    std::shared_ptr<const void> owner(m, [](const void* ptr) {
+        release(nullptr, const_cast<void*>(ptr));
+    });
+    return toxmm::av::i420(GST_VIDEO_INFO_WIDTH(&info),
+                           GST_VIDEO_INFO_HEIGHT(&info),
+                           data + GST_VIDEO_INFO_PLANE_OFFSET(&info, 0),
+                           data + GST_VIDEO_INFO_PLANE_OFFSET(&info, 1),
+                           data + GST_VIDEO_INFO_PLANE_OFFSET(&info, 2),
+                           GST_VIDEO_INFO_PLANE_STRIDE(&info, 0),
+                           GST_VIDEO_INFO_PLANE_STRIDE(&info, 1),
+                           GST_VIDEO_INFO_PLANE_STRIDE(&info, 2),
+                           owner,
+                           captured);
+}
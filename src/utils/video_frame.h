@@ -0,0 +1,116 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef GTOX_VIDEO_FRAME_H
+#define GTOX_VIDEO_FRAME_H
+
+#include <gtkmm.h>
+#include <gst/gst.h>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include "dispatcher.h"
+#include "tox/av.h"
+
+namespace utils {
+    /**
+     * @brief Turns samples from an appsink into frames without copying.
+     *
+     * The frame references the GstBuffer and keeps it mapped until the
+     * frame is freed.
+     */
+    class video_frame {
+        public:
+            static Glib::RefPtr<Gdk::Pixbuf> wrap(GstSample* sample, int width, int height);
+
+            /**
+             * @brief same for I420 samples, the planes stay in the buffer
+             * @param captured g_get_monotonic_time() of the capture
+             */
+            static toxmm::av::i420 wrap_i420(GstSample* sample, gint64 captured);
+
+        private:
+            struct mapped;
+            static mapped* acquire();
+            static void release(guchar* pixels, gpointer data);
+    };
+
+    /**
+     * @brief Passes the newest frame from a streaming thread to the main loop.
+     *
+     * Only one frame waits at a time, a newer frame replaces it. When the
+     * main loop falls behind frames get dropped instead of queued up.
+     */
+    template<typename T>
+    class handoff: public std::enable_shared_from_this<handoff<T>> {
+        public:
+            using slot_frame = std::function<void(T)>;
+
+            handoff(utils::dispatcher::ref dispatcher, slot_frame on_frame):
+                m_dispatcher(dispatcher),
+                m_on_frame(on_frame) {}
+
+            //! can be called from any thread
+            void push(T frame) {
+                std::lock_guard<std::mutex> lg(m_mutex);
+                if (m_pending) {
+                    ++m_dropped;
+                }
+                m_frame = frame;
+                m_pending = true;
+                if (m_scheduled) {
+                    return;
+                }
+                m_scheduled = true;
+                std::weak_ptr<handoff> weak = this->shared_from_this();
+                m_dispatcher.emit([weak]() {
+                    auto self = weak.lock();
+                    if (!self) {
+                        return;
+                    }
+                    T frame;
+                    {
+                        std::lock_guard<std::mutex> lg(self->m_mutex);
+                        std::swap(frame, self->m_frame);
+                        self->m_pending = false;
+                        self->m_scheduled = false;
+                    }
+                    self->m_on_frame(frame);
+                });
+            }
+
+            //! frames replaced before the main loop got them
+            unsigned dropped() {
+                std::lock_guard<std::mutex> lg(m_mutex);
+                return m_dropped;
+            }
+
+        private:
+            utils::dispatcher::ref m_dispatcher;
+            slot_frame m_on_frame;
+
+            std::mutex m_mutex;
+            T m_frame;
+            bool m_pending = false;
+            bool m_scheduled = false;
+            unsigned m_dropped = 0;
+    };
+
+    using frame_handoff = handoff<Glib::RefPtr<Gdk::Pixbuf>>;
+}
+#endif
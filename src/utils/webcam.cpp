@@ -17,9 +17,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>
 **/
 #include "webcam.h"
-#include <gstreamermm/bus.h>
-#include <gstreamermm/elementfactory.h>
-#include <glibmm/i18n.h>
+#include <algorithm>
 
 #ifndef SIGC_CPP11_HACK
 #define SIGC_CPP11_HACK
@@ -47,113 +45,39 @@ auto webcam::property_pixbuf()   -> Glib::PropertyProxy_ReadOnly<Glib::RefPtr<Gd
 void webcam::init() {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
 
-    m_pipeline = Gst::Pipeline::create();
-    m_appsink  = Gst::AppSink::create();
-
-    m_appsink->property_caps() = Gst::Caps::create_from_string("video/x-raw,format=RGB,pixel-aspect-ratio=1/1");
-    m_appsink->property_max_buffers() = 3;
-    m_appsink->property_drop() = true;
-    m_appsink->property_emit_signals() = true;
-
-    auto device_source = Glib::wrap(gst_device_create_element(property_device().get_value().get(), nullptr));
-    auto convert = Gst::ElementFactory::create_element("videoconvert");
-    m_pipeline->add(device_source);
-    m_pipeline->add(convert);
-    m_pipeline->add(m_appsink);
-
-    device_source->link(convert);
-    convert->link(m_appsink);
-
-    utils::dispatcher::ref weak_dispatcher = m_dispatcher;
-    auto resolution = std::make_shared<std::pair<int, int>>();
-
-    m_appsink->signal_new_preroll().connect(sigc::track_obj([this, sink = m_appsink, weak_dispatcher, resolution, prev_dispatched = sigc::connection()]() mutable {
-        utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-        auto preroll = sink->pull_preroll();
-        if (!preroll) {
-            return Gst::FLOW_OK;
-        }
-        //C++ version is buggy, use C version
-        auto caps = gst_sample_get_caps(preroll->gobj());
-        if (!caps) {
-            return Gst::FLOW_OK;
-        }
-        if (gst_caps_is_empty(caps)) {
-            return Gst::FLOW_OK;
-        }
-
-        auto struc = gst_caps_get_structure(caps, 0); // < can this fail ?
-        int w,h;
-        if (!gst_structure_get_int(struc, "width", &w)) {
-            return Gst::FLOW_OK;
-        }
-        if (!gst_structure_get_int(struc, "height", &h)) {
-            return Gst::FLOW_OK;
-        }
-        resolution->first = w;
-        resolution->second = h;
-
-        auto frame = extract_frame(preroll, resolution);
-        prev_dispatched.disconnect();
-        prev_dispatched = weak_dispatcher.emit([this, frame]() {
-            utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-            m_property_pixbuf.set_value(frame);
-        });
-        return Gst::FLOW_OK;
+    auto capture = webcam_capture::get(property_device().get_value());
+    if (!capture) {
+        return;
+    }
 
+    m_error_connection = capture->signal_error().connect(sigc::track_obj([this](Glib::ustring error) {
+        m_signal_error(error);
     }, *this));
-    m_appsink->signal_new_sample().connect(sigc::track_obj([this, sink = m_appsink, weak_dispatcher, resolution, prev_dispatched = sigc::connection()]() mutable {
-        utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-        auto sample = sink->pull_sample();
-        auto frame = extract_frame(sample, resolution);
-        prev_dispatched.disconnect();
-        prev_dispatched = weak_dispatcher.emit([this, frame]() {
-            utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-            m_property_pixbuf.set_value(frame);
-        });
-        return Gst::FLOW_OK;
+    m_eos_connection = capture->signal_eos().connect(sigc::track_obj([this]() {
+        property_state() = Gst::STATE_NULL;
     }, *this));
 
-    m_pipeline->get_bus()->add_watch(
-                sigc::track_obj([this](
-                                const Glib::RefPtr<Gst::Bus>&,
-                                const Glib::RefPtr<Gst::Message>& message) {
-        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
-        Glib::RefPtr<Gst::MessageError> error;
-
-        switch (message->get_message_type()) {
-            case Gst::MESSAGE_EOS:
-                property_state() = Gst::STATE_NULL;
-                break;
-            case Gst::MESSAGE_ERROR:
-                error = decltype(error)::cast_static(message);
-                if (error) {
-                    m_signal_error(error->parse().what());
-                } else {
-                    m_signal_error(_("unknown gstreamer error"));
-                }
-                break;
-            default:
-                break;
-        }
-
-        return true;
-    }, *this));
+    m_handoff = std::make_shared<frame_handoff>(m_dispatcher, [this](Glib::RefPtr<Gdk::Pixbuf> frame) {
+        utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+        m_property_pixbuf.set_value(frame);
+    });
 
-    property_state().signal_changed().connect(sigc::track_obj([this]() {
-        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
-        if (m_pipeline) {
-            m_pipeline->set_state(property_state());
+    auto handoff = m_handoff;
+    m_subscription = capture->subscribe("video/x-raw,format=RGB,pixel-aspect-ratio=1/1",
+                                        [handoff](GstSample* sample, int w, int h, gint64) {
+        auto frame = video_frame::wrap(sample, w, h);
+        if (frame) {
+            handoff->push(frame);
         }
-    }, *this));
-
-    m_pipeline->set_state(property_state());
+    });
 }
 
 void webcam::destroy() {
-    if (m_pipeline) {
-        m_pipeline->set_state(Gst::STATE_NULL);
-    }
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    m_subscription.reset();
+    m_handoff.reset();
+    m_error_connection.disconnect();
+    m_eos_connection.disconnect();
 }
 
 webcam::webcam():
@@ -164,7 +88,7 @@ webcam::webcam():
 
     property_state().signal_changed().connect(sigc::track_obj([this]() {
        if (property_state() == Gst::STATE_PLAYING) {
-           if (!m_pipeline && property_device().get_value()) {
+           if (!m_subscription && property_device().get_value()) {
                init();
            }
        } else {
@@ -173,8 +97,11 @@ webcam::webcam():
     }, *this));
 
     property_device().signal_changed().connect(sigc::track_obj([this]() {
-        // uri changed
+        // device changed
         destroy();
+        if (property_state() == Gst::STATE_PLAYING && property_device().get_value()) {
+            init();
+        }
     }, *this));
 }
 
@@ -182,33 +109,99 @@ webcam::~webcam() {
     destroy();
 }
 
-std::vector<std::shared_ptr<GstDevice>> webcam::get_webcam_devices() {
-    //INFO: There is no C++ - version of this..
-    //TODO: Memory Leak check ?
-    GstDeviceMonitor *monitor = gst_device_monitor_new();
+namespace {
+    struct device_cache {
+        GstDeviceMonitor* monitor = nullptr;
+        //true when the monitor runs and the list follows its bus
+        bool live = false;
+        std::vector<std::shared_ptr<GstDevice>> devices;
+        sigc::signal<void> signal_changed;
+    };
+
+    std::shared_ptr<GstDevice> wrap_device(GstDevice* device) {
+        //takes the reference
+        return std::shared_ptr<GstDevice>(device, [](GstDevice* ptr) {
+            g_object_unref(ptr);
+        });
+    }
+
+    void probe_devices(device_cache& cache) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        cache.devices.clear();
+        GList *list = gst_device_monitor_get_devices(cache.monitor);
+        for (GList *it = list; it != nullptr; it = it->next) {
+            cache.devices.push_back(wrap_device((GstDevice*)it->data));
+        }
+        g_list_free(list);
+    }
+
+    gboolean on_device_message(GstBus*, GstMessage* message, gpointer data) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        auto& cache = *static_cast<device_cache*>(data);
+        GstDevice* device = nullptr;
+        auto find = [&]() {
+            return std::find_if(cache.devices.begin(), cache.devices.end(), [&](const std::shared_ptr<GstDevice>& d) {
+                return d.get() == device;
+            });
+        };
+        switch (GST_MESSAGE_TYPE(message)) {
+            case GST_MESSAGE_DEVICE_ADDED:
+                gst_message_parse_device_added(message, &device);
+                if (find() == cache.devices.end()) {
+                    cache.devices.push_back(wrap_device(device));
+                } else {
+                    g_object_unref(device);
+                }
+                cache.signal_changed();
+                break;
+            case GST_MESSAGE_DEVICE_REMOVED:
+                gst_message_parse_device_removed(message, &device);
+                {
+                    auto iter = find();
+                    if (iter != cache.devices.end()) {
+                        cache.devices.erase(iter);
+                    }
+                }
+                g_object_unref(device);
+                cache.signal_changed();
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
 
-    //Filter
-    gst_device_monitor_add_filter(monitor, "Video/Source", nullptr);
+    device_cache& get_device_cache() {
+        static device_cache cache;
+        if (!cache.monitor) {
+            utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+            //INFO: There is no C++ - version of this..
+            cache.monitor = gst_device_monitor_new();
+            gst_device_monitor_add_filter(cache.monitor, "Video/Source", nullptr);
 
-    //Get all devices
-    decltype(get_webcam_devices()) result;
-    GList *list = gst_device_monitor_get_devices(monitor);
-    GList *it = list;
-    while (it != nullptr)
-    {
-        auto device = (GstDevice*)it->data;
+            auto bus = gst_device_monitor_get_bus(cache.monitor);
+            gst_bus_add_watch(bus, &on_device_message, &cache);
+            gst_object_unref(bus);
 
-        //maybe need to g_object_ref ?
-        result.emplace_back(device, [](GstDevice* ptr) {
-            g_object_unref(ptr); // free memory ?
-        });
+            cache.live = gst_device_monitor_start(cache.monitor);
+            probe_devices(cache);
+        }
+        return cache;
+    }
+}
 
-        it = it->next;
+std::vector<std::shared_ptr<GstDevice>> webcam::get_webcam_devices() {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+    auto& cache = get_device_cache();
+    if (!cache.live) {
+        //no hotplug messages, probe again
+        probe_devices(cache);
     }
-    g_list_free(list);       //free memory ?
-    g_object_unref(monitor); //free memory ?
+    return cache.devices;
+}
 
-    return result;
+sigc::signal<void>& webcam::signal_devices_changed() {
+    return get_device_cache().signal_changed;
 }
 
 Glib::ustring webcam::get_webcam_device_name(const std::shared_ptr<GstDevice>& device) {
@@ -229,35 +222,3 @@ std::shared_ptr<GstDevice> webcam::get_webcam_device_by_name(const Glib::ustring
     }
     return nullptr;
 }
-
-Glib::RefPtr<Gdk::Pixbuf> webcam::extract_frame(Glib::RefPtr<Gst::Sample> sample,
-                                                std::shared_ptr<std::pair<int, int>> resolution) {
-    utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-    static auto null = Glib::RefPtr<Gdk::Pixbuf>();
-    if (!sample) {
-        return null;
-    }
-
-    auto buffer = sample->get_buffer();
-    if (!buffer) {
-        return null;
-    }
-    auto map = Glib::RefPtr<Gst::MapInfo>(new Gst::MapInfo);
-    if (!buffer->map(map, Gst::MAP_READ)) {
-        return null;
-    }
-    auto mem = new uint8_t[map->get_size()];
-    std::copy(map->get_data(), map->get_data() + map->get_size(), mem);
-    buffer->unmap(map);
-
-    return Gdk::Pixbuf::create_from_data(mem,
-                                         Gdk::COLORSPACE_RGB,
-                                         false,
-                                         8,
-                                         resolution->first,
-                                         resolution->second,
-                                         GST_ROUND_UP_4( resolution->first*3 ),
-                                         [](const guint8* data) {
-        delete[] data;
-    });
-}
@@ -21,18 +21,27 @@
 
 #include <gtkmm.h>
 #include <glibmm.h>
-#include <gstreamermm/pipeline.h>
-#include <gstreamermm/appsink.h>
+#include <gst/gst.h>
 #include "dispatcher.h"
+#include "webcam_capture.h"
+#include "video_frame.h"
 #include "utils/debug.h"
 
 namespace utils {
+    /**
+     * @brief RGB preview of a webcam.
+     *
+     * Frames come from the device's shared webcam_capture, so several
+     * previews and calls can use the same device at once.
+     */
     class webcam: public Glib::Object, public debug::track_obj<webcam> {
         private:
             utils::dispatcher m_dispatcher;
 
-            Glib::RefPtr<Gst::Pipeline> m_pipeline;
-            Glib::RefPtr<Gst::AppSink>  m_appsink;
+            webcam_capture::handle m_subscription;
+            std::shared_ptr<frame_handoff> m_handoff;
+            sigc::connection m_error_connection;
+            sigc::connection m_eos_connection;
 
             void init();
             void destroy();
@@ -52,21 +61,24 @@ namespace utils {
             webcam(const webcam&) = delete;
             void operator=(const webcam&) = delete;
 
-            // ! the following function will block !
+            /**
+             * @brief cached device list, kept up to date by a running
+             * GstDeviceMonitor. Only blocks on the first call, or on every
+             * call when the monitor can't be started.
+             */
             static std::vector<std::shared_ptr<GstDevice>> get_webcam_devices();
             static Glib::ustring get_webcam_device_name(const std::shared_ptr<GstDevice>& device);
-            // ! the following function will block !
             static std::shared_ptr<GstDevice> get_webcam_device_by_name(const Glib::ustring& name);
 
+            //! emitted when devices get plugged in or removed
+            static sigc::signal<void>& signal_devices_changed();
+
         private:
             Glib::Property<std::shared_ptr<GstDevice>> m_property_device;
             Glib::Property<Gst::State>                 m_property_state;
             Glib::Property<Glib::RefPtr<Gdk::Pixbuf>>  m_property_pixbuf;
 
             type_signal_error m_signal_error;
-
-            static Glib::RefPtr<Gdk::Pixbuf> extract_frame(Glib::RefPtr<Gst::Sample> sample,
-                                                           std::shared_ptr<std::pair<int, int> > resolution);
     };
 }
 #endif
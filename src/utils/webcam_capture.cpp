@@ -0,0 +1,349 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "webcam_capture.h"
+#include <gstreamermm/bus.h>
+#include <gstreamermm/elementfactory.h>
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#ifndef SIGC_CPP11_HACK
+#define SIGC_CPP11_HACK
+namespace sigc {
+    SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
+}
+#endif
+
+using namespace utils;
+
+namespace {
+    //device pointers get reused, paths and serials stay with the device
+    std::string device_key(GstDevice* device) {
+        std::string key;
+        auto props = gst_device_get_properties(device);
+        if (props) {
+            for (auto name : { "device.path", "object.path", "device.serial", "sysfs.path" }) {
+                auto value = gst_structure_get_string(props, name);
+                if (value) {
+                    key = std::string(name) + "=" + value;
+                    break;
+                }
+            }
+            gst_structure_free(props);
+        }
+        if (key.empty()) {
+            //display names aren't unique, two equal webcams would share
+            //one capture. the capture keeps its device alive, so the
+            //pointer isn't reused while it runs
+            key = "device=" + std::to_string(reinterpret_cast<uintptr_t>(device));
+        }
+        return key;
+    }
+}
+
+auto webcam_capture::signal_error() -> type_signal_error {
+    return m_signal_error;
+}
+
+auto webcam_capture::signal_eos() -> type_signal_eos {
+    return m_signal_eos;
+}
+
+std::shared_ptr<webcam_capture> webcam_capture::get(const std::shared_ptr<GstDevice>& device) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    static std::map<std::string, std::weak_ptr<webcam_capture>> captures;
+    if (!device) {
+        return nullptr;
+    }
+
+    auto& weak = captures[device_key(device.get())];
+    auto capture = weak.lock();
+    if (!capture) {
+        capture = std::shared_ptr<webcam_capture>(new webcam_capture(device));
+        capture->init();
+        weak = capture;
+    }
+
+    for (auto iter = captures.begin(); iter != captures.end();) {
+        if (iter->second.expired()) {
+            iter = captures.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    return capture;
+}
+
+webcam_capture::webcam_capture(std::shared_ptr<GstDevice> device):
+    m_device(device) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+}
+
+void webcam_capture::init() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+
+    m_pipeline = Gst::Pipeline::create();
+    m_tee      = Gst::ElementFactory::create_element("tee");
+    //branches come and go, the source keeps running without any
+    g_object_set(m_tee->gobj(), "allow-not-linked", TRUE, nullptr);
+
+    auto device_source = Glib::wrap(gst_device_create_element(m_device.get(), nullptr));
+    m_pipeline->add(device_source);
+    m_pipeline->add(m_tee);
+
+    device_source->link(m_tee);
+
+    std::weak_ptr<webcam_capture> weak = shared_from_this();
+    m_bus_watch = m_pipeline->get_bus()->add_watch([weak](
+                                                   const Glib::RefPtr<Gst::Bus>&,
+                                                   const Glib::RefPtr<Gst::Message>& message) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        auto self = weak.lock();
+        if (!self) {
+            return false;
+        }
+        Glib::RefPtr<Gst::MessageError> error;
+
+        switch (message->get_message_type()) {
+            case Gst::MESSAGE_EOS:
+                self->m_signal_eos();
+                break;
+            case Gst::MESSAGE_ERROR:
+                error = decltype(error)::cast_static(message);
+                if (error) {
+                    self->m_signal_error(error->parse().what());
+                } else {
+                    self->m_signal_error(_("unknown gstreamer error"));
+                }
+                break;
+            default:
+                break;
+        }
+
+        return true;
+    });
+}
+
+webcam_capture::~webcam_capture() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    if (m_pipeline) {
+        if (m_bus_watch) {
+            m_pipeline->get_bus()->remove_watch(m_bus_watch);
+        }
+        //joins the streaming threads
+        m_pipeline->set_state(Gst::STATE_NULL);
+    }
+}
+
+std::shared_ptr<webcam_capture::branch> webcam_capture::get_branch(const Glib::ustring& caps) {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), { caps.raw() });
+    auto iter = m_branches.find(caps);
+    if (iter != m_branches.end()) {
+        return iter->second;
+    }
+
+    auto b = std::make_shared<branch>();
+    b->caps = caps;
+
+    auto queue   = Gst::ElementFactory::create_element("queue");
+    auto rate    = Gst::ElementFactory::create_element("videorate");
+    auto convert = Gst::ElementFactory::create_element("videoconvert");
+    auto scale   = Gst::ElementFactory::create_element("videoscale");
+    b->sink      = Gst::AppSink::create();
+
+    //keep only the newest frame
+    g_object_set(queue->gobj(),
+                 "leaky", 2, //downstream
+                 "max-size-buffers", 1u,
+                 "max-size-bytes", 0u,
+                 "max-size-time", guint64(0),
+                 nullptr);
+
+    b->sink->property_caps() = Gst::Caps::create_from_string(caps);
+    b->sink->property_max_buffers() = 1;
+    b->sink->property_drop() = true;
+    b->sink->property_emit_signals() = true;
+
+    auto raw = b.get();
+    b->sink->signal_new_preroll().connect([this, raw]() {
+        utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+        deliver(raw, raw->sink->pull_preroll());
+        return Gst::FLOW_OK;
+    });
+    b->sink->signal_new_sample().connect([this, raw]() {
+        utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+        deliver(raw, raw->sink->pull_sample());
+        return Gst::FLOW_OK;
+    });
+
+    m_pipeline->add(queue);
+    m_pipeline->add(rate);
+    m_pipeline->add(convert);
+    m_pipeline->add(scale);
+    m_pipeline->add(b->sink);
+
+    queue->link(rate);
+    rate->link(convert);
+    convert->link(scale);
+    scale->link(b->sink);
+    b->tee_pad = m_tee->get_request_pad("src_%u");
+    b->tee_pad->link(queue->get_static_pad("sink"));
+    b->elements = { queue, rate, convert, scale, b->sink };
+
+    if (m_started) {
+        //join the running pipeline, downstream first
+        b->sink->sync_state_with_parent();
+        scale->sync_state_with_parent();
+        convert->sync_state_with_parent();
+        rate->sync_state_with_parent();
+        queue->sync_state_with_parent();
+    }
+
+    m_branches[caps] = b;
+    return b;
+}
+
+void webcam_capture::deliver(branch* b, Glib::RefPtr<Gst::Sample> sample) {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+    if (!sample) {
+        return;
+    }
+    //C++ version is buggy, use C version
+    auto caps = gst_sample_get_caps(sample->gobj());
+    if (!caps) {
+        return;
+    }
+    if (gst_caps_is_empty(caps)) {
+        return;
+    }
+
+    auto struc = gst_caps_get_structure(caps, 0);
+    int w,h;
+    if (!gst_structure_get_int(struc, "width", &w)) {
+        return;
+    }
+    if (!gst_structure_get_int(struc, "height", &h)) {
+        return;
+    }
+
+    //live sources stamp buffers with the running time of the pipeline
+    //clock, the default system clock is monotonic like glib's
+    gint64 now = g_get_monotonic_time();
+    gint64 captured = now;
+    auto buffer = gst_sample_get_buffer(sample->gobj());
+    if (buffer && GST_BUFFER_PTS_IS_VALID(buffer)) {
+        auto base_time = gst_element_get_base_time(GST_ELEMENT(m_pipeline->gobj()));
+        gint64 pts = gint64((base_time + GST_BUFFER_PTS(buffer)) / 1000);
+        if (pts <= now && now - pts < G_USEC_PER_SEC) {
+            captured = pts;
+        }
+    }
+
+    std::lock_guard<std::mutex> lg(m_mutex);
+    for (auto s : b->subscribers) {
+        s->m_slot(sample->gobj(), w, h, captured);
+    }
+}
+
+webcam_capture::handle webcam_capture::subscribe(const Glib::ustring& caps, slot_sample slot) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { caps.raw() });
+    auto b = get_branch(caps);
+
+    auto s = std::make_shared<subscription>();
+    s->m_capture = shared_from_this();
+    s->m_branch  = b;
+    s->m_slot    = slot;
+    {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        b->subscribers.push_back(s.get());
+    }
+
+    if (!m_started) {
+        m_started = true;
+        m_pipeline->set_state(Gst::STATE_PLAYING);
+    }
+
+    return s;
+}
+
+void webcam_capture::unsubscribe(subscription* s) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    bool unused;
+    {
+        //waits for a running delivery
+        std::lock_guard<std::mutex> lg(m_mutex);
+        auto& subs = s->m_branch->subscribers;
+        subs.erase(std::remove(subs.begin(), subs.end(), s), subs.end());
+        unused = subs.empty();
+    }
+    //outside of the lock, stopping the branch joins its streaming thread
+    if (unused) {
+        remove_branch(s->m_branch);
+    }
+}
+
+void webcam_capture::remove_branch(const std::shared_ptr<branch>& b) {
+    utils::debug::scope_log log(DBG_LVL_2("gtox"), { b->caps.raw() });
+    auto iter = m_branches.find(b->caps);
+    if (iter == m_branches.end() || iter->second != b) {
+        return;
+    }
+    m_branches.erase(iter);
+
+    //the tee's streaming thread might be pushing into the branch, take
+    //it apart once the pad is idle. runs right away if nothing flows
+    struct removal {
+        std::shared_ptr<branch> b;
+        Glib::RefPtr<Gst::Element> tee;
+        Glib::RefPtr<Gst::Pipeline> pipeline;
+        std::atomic<bool> done{false};
+    };
+    auto r = new removal;
+    r->b = b;
+    r->tee = m_tee;
+    r->pipeline = m_pipeline;
+    gst_pad_add_probe(b->tee_pad->gobj(), GST_PAD_PROBE_TYPE_IDLE,
+                      [](GstPad* pad, GstPadProbeInfo*, gpointer data) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
+        auto r = static_cast<removal*>(data);
+        if (r->done.exchange(true)) {
+            return GST_PAD_PROBE_REMOVE;
+        }
+        auto b = r->b;
+        gst_pad_unlink(pad, b->elements.front()->get_static_pad("sink")->gobj());
+        gst_element_release_request_pad(r->tee->gobj(), pad);
+        for (auto& element : b->elements) {
+            element->set_state(Gst::STATE_NULL);
+            r->pipeline->remove(element);
+        }
+        b->elements.clear();
+        b->tee_pad.reset();
+        return GST_PAD_PROBE_REMOVE;
+    }, r, [](gpointer data) {
+        delete static_cast<removal*>(data);
+    });
+}
+
+webcam_capture::subscription::~subscription() {
+    if (m_capture) {
+        m_capture->unsubscribe(this);
+    }
+}
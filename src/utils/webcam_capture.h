@@ -0,0 +1,117 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef GTOX_WEBCAM_CAPTURE_H
+#define GTOX_WEBCAM_CAPTURE_H
+
+#include <glibmm.h>
+#include <gstreamermm/pipeline.h>
+#include <gstreamermm/appsink.h>
+#include <gstreamermm/pad.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <vector>
+#include "utils/debug.h"
+
+namespace utils {
+    /**
+     * @brief One capture pipeline per webcam device, shared by all consumers.
+     *
+     * The device source feeds a tee. Every distinct caps string gets its
+     * own branch (queue, videorate, videoconvert, videoscale, appsink), consumers
+     * asking for the same caps share it. Queues are leaky, a slow
+     * consumer loses frames without stalling the others. A branch is
+     * removed again when its last subscription is released, the pipeline
+     * stops when the capture's last subscription is gone.
+     */
+    class webcam_capture: public std::enable_shared_from_this<webcam_capture>,
+                          public debug::track_obj<webcam_capture> {
+        public:
+            class subscription;
+            using handle = std::shared_ptr<subscription>;
+
+            /**
+             * called on the streaming thread, captured is the time the
+             * device took the frame, comparable to g_get_monotonic_time()
+             */
+            using slot_sample = std::function<void(GstSample* sample, int width, int height, gint64 captured)>;
+            using type_signal_error = sigc::signal<void, Glib::ustring>;
+            using type_signal_eos   = sigc::signal<void>;
+
+            //! the running capture of the device, or a new one
+            static std::shared_ptr<webcam_capture> get(const std::shared_ptr<GstDevice>& device);
+
+            /**
+             * @brief receive frames converted to caps, until the handle
+             * is released
+             */
+            handle subscribe(const Glib::ustring& caps, slot_sample slot);
+
+            auto signal_error() -> type_signal_error;
+            auto signal_eos()   -> type_signal_eos;
+
+            ~webcam_capture();
+            webcam_capture(const webcam_capture&) = delete;
+            void operator=(const webcam_capture&) = delete;
+
+        private:
+            struct branch {
+                Glib::ustring caps;
+                Glib::RefPtr<Gst::Pad> tee_pad;
+                //queue first, sink last
+                std::vector<Glib::RefPtr<Gst::Element>> elements;
+                Glib::RefPtr<Gst::AppSink> sink;
+                std::vector<subscription*> subscribers;
+            };
+
+            std::shared_ptr<GstDevice> m_device;
+            Glib::RefPtr<Gst::Pipeline> m_pipeline;
+            Glib::RefPtr<Gst::Element>  m_tee;
+            guint m_bus_watch = 0;
+            bool m_started = false;
+
+            //guards the subscribers, taken by the streaming threads
+            std::mutex m_mutex;
+            std::map<Glib::ustring, std::shared_ptr<branch>> m_branches;
+
+            type_signal_error m_signal_error;
+            type_signal_eos   m_signal_eos;
+
+            webcam_capture(std::shared_ptr<GstDevice> device);
+            void init();
+
+            std::shared_ptr<branch> get_branch(const Glib::ustring& caps);
+            void remove_branch(const std::shared_ptr<branch>& b);
+            void deliver(branch* b, Glib::RefPtr<Gst::Sample> sample);
+            void unsubscribe(subscription* s);
+    };
+
+    class webcam_capture::subscription {
+            friend class webcam_capture;
+        public:
+            ~subscription();
+
+        private:
+            std::shared_ptr<webcam_capture> m_capture;
+            std::shared_ptr<branch> m_branch;
+            slot_sample m_slot;
+    };
+}
+#endif
@@ -0,0 +1,102 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#include "worker_pool.h"
+#include "debug.h"
+#include <algorithm>
+
+using namespace utils;
+
+worker_pool::worker_pool(unsigned threads) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { int(threads) });
+    threads = std::max(threads, 1u);
+    for (unsigned i = 0; i < threads; ++i) {
+        m_threads.emplace_back([this]() {
+            run();
+        });
+    }
+}
+
+worker_pool::~worker_pool() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_stop = true;
+        m_jobs.clear();
+    }
+    m_cond.notify_all();
+    for (auto& t : m_threads) {
+        t.join();
+    }
+}
+
+worker_pool::handle worker_pool::push(std::function<void()> func, bool urgent) {
+    utils::debug::scope_log log(DBG_LVL_3("gtox"), {});
+    auto j = std::make_shared<job>();
+    j->m_func = std::move(func);
+    j->m_urgent = urgent;
+    j->m_canceled = false;
+    {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_jobs.push_back(j);
+    }
+    m_cond.notify_one();
+    return j;
+}
+
+void worker_pool::prioritize(const handle& job) {
+    if (job) {
+        job->m_urgent = true;
+    }
+}
+
+void worker_pool::cancel(const handle& job) {
+    if (job) {
+        job->m_canceled = true;
+    }
+}
+
+void worker_pool::run() {
+    while (true) {
+        handle j;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() {
+                return m_stop || !m_jobs.empty();
+            });
+            if (m_stop) {
+                return;
+            }
+            //urgent first, else the oldest
+            auto iter = std::find_if(m_jobs.begin(), m_jobs.end(), [](const handle& h) {
+                return h->m_urgent.load();
+            });
+            if (iter == m_jobs.end()) {
+                iter = m_jobs.begin();
+            }
+            j = *iter;
+            m_jobs.erase(iter);
+        }
+        if (j->m_canceled) {
+            continue;
+        }
+        j->m_func();
+        //release captures on the worker
+        j->m_func = nullptr;
+    }
+}
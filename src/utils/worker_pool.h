@@ -0,0 +1,75 @@
+/**
+    gTox a GTK-based tox-client - https://github.com/KoKuToru/gTox.git
+
+    Copyright (C) 2015  Luca Béla Palkovics
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+**/
+#ifndef H_GTOX_WORKER_POOL
+#define H_GTOX_WORKER_POOL
+
+#include <functional>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace utils {
+    /**
+     * @brief Fixed number of threads working on one shared job queue.
+     *
+     * Urgent jobs run before all others, otherwise first in first out.
+     * Jobs that didn't start yet when the pool is destroyed are dropped.
+     */
+    class worker_pool {
+        public:
+            class job;
+            using handle = std::shared_ptr<job>;
+
+            worker_pool(unsigned threads);
+            ~worker_pool();
+            worker_pool(const worker_pool&) = delete;
+            void operator=(const worker_pool&) = delete;
+
+            handle push(std::function<void()> func, bool urgent = false);
+
+            //! moves a queued job in front of the normal ones
+            static void prioritize(const handle& job);
+
+            //! drops the job if it didn't start yet
+            static void cancel(const handle& job);
+
+        private:
+            std::mutex m_mutex;
+            std::condition_variable m_cond;
+            std::deque<handle> m_jobs;
+            std::vector<std::thread> m_threads;
+            bool m_stop = false;
+
+            void run();
+    };
+
+    class worker_pool::job {
+            friend class worker_pool;
+        private:
+            std::function<void()> m_func;
+            std::atomic<bool> m_urgent;
+            std::atomic<bool> m_canceled;
+    };
+}
+
+#endif
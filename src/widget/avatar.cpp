@@ -20,9 +20,166 @@
 #include "avatar.h"
 #include <iostream>
 #include <mutex>
+#include <list>
+#include <map>
+#include <cstdio>
+#include <glib/gstdio.h>
 
 using namespace widget;
 
+namespace {
+    const int avatar_size = 128;
+
+    /**
+     * Decoded avatars by content hash and size, shared by all
+     * avatar::image instances. Least recently used entries are dropped
+     * once the pixel data exceeds max_bytes.
+     */
+    class pixbuf_cache {
+        public:
+            static const size_t max_bytes = 16 * 1024 * 1024;
+
+            static pixbuf_cache& instance() {
+                static pixbuf_cache cache;
+                return cache;
+            }
+
+            Glib::RefPtr<Gdk::Pixbuf> get(const std::string& hash, int size) {
+                std::lock_guard<std::mutex> lg(m_mutex);
+                auto iter = m_index.find({hash, size});
+                if (iter == m_index.end()) {
+                    return {};
+                }
+                m_lru.splice(m_lru.begin(), m_lru, iter->second);
+                return iter->second->pix;
+            }
+
+            void put(const std::string& hash, int size, Glib::RefPtr<Gdk::Pixbuf> pix) {
+                std::lock_guard<std::mutex> lg(m_mutex);
+                key k{hash, size};
+                if (m_index.find(k) != m_index.end()) {
+                    return;
+                }
+                size_t bytes = size_t(pix->get_rowstride()) * pix->get_height();
+                m_lru.push_front({k, pix, bytes});
+                m_index[k] = m_lru.begin();
+                m_bytes += bytes;
+                while (m_bytes > max_bytes && m_lru.size() > 1) {
+                    m_bytes -= m_lru.back().bytes;
+                    m_index.erase(m_lru.back().k);
+                    m_lru.pop_back();
+                }
+            }
+
+        private:
+            using key = std::pair<std::string, int>;
+            struct entry {
+                key k;
+                Glib::RefPtr<Gdk::Pixbuf> pix;
+                size_t bytes;
+            };
+            std::mutex m_mutex;
+            std::list<entry> m_lru; //most recent first
+            std::map<key, std::list<entry>::iterator> m_index;
+            size_t m_bytes = 0;
+    };
+
+    utils::worker_pool& decode_pool() {
+        static utils::worker_pool pool(std::min(2u, std::max(1u, std::thread::hardware_concurrency())));
+        return pool;
+    }
+
+    //scaled and center cropped to size x size
+    Glib::RefPtr<Gdk::Pixbuf> decode_avatar(const std::string& path, int size) {
+        utils::debug::scope_log log(DBG_LVL_2("gtox"), { path, size });
+        std::string content;
+        try {
+            content = Glib::file_get_contents(path);
+        } catch (...) {
+            return {};
+        }
+
+        //the file name stays the same when a contact changes the avatar
+        auto hash = Glib::Checksum::compute_checksum(Glib::Checksum::CHECKSUM_SHA256, content);
+        auto& cache = pixbuf_cache::instance();
+        auto pix = cache.get(hash, size);
+        if (pix) {
+            return pix;
+        }
+
+        //thumbnail from a previous run
+        auto thumb_dir = Glib::build_filename(Glib::get_user_cache_dir(), "gtox", "avatars");
+        auto thumb = Glib::build_filename(thumb_dir, hash + "-" + std::to_string(size) + ".png");
+        if (Glib::file_test(thumb, Glib::FILE_TEST_IS_REGULAR)) {
+            try {
+                pix = Gdk::Pixbuf::create_from_file(thumb);
+                if (pix->get_width() != size || pix->get_height() != size) {
+                    pix.reset();
+                }
+            } catch (...) {
+                pix.reset();
+            }
+        }
+
+        if (!pix) {
+            try {
+                auto loader = Gdk::PixbufLoader::create();
+                //let the decoder downscale big images
+                loader->signal_size_prepared().connect([&](int w, int h) {
+                    int m = std::min(w, h);
+                    if (m > size) {
+                        loader->set_size(std::max(size, w * size / m),
+                                         std::max(size, h * size / m));
+                    }
+                });
+                loader->write((const guint8*)content.data(), content.size());
+                loader->close();
+                pix = loader->get_pixbuf();
+            } catch (...) {
+                //couldn't load it
+                return {};
+            }
+            if (!pix) {
+                return {};
+            }
+
+            //scale
+            int w = pix->get_width();
+            int h = pix->get_height();
+            if (w < h) {
+                h = h * size / w;
+                w = size;
+            } else {
+                w = w * size / h;
+                h = size;
+            }
+            if (w != pix->get_width() || h != pix->get_height()) {
+                pix = pix->scale_simple(w, h, Gdk::INTERP_BILINEAR);
+            }
+
+            //crop, copy so the full image can be freed
+            int src_x = pix->get_width()/2 - size/2;
+            int src_y = pix->get_height()/2 - size/2;
+            pix = Gdk::Pixbuf::create_subpixbuf(pix, src_x, src_y, size, size)->copy();
+
+            //write to a temporary file first, another run might read it
+            try {
+                g_mkdir_with_parents(thumb_dir.c_str(), 0700);
+                auto tmp = thumb + ".tmp";
+                pix->save(tmp, "png");
+                if (g_rename(tmp.c_str(), thumb.c_str()) != 0) {
+                    g_remove(tmp.c_str());
+                }
+            } catch (...) {
+                //cache is optional
+            }
+        }
+
+        cache.put(hash, size, pix);
+        return pix;
+    }
+}
+
 Glib::PropertyProxy<Glib::RefPtr<Gdk::Pixbuf>> avatar::image::property_pixbuf() {
     return m_property_pixbuf.get_proxy();
 }
@@ -58,56 +215,52 @@ avatar::image::image(toxmm::contactAddrPublic addr):
     load();
 }
 
+avatar::image::~image() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    utils::worker_pool::cancel(m_job);
+}
+
+void avatar::image::prioritize() {
+    utils::debug::scope_log log(DBG_LVL_3("gtox"), {});
+    utils::worker_pool::prioritize(m_job);
+}
+
 void avatar::image::load() {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
-    property_pixbuf() =
-            Gdk::Pixbuf::create_from_resource("/org/gtox/icon/avatar.svg");
+    static auto fallback = Gdk::Pixbuf::create_from_resource("/org/gtox/icon/avatar.svg");
+
+    utils::worker_pool::cancel(m_job);
+    m_job.reset();
+    auto version = ++m_version;
+
     if (!m_file->query_exists()) {
+        property_pixbuf() = fallback;
         return;
     }
+    //keep the old avatar until the new one is decoded
+    if (!property_pixbuf().get_value()) {
+        property_pixbuf() = fallback;
+    }
+
     //load async
     utils::dispatcher::ref dispatcher(m_dispatcher); //take a reference
-    auto file = m_file;
-    auto version = ++m_version;
+    auto path = m_file->get_path();
     auto self = this;
-    Glib::Thread::create([dispatcher, file, self, version](){
+    auto key = m_decoded_key;
+    m_job = decode_pool().push([dispatcher, path, self, version, key](){
         utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
-        static std::mutex mutex;
-        std::lock_guard<std::mutex> lg(mutex); //limit parallel load
-
-        //todo try to read w/h first. And block too big dimensions !
-        Glib::RefPtr<Gdk::Pixbuf> pix;
-        try {
-            pix = Gdk::Pixbuf::create_from_file(file->get_path());
-        } catch (...) {
-            //couldn't load it
+        auto pix = decode_avatar(path, avatar_size);
+        if (!pix) {
             return;
         }
-
-        //scale to 128x128
-        int w = pix->get_width();
-        int h = pix->get_height();
-        if (w < h) {
-            h = h * 128 / w;
-            w = 128;
-        } else {
-            w = w * 128 / h;
-            h = 128;
-        }
-        pix = pix->scale_simple(w, h ,Gdk::INTERP_BILINEAR);
-
-        //crop
-        int src_x = pix->get_width()/2 - 128/2;
-        int src_y = pix->get_height()/2 - 128/2;
-        pix = Gdk::Pixbuf::create_subpixbuf(pix, src_x, src_y, 128, 128);
-
-        dispatcher.emit([pix, self, version]() {
+        dispatcher.emit(key, [pix, self, version]() {
             utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
             if (version == self->m_version) {
                 self->property_pixbuf() = pix;
+                self->m_job.reset();
             }
         });
-    }, false);
+    });
 }
 
 avatar::avatar(BaseObjectType* cobject,
@@ -115,30 +268,64 @@ avatar::avatar(BaseObjectType* cobject,
                toxmm::contactAddrPublic addr)
     : Gtk::Image(cobject) {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), { std::string(addr) });
+    init();
     load(addr);
 }
 
+avatar::avatar() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    init();
+}
+
 avatar::avatar(toxmm::contactAddrPublic addr) {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), { std::string(addr) });
+    init();
     load(addr);
 }
 
+void avatar::init() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    property_pixbuf().signal_changed().connect(sigc::track_obj([this]() {
+        invalidate_surface();
+    }, *this));
+}
+
 void avatar::load(toxmm::contactAddrPublic addr) {
-    //load image
-    static std::map<toxmm::contactAddrPublic, std::shared_ptr<image>> m_image;
-    auto iter = m_image.find(addr);
-    if (iter == m_image.end()) {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { std::string(addr) });
+    //one image per contact, alive as long as an avatar shows it
+    static std::map<toxmm::contactAddrPublic, std::weak_ptr<image>> images;
+    static size_t sweep_at = 64;
+    auto& weak = images[addr];
+    auto img = weak.lock();
+    if (!img) {
         //create new
-        iter = m_image.insert({addr, std::make_shared<image>(addr)}).first;
+        img = std::make_shared<image>(addr);
+        weak = img;
+    }
+    if (images.size() >= sweep_at) {
+        for (auto iter = images.begin(); iter != images.end();) {
+            if (iter->second.expired()) {
+                iter = images.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+        sweep_at = std::max(size_t(64), images.size() * 2);
     }
 
+    m_binding.reset();
+    m_image = img;
     m_binding = Glib::Binding::bind_property(
-                    iter->second->property_pixbuf(),
+                    m_image->property_pixbuf(),
                     property_pixbuf(),
                     Glib::BINDING_DEFAULT |
                     Glib::BINDING_SYNC_CREATE |
                     Glib::BINDING_BIDIRECTIONAL);
 
+    if (get_mapped()) {
+        m_image->prioritize();
+    }
+
     show();
 }
 
@@ -148,43 +335,96 @@ avatar::~avatar() {
 
 bool avatar::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
     utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-    Glib::RefPtr<Gtk::StyleContext> style = get_style_context();
-
     int w = get_allocated_width();
     int h = get_allocated_height();
+    int scale = get_scale_factor();
+
+    //only allocate when the size changes
+    if (!m_surface ||
+            m_surface->get_width()  != w * scale ||
+            m_surface->get_height() != h * scale) {
+        m_surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, w * scale, h * scale);
+        m_surface_cr = Cairo::Context::create(m_surface);
+        m_surface_dirty = true;
+    }
+    if (m_surface_dirty) {
+        m_surface_dirty = false;
+        render_surface(w, h, scale);
+    }
 
-    auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, w * get_scale_factor(), h * get_scale_factor());
-    auto tmp_cr = Cairo::Context::create(surface);
-    tmp_cr->scale(get_scale_factor(), get_scale_factor());
+    // Render to the right surface
+    cr->save();
+    cr->scale(1.0/scale, 1.0/scale);
+    cr->set_source(m_surface, 0, 0);
+    cr->paint();
+    cr->restore();
+
+    return false;
+}
+
+void avatar::render_surface(int w, int h, int scale_factor) {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    Glib::RefPtr<Gtk::StyleContext> style = get_style_context();
+
+    auto& cr = m_surface_cr;
+    cr->save();
+
+    // Clear the previous content
+    cr->set_operator(Cairo::OPERATOR_CLEAR);
+    cr->paint();
+    cr->set_operator(Cairo::OPERATOR_OVER);
+
+    cr->scale(scale_factor, scale_factor);
 
     // Render image
     Glib::RefPtr<Gdk::Pixbuf> pix = property_pixbuf();
     if (pix) {
-        tmp_cr->save();
+        cr->save();
         double pw = pix->get_width();
         double ph = pix->get_height();
-        tmp_cr->scale(w/pw, h/ph);
-        Gdk::Cairo::set_source_pixbuf(tmp_cr, pix);
-        tmp_cr->paint();
-        tmp_cr->restore();
+        cr->scale(w/pw, h/ph);
+        cr->set_source(m_pixbuf_surface.get(pix), 0, 0);
+        cr->paint();
+        cr->restore();
     }
 
     // Render the background
-    tmp_cr->set_operator(Cairo::OPERATOR_DEST_ATOP);
-    style->render_background(tmp_cr, 0, 0, w, h);
+    cr->set_operator(Cairo::OPERATOR_DEST_ATOP);
+    style->render_background(cr, 0, 0, w, h);
 
     // Change to default operator
-    tmp_cr->set_operator(Cairo::OPERATOR_OVER);
+    cr->set_operator(Cairo::OPERATOR_OVER);
 
     // Render frame
-    style->render_frame(tmp_cr, 0, 0, w, h);
+    style->render_frame(cr, 0, 0, w, h);
 
-    // Render to the right surface
-    cr->scale(1.0/get_scale_factor(), 1.0/get_scale_factor());
-    cr->set_source(surface, 0, 0);
-    cr->paint();
+    cr->restore();
+}
 
-    return false;
+void avatar::invalidate_surface() {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+    m_surface_dirty = true;
+    queue_draw();
+}
+
+void avatar::on_style_updated() {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    Gtk::Image::on_style_updated();
+    invalidate_surface();
+}
+
+void avatar::on_state_flags_changed(Gtk::StateFlags previous_state_flags) {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    Gtk::Image::on_state_flags_changed(previous_state_flags);
+    invalidate_surface();
+}
+
+void avatar::on_map() {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    Gtk::Image::on_map();
+    if (m_image) {
+        m_image->prioritize();
+    }
 }
 
 Gtk::SizeRequestMode avatar::get_request_mode_vfunc() const {
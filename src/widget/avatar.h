@@ -23,13 +23,15 @@
 #include <gtkmm.h>
 #include "utils/builder.h"
 #include "utils/dispatcher.h"
+#include "utils/worker_pool.h"
 #include "tox/types.h"
 #include "utils/debug.h"
+#include "utils/pixbuf_surface.h"
 
 namespace widget {
     class avatar : public Gtk::Image, public utils::debug::track_obj<avatar> {
         public:
-            avatar() {}
+            avatar();
             avatar(toxmm::contactAddrPublic addr);
             avatar(BaseObjectType* cobject,
                    utils::builder,
@@ -41,6 +43,9 @@ namespace widget {
 
         protected:
             bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr) override;
+            void on_style_updated() override;
+            void on_state_flags_changed(Gtk::StateFlags previous_state_flags) override;
+            void on_map() override;
             Gtk::SizeRequestMode get_request_mode_vfunc() const override;
             void get_preferred_width_vfunc(int& minimum_width,
                                            int& natural_width) const override;
@@ -53,6 +58,10 @@ namespace widget {
                     Glib::PropertyProxy<Glib::RefPtr<Gdk::Pixbuf>> property_pixbuf();
 
                     image(toxmm::contactAddrPublic addr);
+                    ~image();
+
+                    //! decode before the avatars that are not on screen
+                    void prioritize();
 
                 private:
                     Glib::Property<Glib::RefPtr<Gdk::Pixbuf>> m_property_pixbuf;
@@ -60,12 +69,27 @@ namespace widget {
                     Glib::RefPtr<Gio::File> m_file;
                     Glib::RefPtr<Gio::FileMonitor> m_monitor;
                     utils::dispatcher m_dispatcher;
+                    //only the newest decode gets applied
+                    utils::dispatch_queue::key m_decoded_key;
                     int m_version = 0;
+                    utils::worker_pool::handle m_job;
 
                     void load();
             };
 
+            std::shared_ptr<image> m_image;
             Glib::RefPtr<Glib::Binding> m_binding;
+
+            //pre-rendered image, background and frame
+            Cairo::RefPtr<Cairo::ImageSurface> m_surface;
+            Cairo::RefPtr<Cairo::Context> m_surface_cr;
+            bool m_surface_dirty = true;
+            //the pixbuf converted for cairo, reused for same sized frames
+            utils::pixbuf_surface m_pixbuf_surface;
+
+            void render_surface(int w, int h, int scale_factor);
+            void invalidate_surface();
+            void init();
     };
 }
 #endif
@@ -47,7 +47,8 @@ void chat_bubble::init(utils::builder builder) {
         utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
         auto w = std::min(64, allocation.get_height() - 5); //5px radius
         if (w != m_avatar->get_width()) {
-            m_dispatcher.emit([this, w]() {
+            //allocations come in bursts, only the last size matters
+            m_dispatcher.emit(m_avatar_size_key, [this, w]() {
                 m_avatar->set_size_request(w, w);
             });
         }
@@ -120,14 +121,45 @@ chat_bubble::chat_bubble(BaseObjectType* cobject,
                                                   sigc::track_obj(transform_text,
                                                                   *this));
 
-    Glib::signal_timeout().connect_seconds(sigc::track_obj([this, username, transform_text]() {
+    m_update_timestamp = [this, username, transform_text]() {
         utils::debug::scope_log log(DBG_LVL_2("gtox"), {});
         Glib::ustring input = username;
         Glib::ustring output;
         transform_text(input, output);
         m_username->property_label() = output;
+        m_timestamp_stale = false;
+    };
+
+    //bubbles out of view only get marked, the chat refreshes
+    //the stale ones it scrolls into view
+    m_timestamp = utils::timestamp_ticker::add(time, [this]() {
+        if (in_view()) {
+            m_update_timestamp();
+        } else {
+            m_timestamp_stale = true;
+        }
+    });
+    signal_map().connect(sigc::track_obj([this]() {
+        if (m_timestamp_stale && in_view()) {
+            m_update_timestamp();
+        }
+    }, *this));
+}
+
+bool chat_bubble::in_view() {
+    if (!get_mapped()) {
+        return false;
+    }
+    auto scrolled = get_ancestor(GTK_TYPE_SCROLLED_WINDOW);
+    if (!scrolled) {
         return true;
-    },*this), 60);
+    }
+    //follows the scroll offset of the viewport
+    int x, y;
+    if (!translate_coordinates(*scrolled, 0, 0, x, y)) {
+        return false;
+    }
+    return y + get_allocated_height() > 0 && y < scrolled->get_allocated_height();
 }
 
 chat_bubble::~chat_bubble() {
@@ -164,3 +196,12 @@ void chat_bubble::add_row(Gtk::Widget& widget) {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
     m_row_box->add(widget);
 }
+
+bool chat_bubble::timestamp_stale() const {
+    return m_timestamp_stale;
+}
+
+void chat_bubble::refresh_timestamp() {
+    utils::debug::scope_log log(DBG_LVL_3("gtox"), {});
+    m_update_timestamp();
+}
@@ -24,12 +24,14 @@
 #include "utils/dispatcher.h"
 #include "tox/types.h"
 #include "utils/debug.h"
+#include "utils/timestamp_ticker.h"
 
 namespace widget {
     class avatar;
     class chat_bubble: public Gtk::Revealer, public utils::debug::track_obj<chat_bubble> {
         private:
             utils::dispatcher m_dispatcher;
+            utils::dispatch_queue::key m_avatar_size_key;
 
             avatar*     m_avatar;
             Gtk::Box*   m_row_box;
@@ -38,8 +40,15 @@ namespace widget {
 
             Glib::RefPtr<Glib::Binding> m_binding_name;
 
+            std::function<void()> m_update_timestamp;
+            utils::timestamp_ticker::handle m_timestamp;
+            bool m_timestamp_stale = false;
+
             void init(utils::builder builder);
 
+            //! inside the visible part of the scrolled history
+            bool in_view();
+
         public:
             chat_bubble(BaseObjectType* cobject,
                         utils::builder builder,
@@ -50,6 +59,10 @@ namespace widget {
 
             void add_row(Gtk::Widget& widget);
 
+            //! the timestamp changed while out of view
+            bool timestamp_stale() const;
+            void refresh_timestamp();
+
             static utils::builder::ref<chat_bubble> create(std::shared_ptr<toxmm::core> core, Glib::DateTime time);
             static utils::builder::ref<chat_bubble> create(std::shared_ptr<toxmm::contact> contact, Glib::DateTime time);
     };
@@ -29,19 +29,18 @@
 
 namespace dialog {
     class main;
-    class chat;
+    class contact_item;
 }
 
 namespace widget {
+    //! row view of a dialog::contact_item
     class contact : public Gtk::ListBoxRow, public utils::debug::track_obj<contact> {
         private:
             dialog::main& m_main;
-            std::shared_ptr<dialog::chat> m_chat;
+            Glib::RefPtr<dialog::contact_item> m_item;
 
             utils::dispatcher m_dispatcher;
 
-            std::shared_ptr<toxmm::contact> m_contact;
-
             widget::avatar* m_avatar;
             widget::avatar* m_avatar_mini;
 
@@ -60,26 +59,23 @@ namespace widget {
 
             Gtk::Revealer* m_revealer;
 
-            Glib::RefPtr<Glib::Binding> m_bindings[7];
+            Glib::RefPtr<Glib::Binding> m_bindings[8];
 
             bool m_for_active_chats;
-            bool m_played_online_sound;
 
         public:
             contact(BaseObjectType* cobject,
                     utils::builder builder,
                     dialog::main& main,
-                    std::shared_ptr<toxmm::contact> contact,
+                    Glib::RefPtr<dialog::contact_item> item,
                     bool for_active_chats=false);
             virtual ~contact();
 
             static utils::builder::ref<contact> create(dialog::main& main,
-                                                       std::shared_ptr<toxmm::contact> contact,
+                                                       Glib::RefPtr<dialog::contact_item> item,
                                                        bool for_active_chats=false);
 
-            //! for sort
-            int compare(contact* other);
-
+            Glib::RefPtr<dialog::contact_item> get_item();
             std::shared_ptr<toxmm::contact> get_contact();
             void activated();
 
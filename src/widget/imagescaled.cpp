@@ -26,6 +26,7 @@ using namespace widget;
 imagescaled::imagescaled():
     Glib::ObjectBase(typeid(imagescaled)) {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    init();
     show();
 }
 
@@ -33,9 +34,18 @@ imagescaled::imagescaled(BaseObjectType* cobject,
                          utils::builder)
     : Gtk::Image(cobject) {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    init();
     show();
 }
 
+void imagescaled::init() {
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
+    //video frames come in as new pixbufs, the surface itself is reused
+    property_pixbuf().signal_changed().connect(sigc::track_obj([this]() {
+        invalidate_surface();
+    }, *this));
+}
+
 imagescaled::~imagescaled() {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), {});
 }
@@ -63,48 +73,92 @@ void imagescaled::calculate_size(int w, int h,
 
 bool imagescaled::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
     utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
-    Glib::RefPtr<Gtk::StyleContext> style = get_style_context();
-
     int w = get_allocated_width();
     int h = get_allocated_height();
+    int scale = get_scale_factor();
+
+    //only allocate when the size changes
+    if (!m_surface ||
+            m_surface->get_width()  != w * scale ||
+            m_surface->get_height() != h * scale) {
+        m_surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, w * scale, h * scale);
+        m_surface_cr = Cairo::Context::create(m_surface);
+        m_surface_dirty = true;
+    }
+    if (m_surface_dirty) {
+        m_surface_dirty = false;
+        render_surface(w, h, scale);
+    }
 
-    auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, w * get_scale_factor(), h * get_scale_factor());
-    auto tmp_cr = Cairo::Context::create(surface);
-    tmp_cr->scale(get_scale_factor(), get_scale_factor());
+    // Render to the right surface
+    cr->save();
+    cr->scale(1.0/scale, 1.0/scale);
+    cr->set_source(m_surface, 0, 0);
+    cr->paint();
+    cr->restore();
+
+    return false;
+}
+
+void imagescaled::render_surface(int w, int h, int scale_factor) {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    Glib::RefPtr<Gtk::StyleContext> style = get_style_context();
+
+    auto& cr = m_surface_cr;
+    cr->save();
+
+    // Clear the previous content
+    cr->set_operator(Cairo::OPERATOR_CLEAR);
+    cr->paint();
+    cr->set_operator(Cairo::OPERATOR_OVER);
+
+    cr->scale(scale_factor, scale_factor);
 
     // Render image
     Glib::RefPtr<Gdk::Pixbuf> pix = property_pixbuf();
     if (pix) {
-        tmp_cr->save();
+        cr->save();
         double pw = 1;
         double ph = 1;
         double scale = 1;
         calculate_size(w, h, pw, ph, scale);
-        tmp_cr->scale(scale, scale);
-        Gdk::Cairo::set_source_pixbuf(tmp_cr,
-                                      pix,
-                                      (w - pw) / scale / 2,
-                                      (h - ph) / scale / 2);
-        tmp_cr->paint();
-        tmp_cr->restore();
+        cr->scale(scale, scale);
+        cr->set_source(m_pixbuf_surface.get(pix),
+                       (w - pw) / scale / 2,
+                       (h - ph) / scale / 2);
+        cr->paint();
+        cr->restore();
     }
 
     // Render the background
-    tmp_cr->set_operator(Cairo::OPERATOR_DEST_ATOP);
-    style->render_background(tmp_cr, 0, 0, w, h);
+    cr->set_operator(Cairo::OPERATOR_DEST_ATOP);
+    style->render_background(cr, 0, 0, w, h);
 
     // Change to default operator
-    tmp_cr->set_operator(Cairo::OPERATOR_OVER);
+    cr->set_operator(Cairo::OPERATOR_OVER);
 
     // Render frame
-    style->render_frame(tmp_cr, 0, 0, w, h);
+    style->render_frame(cr, 0, 0, w, h);
 
-    // Render to the right surface
-    cr->scale(1.0/get_scale_factor(), 1.0/get_scale_factor());
-    cr->set_source(surface, 0, 0);
-    cr->paint();
+    cr->restore();
+}
 
-    return false;
+void imagescaled::invalidate_surface() {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+    m_surface_dirty = true;
+    queue_draw();
+}
+
+void imagescaled::on_style_updated() {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    Gtk::Image::on_style_updated();
+    invalidate_surface();
+}
+
+void imagescaled::on_state_flags_changed(Gtk::StateFlags previous_state_flags) {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    Gtk::Image::on_state_flags_changed(previous_state_flags);
+    invalidate_surface();
 }
 
 Gtk::SizeRequestMode imagescaled::get_request_mode_vfunc() const {
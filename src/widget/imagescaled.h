@@ -24,6 +24,7 @@
 #include "utils/builder.h"
 #include "utils/dispatcher.h"
 #include "utils/debug.h"
+#include "utils/pixbuf_surface.h"
 
 namespace widget {
     class imagescaled : public Gtk::Image, public utils::debug::track_obj<imagescaled> {
@@ -34,12 +35,24 @@ namespace widget {
             ~imagescaled();
 
         private:
+            //pre-rendered image, background and frame
+            Cairo::RefPtr<Cairo::ImageSurface> m_surface;
+            Cairo::RefPtr<Cairo::Context> m_surface_cr;
+            bool m_surface_dirty = true;
+            //the pixbuf converted for cairo, reused for same sized frames
+            utils::pixbuf_surface m_pixbuf_surface;
+
             void calculate_size(int w, int h,
                                 double& out_pw, double& out_ph,
                                 double& out_scale) const;
+            void render_surface(int w, int h, int scale_factor);
+            void invalidate_surface();
+            void init();
 
         protected:
             bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr) override;
+            void on_style_updated() override;
+            void on_state_flags_changed(Gtk::StateFlags previous_state_flags) override;
             Gtk::SizeRequestMode get_request_mode_vfunc() const override;
             void get_preferred_width_vfunc(int& minimum_width,
                                            int& natural_width) const override;
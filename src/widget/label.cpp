@@ -19,7 +19,9 @@
 **/
 #include "label.h"
 #include <pangomm/renderer.h>
+#include <chrono>
 #include <cmath>
+#include <iomanip>
 #include <iostream>
 
 using namespace widget;
@@ -33,14 +35,19 @@ label::label(const Glib::ustring& text)
     // add default name because
     // styling with "gtkmm_CustomObject_WidgetChatMessage" is not nice
 
-    signal_size_allocate().connect_notify([this](Gtk::Allocation&) {
-        // update hightlight
-        gint reg[] = {std::min(selection_index_from, selection_index_to),
-                      std::max(selection_index_from, selection_index_to)};
-        m_clip = Cairo::RefPtr<Cairo::Region>(
-            new Cairo::Region(gdk_pango_layout_get_clip_region(
-                m_text->gobj(), 0, 0, reg, 1)));  // cpp-version ?
-        force_redraw();
+    signal_size_allocate().connect_notify([this](Gtk::Allocation& allocation) {
+        set_layout_width(text_width(allocation.get_width()));
+        // update hightlight, the clip only moves when the lines wrap differently
+        if (m_clip && m_clip_width != m_layout_width) {
+            update_clip();
+            force_redraw();
+        }
+    });
+    signal_style_updated().connect_notify([this]() {
+        invalidate_layout();
+    });
+    property_scale_factor().signal_changed().connect([this]() {
+        invalidate_layout();
     });
 
     set_text(text);
@@ -97,9 +104,7 @@ bool label::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
     }
 
     // draw the text
-    m_text->set_width(
-        Pango::SCALE
-        * (get_allocated_width() - (padding.get_left() + padding.get_right())));
+    set_layout_width(text_width(get_allocated_width()));
     stylecontext->render_layout(cr, 0, 0, m_text);
 
     // draw emojis
@@ -135,89 +140,85 @@ void label::set_text(const Glib::ustring& text) {
     utils::debug::scope_log log(DBG_LVL_1("gtox"), { text.raw() });
     m_text = create_pango_layout("");
     m_text->set_wrap(Pango::WRAP_WORD_CHAR);
-
-    // format text;
-    bool b_open = false;
-    bool i_open = false;
-    bool u_open = false;
-    Glib::ustring markup_text;
-    Glib::ustring tmp;
-    auto begin = text.begin();
-    auto end = text.end();
-    for (; begin < end; begin++) {
-        tmp.clear();
-        if (*begin == gunichar(0xFDD0) || *begin == gunichar(0xFDD1)) {
-            // close tags
-            if (u_open) {
-                markup_text += "</u>";
-            }
-            if (i_open) {
-                markup_text += "</i>";
-            }
-            if (b_open) {
-                markup_text += "</b>";
-            }
-            // check tags
-            if (*begin == gunichar(0xFDD0)) {
-                for (begin++; begin != end; begin++) {
-                    if (*begin == gunichar(0xFDD1)) {
-                        break;
-                    }
-                    tmp += *begin;
-                }
-                if (tmp == "**") {
-                    b_open = true;
-                } else if (tmp == "*") {
-                    i_open = true;
-                } else if (tmp == "_") {
-                    u_open = true;
-                }
-
-            } else if (*begin == gunichar(0xFDD1)) {
-                for (begin++; begin != end; begin++) {
-                    if (*begin == gunichar(0xFDD0)) {
-                        break;
-                    }
-                    tmp += *begin;
-                }
-                if (tmp == "**") {
-                    b_open = false;
-                } else if (tmp == "*") {
-                    i_open = false;
-                } else if (tmp == "_") {
-                    u_open = false;
-                }
-            }
-            // open tags
-            if (b_open) {
-                markup_text += "<b>";
-            }
-            if (i_open) {
-                markup_text += "<i>";
-            }
-            if (u_open) {
-                markup_text += "<u>";
-            }
+    m_layout_width = -1;
+    m_natural_width = -1;
+    m_heights.clear();
+    m_clip_width = -1;
+
+    // format text, 0xFDD0 tag 0xFDD1 opens and 0xFDD1 tag 0xFDD0 closes
+    // a style, the tags become attributes over the plain text in between
+    const std::string& raw = text.raw();
+    std::string plain;
+    plain.reserve(raw.size());
+    Pango::AttrList attributes;
+    // plain text byte index where bold, italic, underline started, -1 if off
+    int open[3] = { -1, -1, -1 };
+    auto close_style = [&](int style) {
+        if (open[style] < 0) {
+            return;
+        }
+        if (open[style] < int(plain.size())) {
+            auto attr = style == 0 ? Pango::Attribute::create_attr_weight(Pango::WEIGHT_BOLD)
+                      : style == 1 ? Pango::Attribute::create_attr_style(Pango::STYLE_ITALIC)
+                      : Pango::Attribute::create_attr_underline(Pango::UNDERLINE_SINGLE);
+            attr.set_start_index(open[style]);
+            attr.set_end_index(plain.size());
+            attributes.insert(attr);
+        }
+        open[style] = -1;
+    };
+    // both markers are EF B7 9x in UTF-8
+    static const std::string marker_lead = "\xEF\xB7";
+    static const std::string marker_open = "\xEF\xB7\x90";
+    static const std::string marker_close = "\xEF\xB7\x91";
+    size_t pos = 0;
+    while (pos < raw.size()) {
+        auto marker = raw.find(marker_lead, pos);
+        while (marker != std::string::npos
+               && (marker + 2 >= raw.size()
+                   || (raw[marker + 2] != '\x90' && raw[marker + 2] != '\x91'))) {
+            marker = raw.find(marker_lead, marker + 1);
+        }
+        if (marker == std::string::npos) {
+            plain.append(raw, pos, std::string::npos);
+            break;
+        }
+        plain.append(raw, pos, marker - pos);
+
+        bool opening = raw[marker + 2] == '\x90';
+        auto tag = marker + 3;
+        auto tag_end = raw.find(opening ? marker_close : marker_open, tag);
+        if (tag_end == std::string::npos) {
+            tag_end = raw.size();
+            pos = raw.size();
         } else {
-            for (; *begin != gunichar(0xFDD0) && *begin != gunichar(0xFDD1)
-                   && begin < end;
-                 begin++) {
-                tmp += *begin;
-            }
-            markup_text += Glib::Markup::escape_text(tmp);
-            begin--;  // otherwise next loop 1 character skipped
+            pos = tag_end + 3;
+        }
+        int style = -1;
+        if (raw.compare(tag, tag_end - tag, "**") == 0) {
+            style = 0;
+        } else if (raw.compare(tag, tag_end - tag, "*") == 0) {
+            style = 1;
+        } else if (raw.compare(tag, tag_end - tag, "_") == 0) {
+            style = 2;
+        }
+        if (style < 0) {
+            continue;
+        }
+        if (!opening) {
+            close_style(style);
+        } else if (open[style] < 0) {
+            open[style] = plain.size();
         }
     }
-    if (b_open) {
-        markup_text += "</b>";
-    }
-    if (i_open) {
-        markup_text += "</i>";
+    for (int style = 0; style < 3; ++style) {
+        close_style(style);
     }
-    if (u_open) {
-        markup_text += "</u>";
+    m_text->set_text(plain);
+    m_text->set_attributes(attributes);
+    if (m_clip) {
+        update_clip();
     }
-    m_text->set_markup(markup_text);
 
     // add emojis
     /*auto attr_list = Pango::AttrList();
@@ -235,6 +236,64 @@ void label::set_text(const Glib::ustring& text) {
     queue_resize();
 }
 
+void label::set_layout_width(int width) const {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), { width });
+    if (width == m_layout_width) {
+        return;
+    }
+    m_layout_width = width;
+    m_text->set_width(width);
+}
+
+int label::text_width(int allocated_width) const {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), { allocated_width });
+    auto padding = get_style_context()->get_padding();
+    return Pango::SCALE
+           * (allocated_width - (padding.get_left() + padding.get_right()));
+}
+
+int label::height_for_width(int width) const {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), { width });
+    for (auto& h : m_heights) {
+        if (h.first == width) {
+            return h.second;
+        }
+    }
+    set_layout_width(width);
+    int w, h;
+    m_text->get_pixel_size(w, h);
+    //gtk asks for a few widths in turn while allocating
+    if (m_heights.size() == 4) {
+        m_heights.erase(m_heights.begin());
+    }
+    m_heights.emplace_back(width, h);
+    return h;
+}
+
+void label::invalidate_layout() {
+    utils::debug::scope_log log(DBG_LVL_4("gtox"), {});
+    if (!m_text) {
+        return;
+    }
+    m_text->context_changed();
+    m_natural_width = -1;
+    m_heights.clear();
+    if (m_clip) {
+        update_clip();
+    }
+    queue_resize();
+}
+
+void label::update_clip() {
+    utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
+    gint reg[] = {std::min(selection_index_from, selection_index_to),
+                  std::max(selection_index_from, selection_index_to)};
+    m_clip = Cairo::RefPtr<Cairo::Region>(
+        new Cairo::Region(gdk_pango_layout_get_clip_region(
+            m_text->gobj(), 0, 0, reg, 1)));  // cpp-version ?
+    m_clip_width = m_layout_width;
+}
+
 void label::force_redraw() {
     utils::debug::scope_log log(DBG_LVL_5("gtox"), {});
     Glib::RefPtr<Gdk::Window> win = get_window();
@@ -254,9 +313,14 @@ void label::get_preferred_width_vfunc(int& minimum_width,
     Glib::RefPtr<Gtk::StyleContext> stylecontext = get_style_context();
     auto padding = stylecontext->get_padding();
 
-    m_text->set_width(-1);
-    int height;
-    m_text->get_pixel_size(natural_width, height);
+    if (m_natural_width < 0) {
+        //measure on a copy, unwrapping ours would throw its lines away
+        auto unwrapped = m_text->copy();
+        unwrapped->set_width(-1);
+        int height;
+        unwrapped->get_pixel_size(m_natural_width, height);
+    }
+    natural_width = m_natural_width;
     minimum_width = 0;
 
     minimum_width += padding.get_left() + padding.get_right();
@@ -271,9 +335,7 @@ void label::get_preferred_height_for_width_vfunc(
     Glib::RefPtr<Gtk::StyleContext> stylecontext = get_style_context();
     auto padding = stylecontext->get_padding();
 
-    m_text->set_width(Pango::SCALE
-                      * (width - (padding.get_left() + padding.get_right())));
-    m_text->get_pixel_size(width, minimum_height);
+    minimum_height = height_for_width(text_width(width));
     natural_height = minimum_height;
 
     minimum_height += padding.get_top() + padding.get_bottom();
@@ -286,11 +348,7 @@ void label::get_preferred_height_vfunc(int& minimum_height,
     Glib::RefPtr<Gtk::StyleContext> stylecontext = get_style_context();
     auto padding = stylecontext->get_padding();
 
-    m_text->set_width(
-        Pango::SCALE
-        * (get_allocated_width() - (padding.get_left() + padding.get_right())));
-    int width;
-    m_text->get_pixel_size(width, natural_height);
+    natural_height = height_for_width(text_width(get_allocated_width()));
     minimum_height = 0;
 
     minimum_height += padding.get_top() + padding.get_bottom();
@@ -317,9 +375,7 @@ void label::on_selection(int from_x, int from_y, int to_x, int to_y) {
     Glib::RefPtr<Gtk::StyleContext> stylecontext = get_style_context();
     auto padding = stylecontext->get_padding();
 
-    m_text->set_width(
-        Pango::SCALE
-        * (get_allocated_width() - (padding.get_left() + padding.get_right())));
+    set_layout_width(text_width(get_allocated_width()));
 
     // fix coordiantes because of padding
     from_x -= padding.get_left();
@@ -340,6 +396,8 @@ void label::on_selection(int from_x, int from_y, int to_x, int to_y) {
     }
 
     // get the selection
+    int old_from = selection_index_from;
+    int old_to = selection_index_to;
     int trailing;
     m_text->xy_to_index(from_x * Pango::SCALE,
                         from_y * Pango::SCALE,
@@ -359,9 +417,12 @@ void label::on_selection(int from_x, int from_y, int to_x, int to_y) {
                   std::max(selection_index_from, selection_index_to)};
     selection_index_from = reg[0];
     selection_index_to = reg[1];
-    m_clip = Cairo::RefPtr<Cairo::Region>(
-        new Cairo::Region(gdk_pango_layout_get_clip_region(
-            m_text->gobj(), 0, 0, reg, 1)));  // cpp-version ?
+    if (m_clip && old_from == reg[0] && old_to == reg[1]
+            && m_clip_width == m_layout_width) {
+        // same selection as before
+        return;
+    }
+    update_clip();
     force_redraw();
 }
 
@@ -374,3 +435,42 @@ Glib::ustring label::get_selection() {
     return std::string(m_text->get_text()).substr(
         selection_index_from, selection_index_to - selection_index_from);
 }
+
+void label::benchmark() {
+    static auto env_messages = std::stoi("0" + Glib::getenv("GTOX_DBG_LABEL_BENCH"));
+    if (env_messages <= 0) {
+        return;
+    }
+    utils::debug::scope_log log(DBG_LVL_1("gtox"), { env_messages });
+
+    const Glib::ustring tag_open(1, gunichar(0xFDD0));
+    const Glib::ustring tag_close(1, gunichar(0xFDD1));
+    auto style = [&](const Glib::ustring& tag, const Glib::ustring& text) {
+        return tag_open + tag + tag_close + text + tag_close + tag + tag_open;
+    };
+    std::vector<Glib::ustring> messages {
+        "ok",
+        "see you tomorrow :)",
+        "did you read <https://github.com/KoKuToru/gTox.git> & the issues?",
+        "that is " + style("**", "really") + " important, " + style("_", "read it"),
+        style("*", "sighs") + " fine, Grüße aus München",
+        "long message, " + style("**", "bold " + style("*", "and italic") + " text")
+            + " in the middle of a line that is going to wrap at least once or twice"
+            + " when the chat window isn't very wide",
+    };
+
+    label l("");
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < env_messages; ++i) {
+        auto& message = messages[i % messages.size()];
+        l.set_text(message);
+        bytes += message.bytes();
+    }
+    std::chrono::duration<double, std::micro> took = std::chrono::steady_clock::now() - start;
+    std::clog << std::fixed << std::setprecision(2)
+              << "LABEL-BENCH: " << env_messages << " messages"
+              << " avg " << took.count() / env_messages << " us"
+              << " " << bytes / took.count() << " MB/s"
+              << std::endl;
+}
@@ -21,6 +21,7 @@
 #define WIDGETCHATMESSAGE_H
 
 #include <gtkmm.h>
+#include <vector>
 #include "utils/debug.h"
 
 namespace widget {
@@ -32,7 +33,23 @@ namespace widget {
             int selection_index_from;
             int selection_index_to;
 
+            //the layout keeps its lines until text, width or font change,
+            //so it's only given a new width when it really differs
+            mutable int m_layout_width = -1;
+            //unwrapped width, -1 when unknown
+            mutable int m_natural_width = -1;
+            //recent height for width requests
+            mutable std::vector<std::pair<int, int>> m_heights;
+            //layout width m_clip was made for
+            int m_clip_width = -1;
+
             void force_redraw();
+            void set_layout_width(int width) const;
+            int text_width(int allocated_width) const;
+            int height_for_width(int width) const;
+            //! font or scale changed
+            void invalidate_layout();
+            void update_clip();
 
         public:
             label(const Glib::ustring& text);
@@ -44,6 +61,14 @@ namespace widget {
             void on_selection(int from_x, int from_y, int to_x, int to_y);
             virtual Glib::ustring get_selection();
 
+            /**
+             * @brief Debug aid, times set_text() over typical chat
+             * messages and prints the result.
+             *
+             * Enabled by GTOX_DBG_LABEL_BENCH=<messages>.
+             */
+            static void benchmark();
+
         protected:
             virtual bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr);
 